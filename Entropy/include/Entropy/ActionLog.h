@@ -0,0 +1,247 @@
+/**
+ * @file Entropy/ActionLog.h
+ * @author Tomas Polasek
+ * @brief Append-only log of actions, sorted on demand.
+ */
+
+#ifndef ECS_FIT_ACTIONLOG_H
+#define ECS_FIT_ACTIONLOG_H
+
+#include <vector>
+
+#include "Types.h"
+#include "Util.h"
+#include "List.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Append-only log of actions. Actions are added to the
+     * end of the log in O(1), resolve sorts the log and
+     * keeps only the last action for each key ("last write wins").
+     * Actions are stored in fixed-size blocks, so appending
+     * and searching never moves them.
+     * Searching is done by binary search within the resolved
+     * prefix, by binary search through an index of the older
+     * unresolved actions and by linear search through the
+     * newest actions.
+     * The index consists of sorted runs, which are merged
+     * when a newer run grows as large as the older one, so
+     * there is a logarithmic number of runs and each indexed
+     * action is merged a logarithmic number of times.
+     * @tparam T Type of the action.
+     * @tparam Compare Compare functor, actions with equal
+     *   keys are considered the same.
+     * @tparam Allocator Type of the allocator.
+     */
+    template <typename T,
+              typename Compare = std::less<T>,
+              typename Allocator = ResourceAllocator<T>>
+    class ActionLog
+    {
+    private:
+        /**
+         * Iterator over the actions in the log.
+         * @tparam IsConst Is the iterated log constant?
+         */
+        template <bool IsConst>
+        class Iterator;
+    public:
+        using ListT = List<T, Allocator>;
+
+        using value_type = T;
+        using size_type = typename ListT::size_type;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        /**
+         * Maximal number of unindexed actions searched linearly,
+         * before they are added to the index.
+         */
+        static constexpr size_type MAX_LINEAR_SEARCH{64u};
+
+        /// Number of actions in a single block.
+        static constexpr size_type BLOCK_SIZE{128u};
+
+        iterator begin()
+        { return iterator(this, 0u); }
+        iterator end()
+        { return iterator(this, mSize); }
+        const_iterator begin() const
+        { return const_iterator(this, 0u); }
+        const_iterator end() const
+        { return const_iterator(this, mSize); }
+
+        /**
+         * Construct an empty log.
+         * @param cmp Compare functor.
+         * @param alloc Allocator used for the actions.
+         */
+        ActionLog(Compare cmp = {}, const Allocator &alloc = {}) :
+            mCmp{cmp}, mBlocks(BlockAllocator(alloc)), mIndex(IndexAllocator(alloc)),
+            mRuns(IndexAllocator(alloc)), mScratch(alloc), mSize{0u}, mSortedEnd{0u}, mIndexedEnd{0u}
+        { }
+
+        /// Number of actions in the log.
+        size_type size() const
+        { return mSize; }
+
+        /// Number of actions, which fit into the allocated memory.
+        size_type capacity() const
+        { return static_cast<size_type>(mBlocks.size()) * BLOCK_SIZE; }
+
+        /// Is the log empty?
+        bool empty() const
+        { return mSize == 0u; }
+
+        /// Is the whole log sorted and without duplicate keys?
+        bool resolved() const
+        { return mSortedEnd == mSize; }
+
+        /**
+         * Construct action at the end of the log.
+         * @tparam CArgTs Constructor argument types.
+         * @param cArgs Constructor arguments.
+         * @return Returns reference to the new action.
+         * @remarks Does NOT invalidate references.
+         */
+        template <typename... CArgTs>
+        inline reference append(CArgTs &&...cArgs);
+
+        /**
+         * Find the last action with given key.
+         * If there are too many unindexed actions, they
+         * are added to the index first.
+         * @tparam SearchT Type of the key.
+         * @param key Searched key.
+         * @return Returns ptr to the action, or nullptr
+         *   if there is no such action.
+         * @remarks Does NOT invalidate references.
+         */
+        template <typename SearchT>
+        inline T *findLast(const SearchT &key);
+
+        /**
+         * Sort the log, using stable sort, and keep
+         * only the last action for each key.
+         * @remarks Invalidates iterators and references.
+         */
+        inline void resolve();
+
+        /**
+         * Sort the log, using stable sort, and fold
+         * actions with the same key into a single action.
+         * @tparam FoldT Type of the fold functor.
+         * @param fold Functor called as fold(T &older, T &&newer)
+         *   for each following action with the same key, in
+         *   the order of appending.
+         * @remarks Invalidates iterators and references.
+         */
+        template <typename FoldT>
+        inline void resolve(FoldT fold);
+
+        /**
+         * Remove all actions for which the predicate
+         * returns true. Order of the actions is kept.
+         * @tparam PredT Type of the predicate.
+         * @param pred Predicate, called as pred(const T&).
+         * @remarks Invalidates iterators and references.
+         */
+        template <typename PredT>
+        inline void eraseIf(PredT pred);
+
+        /// Remove all actions, memory is kept.
+        inline void clear();
+
+        /// Remove all actions and free memory.
+        inline void reclaim();
+    private:
+        using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ListT>;
+        using IndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_type>;
+
+        /// Get action on given position.
+        T &at(size_type pos)
+        { return mBlocks[pos / BLOCK_SIZE][pos % BLOCK_SIZE]; }
+        const T &at(size_type pos) const
+        { return mBlocks[pos / BLOCK_SIZE][pos % BLOCK_SIZE]; }
+
+        /// Add the unindexed actions to the index, as a new run.
+        inline void updateIndex();
+
+        /// Get end of given run within the index.
+        size_type runEnd(size_type run) const
+        { return run + 1u < mRuns.size() ? mRuns[run + 1u] : static_cast<size_type>(mIndex.size()); }
+
+        /**
+         * Remove actions from the end of the log.
+         * @param size New number of actions.
+         */
+        inline void truncate(size_type size);
+
+        /// The compare functor.
+        Compare mCmp;
+        /// Blocks of actions, each has capacity of BLOCK_SIZE.
+        std::vector<ListT, BlockAllocator> mBlocks;
+        /// Positions of the indexed actions, runs are stably sorted by the key.
+        List<size_type, IndexAllocator> mIndex;
+        /// Beginnings of the sorted runs within the index, from the oldest.
+        List<size_type, IndexAllocator> mRuns;
+        /// Actions moved during resolve.
+        ListT mScratch;
+        /// Number of actions in the log.
+        size_type mSize;
+        /// Number of resolved actions at the beginning of the log.
+        size_type mSortedEnd;
+        /// Actions before this position are resolved, or indexed.
+        size_type mIndexedEnd;
+    protected:
+    }; // class ActionLog
+
+    template <typename T,
+              typename Compare,
+              typename Allocator>
+    template <bool IsConst>
+    class ActionLog<T, Compare, Allocator>::Iterator
+    {
+    public:
+        using LogT = std::conditional_t<IsConst, const ActionLog, ActionLog>;
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator(LogT *log, size_type pos) :
+            mLog{log}, mPos{pos}
+        { }
+
+        reference operator*() const
+        { return mLog->at(mPos); }
+        pointer operator->() const
+        { return &mLog->at(mPos); }
+
+        Iterator &operator++()
+        { ++mPos; return *this; }
+        Iterator operator++(int)
+        { Iterator result(*this); ++mPos; return result; }
+
+        bool operator==(const Iterator &other) const
+        { return mPos == other.mPos; }
+        bool operator!=(const Iterator &other) const
+        { return mPos != other.mPos; }
+    private:
+        /// Iterated log.
+        LogT *mLog;
+        /// Position within the log.
+        size_type mPos;
+    protected:
+    }; // class ActionLog::Iterator
+} // namespace ent
+
+#include "ActionLog.inl"
+
+#endif //ECS_FIT_ACTIONLOG_H
@@ -0,0 +1,244 @@
+/**
+ * @file Entropy/ActionLog.inl
+ * @author Tomas Polasek
+ * @brief Append-only log of actions, sorted on demand.
+ */
+
+#include "ActionLog.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    // ActionLog implementation.
+    template <typename T, typename C, typename A>
+    template <typename... CArgTs>
+    auto ActionLog<T, C, A>::append(CArgTs &&...cArgs) -> reference
+    {
+        const size_type block{mSize / BLOCK_SIZE};
+        if (block == mBlocks.size())
+        {
+            mBlocks.emplace_back(A(mBlocks.get_allocator()));
+        }
+        if (mBlocks[block].capacity() < BLOCK_SIZE)
+        { // Block is never reallocated, once used.
+            mBlocks[block].reserve(BLOCK_SIZE);
+        }
+
+        mBlocks[block].emplaceBack(std::forward<CArgTs>(cArgs)...);
+        mSize++;
+
+        return mBlocks[block].back();
+    }
+
+    template <typename T, typename C, typename A>
+    template <typename SearchT>
+    T *ActionLog<T, C, A>::findLast(const SearchT &key)
+    {
+        if (mSize - mIndexedEnd > MAX_LINEAR_SEARCH)
+        {
+            updateIndex();
+        }
+
+        // Newest actions first.
+        for (size_type pos = mSize; pos > mIndexedEnd; --pos)
+        {
+            T &action(at(pos - 1u));
+            if (!mCmp(key, action) && !mCmp(action, key))
+            {
+                return &action;
+            }
+        }
+
+        // Newer runs contain newer actions.
+        for (size_type run = static_cast<size_type>(mRuns.size()); run > 0u; --run)
+        {
+            auto runBegin = mIndex.begin() + mRuns[run - 1u];
+            // Actions with the same key are sorted from the oldest.
+            auto indexIt = std::upper_bound(runBegin, mIndex.begin() + runEnd(run - 1u), key,
+                [this] (const SearchT &k, size_type pos) {
+                    return mCmp(k, at(pos));
+                });
+            if (indexIt != runBegin && !mCmp(at(*(indexIt - 1)), key))
+            {
+                return &at(*(indexIt - 1));
+            }
+        }
+
+        size_type first{0u};
+        size_type count{mSortedEnd};
+        while (count > 0u)
+        { // Lower bound within the resolved prefix.
+            const size_type step{count / 2u};
+            if (mCmp(at(first + step), key))
+            {
+                first += step + 1u;
+                count -= step + 1u;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        return (first == mSortedEnd || mCmp(key, at(first))) ? nullptr : &at(first);
+    }
+
+    template <typename T, typename C, typename A>
+    void ActionLog<T, C, A>::updateIndex()
+    {
+        if (mIndexedEnd == mSize)
+        {
+            return;
+        }
+
+        const size_type oldSize{static_cast<size_type>(mIndex.size())};
+        for (size_type pos = mIndexedEnd; pos < mSize; ++pos)
+        {
+            mIndex.pushBack(pos);
+        }
+        mIndexedEnd = mSize;
+        mRuns.pushBack(oldSize);
+
+        auto cmp = [this] (size_type first, size_type second) {
+            return mCmp(at(first), at(second));
+        };
+        // Stable sort keeps the order of actions with the same key.
+        std::stable_sort(mIndex.begin() + oldSize, mIndex.end(), cmp);
+
+        while (mRuns.size() > 1u)
+        {
+            const size_type last{static_cast<size_type>(mRuns.size()) - 1u};
+            const size_type lastBegin{mRuns[last]};
+            const size_type prevBegin{mRuns[last - 1u]};
+            if (lastBegin - prevBegin > static_cast<size_type>(mIndex.size()) - lastBegin)
+            { // Older run is still larger.
+                break;
+            }
+
+            // Older run is first, so the merge stays stable.
+            std::inplace_merge(mIndex.begin() + prevBegin, mIndex.begin() + lastBegin,
+                               mIndex.end(), cmp);
+            mRuns.popBack();
+        }
+    }
+
+    template <typename T, typename C, typename A>
+    void ActionLog<T, C, A>::resolve()
+    {
+        // The last action wins.
+        resolve([] (T &older, T &&newer) {
+            older = std::move(newer);
+        });
+    }
+
+    template <typename T, typename C, typename A>
+    template <typename FoldT>
+    void ActionLog<T, C, A>::resolve(FoldT fold)
+    {
+        if (resolved())
+        {
+            return;
+        }
+
+        mIndex.clear();
+        mRuns.clear();
+        mIndexedEnd = 0u;
+        updateIndex();
+
+        // Fold actions for each key into the scratch List.
+        mScratch.clear();
+        mScratch.reserve(mSize);
+        for (auto it = mIndex.begin(); it != mIndex.end(); ++it)
+        {
+            if (it != mIndex.begin() && !mCmp(mScratch.back(), at(*it)))
+            { // Older action with the same key precedes.
+                fold(mScratch.back(), std::move(at(*it)));
+                continue;
+            }
+
+            mScratch.emplaceBack(std::move(at(*it)));
+        }
+
+        size_type write{0u};
+        for (T &action : mScratch)
+        {
+            at(write++) = std::move(action);
+        }
+        mScratch.clear();
+
+        truncate(write);
+        mIndex.clear();
+        mRuns.clear();
+        mSortedEnd = mSize;
+        mIndexedEnd = mSize;
+    }
+
+    template <typename T, typename C, typename A>
+    template <typename PredT>
+    void ActionLog<T, C, A>::eraseIf(PredT pred)
+    {
+        size_type write{0u};
+        size_type sortedEnd{0u};
+        for (size_type read = 0u; read < mSize; ++read)
+        {
+            if (pred(at(read)))
+            {
+                continue;
+            }
+
+            if (write != read)
+            {
+                at(write) = std::move(at(read));
+            }
+            ++write;
+
+            if (read < mSortedEnd)
+            {
+                sortedEnd++;
+            }
+        }
+
+        truncate(write);
+        mIndex.clear();
+        mRuns.clear();
+        mSortedEnd = sortedEnd;
+        mIndexedEnd = sortedEnd;
+    }
+
+    template <typename T, typename C, typename A>
+    void ActionLog<T, C, A>::clear()
+    {
+        for (ListT &block : mBlocks)
+        {
+            block.clear();
+        }
+        mIndex.clear();
+        mRuns.clear();
+        mSize = 0u;
+        mSortedEnd = 0u;
+        mIndexedEnd = 0u;
+    }
+
+    template <typename T, typename C, typename A>
+    void ActionLog<T, C, A>::reclaim()
+    {
+        mBlocks.clear();
+        mBlocks.shrink_to_fit();
+        mIndex.reclaim();
+        mRuns.reclaim();
+        mScratch.reclaim();
+        mSize = 0u;
+        mSortedEnd = 0u;
+        mIndexedEnd = 0u;
+    }
+
+    template <typename T, typename C, typename A>
+    void ActionLog<T, C, A>::truncate(size_type size)
+    {
+        while (mSize > size)
+        {
+            mBlocks[(mSize - 1u) / BLOCK_SIZE].popBack();
+            mSize--;
+        }
+    }
+    // ActionLog implementation end.
+} // namespace ent
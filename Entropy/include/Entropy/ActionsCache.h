@@ -7,21 +7,35 @@
 #ifndef ECS_FIT_ACTIONSCACHE_H
 #define ECS_FIT_ACTIONSCACHE_H
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "ChangeSet.h"
+#include "ThreadPool.h"
 
 /// Main Entropy namespace
 namespace ent
 {
     /**
      * Used as manager of change actions in threaded environment.
+     * Committed and recycled ChangeSets are kept in lock-free
+     * intrusive stacks, no lock is taken on commit.
      * @tparam UniverseT Type of the Universe.
      */
     template <typename UniverseT>
     class ActionsCache : NonCopyable
     {
     public:
+        /// Create empty ActionsCache.
+        ActionsCache();
+
+        /// Free all ChangeSets.
+        ~ActionsCache();
+
         /**
          * Get ChangeSet specific to current thread.
          * ChangeSets allow to store actions to be
@@ -33,16 +47,21 @@ namespace ent
 
         /**
          * Commit actions of the active thread.
+         * The thread continues with a recycled ChangeSet,
+         * if there is any.
+         * @remarks Is thread-safe and lock-free.
          */
         void commitChangeSet();
 
         /**
          * Reset actions of the active thread.
+         * Memory of the ChangeSet is kept.
          */
         void resetChangeSet();
 
         /**
          * Reset the ActionsCache.
+         * @remarks Not thread-safe!
          */
         void reset();
 
@@ -56,16 +75,115 @@ namespace ent
 
         /**
          * Apply committed ChangeSets from ActionsCache.
+         * Applied ChangeSets are cleared and kept for reuse.
+         * Entities are destroyed and created first, then
+         * actions for each Component type are applied. When
+         * there is enough work, each Component type is
+         * processed as a separate task on the thread pool.
+         * Holders and metadata columns of different Component
+         * types are disjoint, changed Entities are collected
+         * per Component type and merged at the end.
+         * ChangeSets are applied in the order of commits, or
+         * in the order of their keys, when the deterministic
+         * merge is enabled.
          * @param uni Universe instance.
+         * @return Returns the number of applied ChangeSets.
+         * @remarks Not thread-safe, should not be called while
+         *   other threads are committing.
+         */
+        u64 applyChangeSets(UniverseT *uni);
+
+        /**
+         * Enable or disable the deterministic merge. When
+         * enabled, committed ChangeSets are stable sorted
+         * by their keys before they are applied.
+         * @param enabled Should the merge be deterministic?
+         * @remarks Not thread-safe!
+         */
+        void setDeterministic(bool enabled)
+        { mDeterministic = enabled; }
+
+        /// Is the deterministic merge enabled?
+        bool deterministic() const
+        { return mDeterministic; }
+
+        /**
+         * Get base of the order keys for a parallel region
+         * started by the current thread. When the ChangeSet of
+         * the current thread already has a key, it is used as
+         * the base, so regions started by keyed tasks are
+         * ordered by the key of the task. Otherwise the region
+         * gets a new base, in the order regions are started.
+         * Keys of the region are then created by setting bits
+         * under KEY_REGION_SHIFT - tasks under KEY_TASK_SHIFT
+         * and chunks of the range in the lowest bits.
+         * @return Returns the base key.
+         * @remarks Is thread-safe.
          */
-        void applyChangeSets(UniverseT *uni);
+        u64 parallelKeyBase();
+
+        /**
+         * Run given function with the ChangeSet of the current
+         * thread keyed by given key. Actions already recorded by
+         * the current thread are committed before, actions of the
+         * function are committed after it returns. The original
+         * key is then restored, so the caller continues with
+         * the same key.
+         * Used by the parallel iteration and System scheduler,
+         * when the deterministic merge is enabled.
+         * @tparam FunT Type of the function.
+         * @param key Order key of the actions of the function.
+         * @param fun Function without parameters.
+         * @remarks Is thread-safe.
+         */
+        template <typename FunT>
+        void runKeyed(u64 key, FunT &&fun);
+
+        /// Shift of the region part of the order keys.
+        static constexpr u64 KEY_REGION_SHIFT{48u};
+        /// Shift of the task part of the order keys.
+        static constexpr u64 KEY_TASK_SHIFT{32u};
+
+        /**
+         * Fill memory used by the ChangeSets of all threads,
+         * committed and pooled ChangeSets and by the lists
+         * of changed Entities into given report.
+         * @param report Report filled with the usage.
+         * @remarks Not thread-safe, should not be called while
+         *   other threads are committing.
+         */
+        void memoryUsage(MemoryReport &report) const;
     private:
+        /// List of ChangeSets, in the order they are applied.
+        using ChangeSetList = std::vector<std::unique_ptr<ChangeSet>>;
+
         class ComponentExtractor
         {
         public:
-            virtual void addRemoveComponents(ComponentActions *ca,
-                                             const ent::List<EntityId> &tempMapping,
-                                             UniverseT *uni) = 0;
+            /**
+             * Apply Component actions from given ChangeSets to
+             * the Universe, conflicting writes are resolved by
+             * the merge policy of the Component.
+             * @param changeSets ChangeSets in the order of application.
+             * @param index Index of the Component type.
+             * @param uni Universe instance.
+             * @param changed Entities which changed their
+             *   Component composition are added to this list.
+             * @param written Entities written by the combining
+             *   merge policy, cleared afterwards.
+             */
+            virtual void applyActions(ChangeSetList &changeSets,
+                                      u64 index,
+                                      UniverseT *uni,
+                                      std::vector<EntityId> &changed,
+                                      ChangedEntities &written) = 0;
+
+            /**
+             * Get the number of actions.
+             * @param ca Actions for the Component type.
+             * @return Returns the number of actions.
+             */
+            virtual u64 numActions(ComponentActions *ca) = 0;
         private:
         protected:
         }; // class ComponentExtractor
@@ -74,13 +192,100 @@ namespace ent
         class ComponentExtractorSpec : public ComponentExtractor
         {
         public:
-            virtual void addRemoveComponents(ComponentActions *ca,
-                                             const ent::List<EntityId> &tempMapping,
-                                             UniverseT *uni) override final;
+            virtual void applyActions(ChangeSetList &changeSets,
+                                      u64 index,
+                                      UniverseT *uni,
+                                      std::vector<EntityId> &changed,
+                                      ChangedEntities &written) override final;
+
+            virtual u64 numActions(ComponentActions *ca) override final;
         private:
+            using PolicyT = typename MergePolicyExtractor<ComponentT>::type;
+
+            /// Cast to the correct specialization.
+            static inline ComponentActionsSpec<ComponentT> *spec(ComponentActions *ca);
+
+            /**
+             * Apply Component actions of a single ChangeSet.
+             * @param ca Actions for the Component type.
+             * @param tempMapping Mapping of temporary Entities.
+             * @param uni Universe instance.
+             * @param changed Entities which changed their
+             *   Component composition are added to this list.
+             * @param written Entities written by the combining
+             *   merge policy.
+             */
+            static inline void addRemoveComponents(ComponentActions *ca,
+                                                   const ent::List<EntityId> &tempMapping,
+                                                   UniverseT *uni,
+                                                   std::vector<EntityId> &changed,
+                                                   ChangedEntities &written);
+
+            /**
+             * Apply a single Component action, the last
+             * write wins.
+             * @param id ID of the Entity.
+             * @param cc The action.
+             * @param uni Universe instance.
+             * @param written Unused.
+             * @param policy Merge policy tag.
+             * @return Returns true, if the Component
+             *   composition of the Entity changed.
+             */
+            template <typename P>
+            static inline bool applyChange(EntityId id, ComponentChange<ComponentT> &cc,
+                                           UniverseT *uni, ChangedEntities &written, P policy);
+
+            /**
+             * Apply a single Component action, writes
+             * to already written Component are combined.
+             * @param id ID of the Entity.
+             * @param cc The action.
+             * @param uni Universe instance.
+             * @param written Entities already written.
+             * @param policy Merge policy tag.
+             * @return Returns true, if the Component
+             *   composition of the Entity changed.
+             */
+            template <typename CombineT>
+            static inline bool applyChange(EntityId id, ComponentChange<ComponentT> &cc,
+                                           UniverseT *uni, ChangedEntities &written,
+                                           MergeCombine<CombineT> policy);
         protected:
         }; // class ComponentExtractorSpec
 
+        /**
+         * Apply actions for Component with given index
+         * from all committed ChangeSets.
+         * @param index Index of the Component type.
+         * @param uni Universe instance.
+         */
+        inline void applyComponentActions(u64 index, UniverseT *uni);
+
+        /**
+         * Get a cleared ChangeSet from the pool.
+         * The whole pool is taken at once, which prevents
+         * the ABA problem, the rest is returned afterwards.
+         * @return Returns ptr to the ChangeSet, or nullptr
+         *   if the pool is empty.
+         */
+        inline ChangeSet *recycledChangeSet();
+
+        /**
+         * Push a chain of ChangeSets, linked using ChangeSet::next,
+         * to given intrusive stack.
+         * @param stack Head of the stack.
+         * @param first First ChangeSet of the chain.
+         * @param last Last ChangeSet of the chain.
+         */
+        static inline void pushChain(std::atomic<ChangeSet*> &stack, ChangeSet *first, ChangeSet *last);
+
+        /**
+         * Delete all ChangeSets in given intrusive stack.
+         * @param stack Head of the stack.
+         */
+        static inline void deleteChain(std::atomic<ChangeSet*> &stack);
+
         template <typename ComponentT>
         ComponentExtractorSpec<ComponentT> &extractorGetter()
         {
@@ -88,59 +293,184 @@ namespace ent
             return extr;
         }
 
+        /// Actions of a single thread.
+        struct ThreadActions
+        {
+            /// Owner of the actions.
+            std::thread::id thread;
+            /// ChangeSet currently used by the thread.
+            ActionsContainer actions;
+        }; // struct ThreadActions
+
+        /// Actions cached for the current thread.
+        struct ThreadCache
+        {
+            /// Identifier of the ActionsCache owning the actions.
+            u64 owner;
+            /// The actions.
+            ActionsContainer *actions;
+        }; // struct ThreadCache
+
+        /// Get actions cached by the current thread.
+        static ThreadCache &threadCache()
+        {
+            static thread_local ThreadCache cache{0u, nullptr};
+            return cache;
+        }
+
+        /// Get unique identifier for a new ActionsCache.
+        static u64 nextId()
+        {
+            static std::atomic<u64> counter{0u};
+            return ++counter;
+        }
+
         /**
-         * Actions storage specific to each thread
-         * and Universe type.
+         * Find or create actions of the current thread.
+         * Each instance has its own actions, so threads can
+         * work with multiple Universes of the same type.
+         * @return Returns the actions.
          */
-        static thread_local ActionsContainer tActions;
+        inline ActionsContainer &threadActions();
+
+        /// Unique identifier of this instance, changes on reset.
+        u64 mId;
+        /// Resource used for the ChangeSets.
+        MemoryResource *mMemory;
+        /// Lock for the list of thread actions.
+        mutable std::mutex mThreadActionsMutex;
+        /// Actions of all threads, which used this instance.
+        std::vector<std::unique_ptr<ThreadActions>> mThreadActions;
 
-        /// Mutex used for locking access to mCommittedChanges.
-        std::mutex mCommitMutex;
-        /// List of ChangeSets which were committed for the next refresh.
-        std::vector<std::unique_ptr<ChangeSet>> mCommittedChanges;
+        /// Intrusive stack of committed ChangeSets, newest first.
+        std::atomic<ChangeSet*> mCommitted;
+        /// ChangeSets taken from mCommitted, in order of commits.
+        ChangeSetList mCommittedChanges;
+        /// Intrusive stack of cleared ChangeSets, ready for reuse.
+        std::atomic<ChangeSet*> mFree;
+        /// Approximate number of ChangeSets in mFree.
+        std::atomic<u64> mNumFree;
         /// List of registered Component extractors.
         std::vector<ComponentExtractor*> mRegisteredExtractors;
+        /// Changed Entities for each Component type, kept between refreshes.
+        std::vector<std::vector<EntityId>> mChangedPerComponent;
+        /// Entities written for each Component type, used by the combining policy.
+        std::vector<ChangedEntities> mWrittenPerComponent;
+        /// Are ChangeSets applied in the order of their keys?
+        bool mDeterministic;
+        /// Number of parallel regions started since the last apply.
+        std::atomic<u64> mNumRegions;
     protected:
     }; // class ActionsCache
 
-    /// List of changed Entity IDs for each thread.
+    /**
+     * Changed Entity IDs of a single Universe. Each thread
+     * appends to its own List, the Lists are merged using
+     * k-way merge on refresh.
+     */
     template <typename UniverseT>
     class ChangedEntitiesHolder : NonCopyable
     {
     public:
-        /// Create the list and register it.
+        /// Create holder without any thread lists.
         ChangedEntitiesHolder();
 
-        /// Mark the list pointer for removal.
+        /// Free all thread lists.
         ~ChangedEntitiesHolder();
 
-        /// Remove all lists marked for removal.
-        inline void refresh();
-
-        /// Reset the list of change lists.
+        /**
+         * Free all thread lists and the result.
+         * @remarks Not thread-safe!
+         */
         inline void reset();
 
-        /// Add the entity ID to the thread list.
+        /**
+         * Add the entity ID to the list of the current thread.
+         * @param id ID of the Entity.
+         * @remarks Is thread-safe.
+         */
         inline void entityChanged(EntityId id);
 
-        /// Create the resulting list and return it.
-        inline SortedList<EntityId> &createResultList();
+        /**
+         * Merge lists of all threads into a sorted list without
+         * duplicates. Large lists are merged in parallel, each
+         * worker merges a range of Entity IDs.
+         * Thread lists are cleared afterwards.
+         * The result, the new thread lists and all temporary
+         * lists are allocated from given frame resource.
+         * @param pool Pool used for parallel merging.
+         * @param frame Resource of the current frame, when nullptr,
+         *   resource of this holder is used instead.
+         * @return Returns the merged list, valid until the next call.
+         * @remarks Not thread-safe!
+         */
+        inline SortedList<EntityId> &createResultList(ThreadPool &pool, MemoryResource *frame = nullptr);
     private:
-        /// Register given list.
-        inline void registerList(SortedList<EntityId> *list);
+        /// List of changed Entities of a single thread.
+        struct ThreadList
+        {
+            /// Owner of the list.
+            std::thread::id thread;
+            /// Changed Entities, unsorted and with duplicates.
+            List<EntityId> changed;
+        }; // struct ThreadList
+
+        /// List cached for the current thread.
+        struct ThreadCache
+        {
+            /// Identifier of the holder owning the list.
+            u64 owner;
+            /// The list.
+            List<EntityId> *list;
+        }; // struct ThreadCache
 
-        /// Unregister given list.
-        inline void unregisterList(SortedList<EntityId> *list);
+        /// Range of sorted Entity IDs.
+        using RangeT = std::pair<const EntityId*, const EntityId*>;
+
+        /// Temporary vector allocated from the frame resource.
+        template <typename VT>
+        using FrameVectorT = std::vector<VT, ResourceAllocator<VT>>;
+
+        /// Get list cached by the current thread.
+        static ThreadCache &threadCache()
+        {
+            static thread_local ThreadCache cache{0u, nullptr};
+            return cache;
+        }
 
-        /// List of changed Entities since the last refresh.
-        SortedList<EntityId> *mChangedEntities;
+        /// Get unique identifier for a new holder.
+        static u64 nextId()
+        {
+            static std::atomic<u64> counter{0u};
+            return ++counter;
+        }
+
+        /**
+         * Find or create list of the current thread.
+         * @return Returns the list.
+         */
+        inline List<EntityId> &threadList();
+
+        /**
+         * Merge sorted ranges into given List, using
+         * binary heap. Duplicate IDs are skipped.
+         * @param ranges Merged ranges, they are consumed.
+         * @param out Output List.
+         */
+        static inline void mergeRanges(FrameVectorT<RangeT> &ranges, List<EntityId> &out);
 
-        /// Mutex for the list of change lists.
-        static std::mutex sChangesMutex;
-        /// Holding the list of all active change lists.
-        static std::vector<std::pair<std::unique_ptr<SortedList<EntityId>>, bool>> sChanges;
+        /// Unique identifier of this holder, changes on reset.
+        u64 mId;
+        /// Resource used for the thread lists.
+        MemoryResource *mMemory;
+        /// Lock for the list of thread lists.
+        std::mutex mListsMutex;
+        /// Lists of all threads, which changed any Entities.
+        std::vector<std::unique_ptr<ThreadList>> mLists;
+        /// Output of the parallel merge, one for each range of IDs.
+        std::vector<List<EntityId>> mPartitions;
         /// Result of merging of the individual change lists.
-        static SortedList<EntityId> sResultList;
+        SortedList<EntityId> mResultList;
     protected:
     }; // class ChangeEntitiesHolder
 } // namespace ent
@@ -11,48 +11,159 @@ namespace ent
 {
     // ActionsCache implementation.
     template <typename UniverseT>
-    thread_local ActionsContainer ActionsCache<UniverseT>::tActions;
+    ActionsCache<UniverseT>::ActionsCache() :
+        mId{nextId()}, mMemory{MemoryResource::current()}, mCommitted{nullptr}, mFree{nullptr}, mNumFree{0u},
+        mDeterministic{false}, mNumRegions{0u}
+    { }
+
+    template <typename UniverseT>
+    ActionsCache<UniverseT>::~ActionsCache()
+    { reset(); }
 
     template <typename UniverseT>
     ChangeSet &ActionsCache<UniverseT>::changeSet()
     {
-        return tActions.currentChangeSet();
+        return threadActions().currentChangeSet();
     }
 
     template <typename UniverseT>
     void ActionsCache<UniverseT>::commitChangeSet()
     {
-        std::lock_guard<std::mutex> lg(mCommitMutex);
-        mCommittedChanges.emplace_back(tActions.releaseChangeSet());
+        ChangeSet *cs{threadActions().releaseChangeSet(recycledChangeSet())};
+        // Sort the actions on the committing thread.
+        cs->finalize();
+
+        pushChain(mCommitted, cs, cs);
+    }
+
+    template <typename UniverseT>
+    u64 ActionsCache<UniverseT>::parallelKeyBase()
+    {
+        const u64 current{changeSet().key()};
+        if (current)
+        {
+            return current;
+        }
+
+        return (mNumRegions.fetch_add(1u, std::memory_order_relaxed) + 1u) << KEY_REGION_SHIFT;
+    }
+
+    template <typename UniverseT>
+    template <typename FunT>
+    void ActionsCache<UniverseT>::runKeyed(u64 key, FunT &&fun)
+    {
+        const u64 outer{changeSet().key()};
+        // Actions recorded before keep their original key.
+        commitChangeSet();
+
+        changeSet().setKey(key);
+        fun();
+        commitChangeSet();
+
+        changeSet().setKey(outer);
     }
 
     template <typename UniverseT>
     void ActionsCache<UniverseT>::resetChangeSet()
     {
-        // Take care of the returned pointer.
-        delete tActions.releaseChangeSet();
+        threadActions().currentChangeSet().clear();
     }
 
     template <typename UniverseT>
     void ActionsCache<UniverseT>::reset()
     {
-        std::lock_guard<std::mutex> lg(mCommitMutex);
+        {
+            std::lock_guard<std::mutex> g(mThreadActionsMutex);
+
+            // Actions cached by the threads are no longer valid.
+            mId = nextId();
+            mThreadActions.clear();
+        }
+
+        deleteChain(mCommitted);
         mCommittedChanges.clear();
+        deleteChain(mFree);
+        mNumFree = 0u;
         mRegisteredExtractors.clear();
+        mChangedPerComponent.clear();
+        mWrittenPerComponent.clear();
+        mDeterministic = false;
+        mNumRegions = 0u;
+    }
+
+    template <typename UniverseT>
+    void ActionsCache<UniverseT>::memoryUsage(MemoryReport &report) const
+    {
+        report.changeSets = MemoryUsage{};
+        report.pendingChangeSets = 0u;
+        report.pooledChangeSets = 0u;
+
+        {
+            std::lock_guard<std::mutex> g(mThreadActionsMutex);
+            for (const std::unique_ptr<ThreadActions> &ta : mThreadActions)
+            {
+                report.changeSets += ta->actions.currentChangeSet().memoryUsage();
+            }
+        }
+
+        for (const ChangeSet *cs = mCommitted.load(std::memory_order_acquire); cs; cs = cs->next())
+        {
+            report.changeSets += cs->memoryUsage();
+            report.pendingChangeSets++;
+        }
+        for (const std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
+        {
+            report.changeSets += cs->memoryUsage();
+            report.pendingChangeSets++;
+        }
+        for (const ChangeSet *cs = mFree.load(std::memory_order_acquire); cs; cs = cs->next())
+        {
+            report.changeSets += cs->memoryUsage();
+            report.pooledChangeSets++;
+        }
+
+        for (const std::vector<EntityId> &changed : mChangedPerComponent)
+        {
+            report.changedLists += MemoryUsage::ofList(changed);
+        }
+        for (const ChangedEntities &written : mWrittenPerComponent)
+        {
+            report.changedLists += written.memoryUsage();
+        }
     }
 
     template <typename UniverseT>
     template <typename ComponentT>
-    void ActionsCache<UniverseT>::registerComponent(u64 cId)
+    void ActionsCache<UniverseT>::registerComponent(u64 /*cId*/)
     {
         mRegisteredExtractors.push_back(&extractorGetter<ComponentT>());
     }
 
     template <typename UniverseT>
-    void ActionsCache<UniverseT>::applyChangeSets(UniverseT *uni)
+    u64 ActionsCache<UniverseT>::applyChangeSets(UniverseT *uni)
     {
-        // TODO - optimize, parallelize.
-        std::lock_guard<std::mutex> lg(mCommitMutex);
+        // Take all of the committed ChangeSets, newest first.
+        ChangeSet *committed{mCommitted.exchange(nullptr, std::memory_order_acquire)};
+        const u64 firstNew{mCommittedChanges.size()};
+        for (ChangeSet *cs = committed; cs; )
+        {
+            ChangeSet *next{cs->next()};
+            cs->next() = nullptr;
+            mCommittedChanges.emplace_back(cs);
+            cs = next;
+        }
+        // Restore the order of commits.
+        std::reverse(mCommittedChanges.begin() + firstNew, mCommittedChanges.end());
+        // Region keys are unique only within a single refresh.
+        mNumRegions.store(0u, std::memory_order_relaxed);
+
+        if (mDeterministic)
+        { // Stable sort keeps the order of commits for equal keys.
+            std::stable_sort(mCommittedChanges.begin(), mCommittedChanges.end(),
+                [] (const std::unique_ptr<ChangeSet> &first, const std::unique_ptr<ChangeSet> &second) {
+                    return first->key() < second->key();
+                });
+        }
 
         // Destroy Entities.
         for (std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
@@ -76,20 +187,51 @@ namespace ent
         }
 
         // Remove / add Components.
-        for (std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
+        mChangedPerComponent.resize(mRegisteredExtractors.size());
+        mWrittenPerComponent.resize(mRegisteredExtractors.size());
+        u64 numActions{0u};
+        u64 numTypes{0u};
+        for (u64 index = 0; index < mRegisteredExtractors.size(); ++index)
         {
-            for (u64 index = 0;
-                 index < cs->components().size() && index < mRegisteredExtractors.size();
-                 ++index)
+            u64 typeActions{0u};
+            for (std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
             {
-                if (cs->components()[index])
+                if (index < cs->components().size() && cs->components()[index])
+                {
+                    typeActions += mRegisteredExtractors[index]->numActions(cs->components()[index]);
+                }
+            }
+            numActions += typeActions;
+            numTypes += typeActions ? 1u : 0u;
+        }
+
+        if (numTypes > 1u && numActions >= ENT_PARALLEL_APPLY_THRESHOLD)
+        { // Each Component type has its own Holder and metadata column.
+            uni->threadPool().parallelFor(0u, mRegisteredExtractors.size(), 1u, [&] (u64 begin, u64 end) {
+                for (u64 index = begin; index < end; ++index)
                 {
-                    mRegisteredExtractors[index]->addRemoveComponents(cs->components()[index],
-                                                                      cs->temporaryEntityMapper(), uni);
+                    applyComponentActions(index, uni);
                 }
+            });
+        }
+        else
+        {
+            for (u64 index = 0; index < mRegisteredExtractors.size(); ++index)
+            {
+                applyComponentActions(index, uni);
             }
         }
 
+        // Add to changed list.
+        for (std::vector<EntityId> &changed : mChangedPerComponent)
+        {
+            for (EntityId id : changed)
+            {
+                uni->entityChanged(id);
+            }
+            changed.clear();
+        }
+
         // Change metadata.
         for (std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
         {
@@ -108,173 +250,438 @@ namespace ent
             }
         }
 
+        // Keep the memory for the next frame.
+        for (std::unique_ptr<ChangeSet> &cs : mCommittedChanges)
+        {
+            if (mNumFree.load(std::memory_order_relaxed) < ENT_CHANGESET_POOL_SIZE)
+            {
+                cs->clear();
+                ChangeSet *recycled{cs.release()};
+                mNumFree.fetch_add(1u, std::memory_order_relaxed);
+                pushChain(mFree, recycled, recycled);
+            }
+        }
+        const u64 numApplied{mCommittedChanges.size()};
         mCommittedChanges.clear();
+
+        return numApplied;
+    }
+
+    template <typename UniverseT>
+    ChangeSet *ActionsCache<UniverseT>::recycledChangeSet()
+    {
+        ChangeSet *result{mFree.exchange(nullptr, std::memory_order_acquire)};
+        if (!result)
+        {
+            return nullptr;
+        }
+        mNumFree.fetch_sub(1u, std::memory_order_relaxed);
+
+        ChangeSet *rest{result->next()};
+        result->next() = nullptr;
+        if (rest)
+        { // Return the rest of the pool.
+            ChangeSet *last{rest};
+            while (last->next())
+            {
+                last = last->next();
+            }
+            pushChain(mFree, rest, last);
+        }
+
+        return result;
+    }
+
+    template <typename UniverseT>
+    void ActionsCache<UniverseT>::pushChain(std::atomic<ChangeSet*> &stack, ChangeSet *first, ChangeSet *last)
+    {
+        ChangeSet *head{stack.load(std::memory_order_relaxed)};
+        do
+        {
+            last->next() = head;
+        } while (!stack.compare_exchange_weak(head, first,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    template <typename UniverseT>
+    void ActionsCache<UniverseT>::deleteChain(std::atomic<ChangeSet*> &stack)
+    {
+        ChangeSet *cs{stack.exchange(nullptr, std::memory_order_acquire)};
+        while (cs)
+        {
+            ChangeSet *next{cs->next()};
+            delete cs;
+            cs = next;
+        }
+    }
+
+    template <typename UniverseT>
+    void ActionsCache<UniverseT>::applyComponentActions(u64 index, UniverseT *uni)
+    {
+        mRegisteredExtractors[index]->applyActions(mCommittedChanges, index, uni,
+                                                   mChangedPerComponent[index],
+                                                   mWrittenPerComponent[index]);
+    }
+
+    template <typename UniverseT>
+    template <typename ComponentT>
+    ComponentActionsSpec<ComponentT> *ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
+        spec(ComponentActions *ca)
+    {
+        return ENT_CHOOSE_DEBUG(
+            dynamic_cast<ComponentActionsSpec<ComponentT>*>(ca),
+            static_cast<ComponentActionsSpec<ComponentT>*>(ca)
+        );
+    }
+
+    template <typename UniverseT>
+    template <typename ComponentT>
+    u64 ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
+        numActions(ComponentActions *ca)
+    {
+        ComponentActionsSpec<ComponentT> *actions{spec(ca)};
+        return actions->added().size() + actions->tempAdded().size();
     }
 
     template <typename UniverseT>
     template <typename ComponentT>
     void ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
-        addRemoveComponents(ComponentActions *ca, const ent::List<EntityId> &tempMapping, UniverseT *uni)
+        applyActions(ChangeSetList &changeSets, u64 index, UniverseT *uni,
+                     std::vector<EntityId> &changed, ChangedEntities &written)
     {
-        ComponentActionsSpec<ComponentT> *actions{
-            ENT_CHOOSE_DEBUG(
-                dynamic_cast<ComponentActionsSpec<ComponentT>*>(ca),
-                static_cast<ComponentActionsSpec<ComponentT>*>(ca)
-        )};
+        auto apply = [&] (ChangeSet &cs) {
+            if (index < cs.components().size() && cs.components()[index])
+            {
+                addRemoveComponents(cs.components()[index], cs.temporaryEntityMapper(),
+                                    uni, changed, written);
+            }
+        };
 
-        for (const ComponentChange<ComponentT> &cc : actions->added())
+        if (std::is_same<PolicyT, MergeFirstWriter>::value)
+        { // The first action is applied last, so it wins.
+            for (auto it = changeSets.rbegin(); it != changeSets.rend(); ++it)
+            {
+                apply(**it);
+            }
+        }
+        else
+        {
+            for (std::unique_ptr<ChangeSet> &cs : changeSets)
+            {
+                apply(*cs);
+            }
+        }
+
+        written.clear();
+    }
+
+    template <typename UniverseT>
+    template <typename ComponentT>
+    void ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
+        addRemoveComponents(ComponentActions *ca, const ent::List<EntityId> &tempMapping,
+                            UniverseT *uni, std::vector<EntityId> &changed,
+                            ChangedEntities &written)
+    {
+        ComponentActionsSpec<ComponentT> *actions{spec(ca)};
+        // Written Entities are part of the recorded delta and views.
+        const bool record{uni->trackingWrites()};
+
+        // Components are moved out of the log, it is cleared afterwards.
+        for (ComponentChange<ComponentT> &cc : actions->added())
         {
             ENT_ASSERT_SLOW(!cc.id.isTemp());
             // TODO - Find a way to assure that only valid Entities get here.
             if (uni->entityValid(cc.id))
             { // If the Entity still exists.
-                if (cc.remove)
-                {
-                    uni->template removeComponent<ComponentT>(cc.id);
-                }
-                else
+                if (applyChange(cc.id, cc, uni, written, PolicyT()) || record)
                 {
-                    uni->template replaceComponent<ComponentT>(cc.id, cc.comp);
+                    changed.push_back(cc.id);
                 }
             }
         }
 
-        for (const ComponentChange<ComponentT> &cc : actions->tempAdded())
+        for (ComponentChange<ComponentT> &cc : actions->tempAdded())
         {
             ENT_ASSERT_SLOW(cc.id.isTemp());
             EntityId realId{tempMapping[cc.id.index()]};
             if (!realId.isTemp())
             {
-                if (cc.remove)
-                {
-                    uni->template removeComponent<ComponentT>(realId);
-                }
-                else
+                if (applyChange(realId, cc, uni, written, PolicyT()) || record)
                 {
-                    uni->template replaceComponent<ComponentT>(realId, cc.comp);
+                    changed.push_back(realId);
                 }
             }
         }
     }
-    // ActionsCache implementation end.
 
-    // ChangedEntitiesHolder implementation.
-    template <typename UT>
-    std::mutex ChangedEntitiesHolder<UT>::sChangesMutex;
-    template <typename UT>
-    std::vector<std::pair<std::unique_ptr<SortedList<EntityId>>, bool>>
-        ChangedEntitiesHolder<UT>::sChanges;
-    template <typename UT>
-    SortedList<EntityId> ChangedEntitiesHolder<UT>::sResultList;
+    template <typename UniverseT>
+    template <typename ComponentT>
+    template <typename P>
+    bool ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
+        applyChange(EntityId id, ComponentChange<ComponentT> &cc, UniverseT *uni,
+                    ChangedEntities &/*written*/, P /*policy*/)
+    {
+        return cc.remove ?
+               uni->template removeComponentImpl<ComponentT>(id) :
+               uni->template replaceComponentImpl<ComponentT>(id, std::move(cc.comp));
+    }
 
-    template <typename UT>
-    ChangedEntitiesHolder<UT>::ChangedEntitiesHolder()
+    template <typename UniverseT>
+    template <typename ComponentT>
+    template <typename CombineT>
+    bool ActionsCache<UniverseT>::ComponentExtractorSpec<ComponentT>::
+        applyChange(EntityId id, ComponentChange<ComponentT> &cc, UniverseT *uni,
+                    ChangedEntities &written, MergeCombine<CombineT> /*policy*/)
     {
-        mChangedEntities = new SortedList<EntityId>;
-        registerList(mChangedEntities);
+        if (cc.remove)
+        { // Following write starts from scratch.
+            return uni->template removeComponentImpl<ComponentT>(id);
+        }
+
+        ComponentT *current{written.contains(id) ?
+                            uni->template presentComponentImpl<ComponentT>(id) :
+                            nullptr};
+        if (current)
+        { // Component has already been written during this refresh.
+            CombineT()(*current, std::move(cc.comp));
+            return false;
+        }
+
+        written.entityChanged(id);
+        return uni->template replaceComponentImpl<ComponentT>(id, std::move(cc.comp));
     }
 
-    template <typename UT>
-    ChangedEntitiesHolder<UT>::~ChangedEntitiesHolder()
+    template <typename UniverseT>
+    ActionsContainer &ActionsCache<UniverseT>::threadActions()
     {
-        if (mChangedEntities)
+        ThreadCache &cache(threadCache());
+        if (cache.owner == mId)
         {
-            unregisterList(mChangedEntities);
+            return *cache.actions;
+        }
+
+        std::lock_guard<std::mutex> g(mThreadActionsMutex);
+
+        const std::thread::id thisThread{std::this_thread::get_id()};
+        auto findIt = std::find_if(mThreadActions.begin(), mThreadActions.end(),
+            [&] (const std::unique_ptr<ThreadActions> &ta) {
+                return ta->thread == thisThread;
+            });
+
+        if (findIt == mThreadActions.end())
+        { // First action from this thread.
+            MemoryScope scope(mMemory);
+            mThreadActions.emplace_back(new ThreadActions{thisThread, {}});
+            findIt = mThreadActions.end() - 1u;
         }
+
+        cache.owner = mId;
+        cache.actions = &(*findIt)->actions;
+
+        return *cache.actions;
     }
+    // ActionsCache implementation end.
+
+    // ChangedEntitiesHolder implementation.
+    template <typename UT>
+    ChangedEntitiesHolder<UT>::ChangedEntitiesHolder() :
+        mId{nextId()}, mMemory{MemoryResource::current()}
+    { }
 
     template <typename UT>
-    void ChangedEntitiesHolder<UT>::refresh()
-    {
-        std::lock_guard<std::mutex> g(sChangesMutex);
-
-        /*
-         * Delete the lists marked for removal, but
-         * call delete on them first.
-         */
-        sChanges.erase(std::remove_if(sChanges.begin(),
-                                      sChanges.end(),
-            [] (std::pair<std::unique_ptr<SortedList<EntityId>>, bool> &p)
-                                      {
-                                          /*
-                                          if (p.second)
-                                          {
-                                              delete p.first;
-                                          }
-                                           */
-                                          return p.second;
-                                      }
-        ), sChanges.end());
-    }
+    ChangedEntitiesHolder<UT>::~ChangedEntitiesHolder()
+    { }
 
     template <typename UT>
     void ChangedEntitiesHolder<UT>::reset()
     {
-        std::lock_guard<std::mutex> g(sChangesMutex);
-
-        for (auto &p : sChanges)
-        { // Clear the individual lists.
-            p.first->reclaim();
-        }
-        // TODO - What about the registered lists?
+        std::lock_guard<std::mutex> g(mListsMutex);
 
-        sResultList.reclaim();
+        // Lists cached by the threads are no longer valid.
+        mId = nextId();
+        mLists.clear();
+        mPartitions.clear();
+        mResultList.reclaim();
     }
 
     template <typename UT>
     void ChangedEntitiesHolder<UT>::entityChanged(EntityId id)
-    { mChangedEntities->insertUnique(id); }
+    { threadList().pushBack(id); }
 
     template <typename UT>
-    SortedList<EntityId> &ChangedEntitiesHolder<UT>::createResultList()
+    SortedList<EntityId> &ChangedEntitiesHolder<UT>::createResultList(ThreadPool &pool, MemoryResource *frame)
     {
-        std::lock_guard<std::mutex> g(sChangesMutex);
+        if (!frame)
+        {
+            frame = mMemory;
+        }
 
-        sResultList.clear();
+        FrameVectorT<ThreadList*> lists(frame);
+        {
+            std::lock_guard<std::mutex> g(mListsMutex);
+            for (std::unique_ptr<ThreadList> &tl : mLists)
+            {
+                lists.push_back(tl.get());
+            }
+        }
 
-        if (sChanges.size())
+        // Number of changes of each thread, used as a capacity hint.
+        FrameVectorT<u64> numChanges(frame);
+        for (ThreadList *tl : lists)
         {
-            // Get the content of the first list.
-            sResultList = (*(sChanges[0].first));
+            numChanges.push_back(tl->changed.size());
+        }
+
+        // Sort each thread list and remove the duplicates.
+        pool.parallelFor(0u, lists.size(), 1u, [&] (u64 begin, u64 end) {
+            for (u64 index = begin; index < end; ++index)
+            {
+                List<EntityId> &list(lists[index]->changed);
+                std::sort(list.begin(), list.end());
+                list.resize(static_cast<u64>(std::unique(list.begin(), list.end()) - list.begin()));
+            }
+        });
 
-            // TODO - optimized implementation.
-            for (u64 iii = 1; iii < sChanges.size(); ++iii)
-            { // Merge the rest into it.
-                for (EntityId id : (*sChanges[iii].first))
+        FrameVectorT<RangeT> ranges(frame);
+        const List<EntityId> *largest{nullptr};
+        u64 total{0u};
+        for (ThreadList *tl : lists)
+        {
+            if (tl->changed.size())
+            {
+                ranges.emplace_back(tl->changed.begin(), tl->changed.end());
+                total += tl->changed.size();
+                if (!largest || largest->size() < tl->changed.size())
                 {
-                    sResultList.insertUnique(id);
+                    largest = &tl->changed;
                 }
             }
+        }
+
+        // Result of the last refresh stays in the previous frame.
+        SortedList<EntityId>(List<EntityId>(frame)).swap(mResultList);
+        List<EntityId> result(frame);
+        result.reserve(total);
 
-            // Clear the individual lists.
-            for (auto &p : sChanges)
+        const u64 numParts{(ranges.size() > 1u && total >= ENT_PARALLEL_MERGE_THRESHOLD) ?
+                           pool.numWorkers() + 1u : 1u};
+        if (numParts == 1u)
+        {
+            mergeRanges(ranges, result);
+        }
+        else
+        { // Split the IDs into ranges, using the largest list as a sample.
+            FrameVectorT<EntityId> splitters(frame);
+            for (u64 part = 1u; part < numParts; ++part)
             {
-                p.first->clear();
+                splitters.push_back((*largest)[part * largest->size() / numParts]);
             }
+
+            mPartitions.resize(numParts);
+            pool.parallelFor(0u, numParts, 1u, [&] (u64 begin, u64 end) {
+                for (u64 part = begin; part < end; ++part)
+                {
+                    FrameVectorT<RangeT> partRanges(frame);
+                    for (const RangeT &r : ranges)
+                    {
+                        partRanges.emplace_back(
+                            part == 0u ? r.first : std::lower_bound(r.first, r.second, splitters[part - 1u]),
+                            part == numParts - 1u ? r.second : std::lower_bound(r.first, r.second, splitters[part]));
+                    }
+
+                    List<EntityId>(frame).swap(mPartitions[part]);
+                    mergeRanges(partRanges, mPartitions[part]);
+                }
+            });
+
+            // Ranges are disjoint, so the partitions can be just concatenated.
+            for (List<EntityId> &partition : mPartitions)
+            {
+                result.insert(result.end(), partition.begin(), partition.end());
+            }
+        }
+
+        mResultList.fromSortedList(std::move(result));
+
+        // Start new lists in the current frame.
+        for (u64 index = 0u; index < lists.size(); ++index)
+        {
+            List<EntityId> changed(frame);
+            changed.reserve(numChanges[index]);
+            changed.swap(lists[index]->changed);
         }
 
-        return sResultList;
+        return mResultList;
     }
 
     template <typename UT>
-    void ChangedEntitiesHolder<UT>::registerList(SortedList<EntityId> *list)
+    List<EntityId> &ChangedEntitiesHolder<UT>::threadList()
     {
-        std::lock_guard<std::mutex> g(sChangesMutex);
+        ThreadCache &cache(threadCache());
+        if (cache.owner == mId)
+        {
+            return *cache.list;
+        }
+
+        std::lock_guard<std::mutex> g(mListsMutex);
+
+        const std::thread::id thisThread{std::this_thread::get_id()};
+        auto findIt = std::find_if(mLists.begin(), mLists.end(),
+            [&] (const std::unique_ptr<ThreadList> &tl) {
+                return tl->thread == thisThread;
+            });
 
-        sChanges.push_back(std::make_pair(
-            std::unique_ptr<SortedList<EntityId>>(list), false));
+        if (findIt == mLists.end())
+        { // First change from this thread.
+            mLists.emplace_back(new ThreadList{thisThread, List<EntityId>(mMemory)});
+            findIt = mLists.end() - 1u;
+        }
+
+        cache.owner = mId;
+        cache.list = &(*findIt)->changed;
+
+        return *cache.list;
     }
 
     template <typename UT>
-    void ChangedEntitiesHolder<UT>::unregisterList(SortedList<EntityId> *list)
+    void ChangedEntitiesHolder<UT>::mergeRanges(FrameVectorT<RangeT> &ranges, List<EntityId> &out)
     {
-        std::lock_guard<std::mutex> g(sChangesMutex);
+        // Min-heap of the first IDs of each range.
+        using HeapItemT = std::pair<EntityId, u64>;
+        auto cmp = [] (const HeapItemT &first, const HeapItemT &second) {
+            return second.first < first.first;
+        };
+
+        FrameVectorT<HeapItemT> heap(ranges.get_allocator());
+        for (u64 index = 0u; index < ranges.size(); ++index)
+        {
+            if (ranges[index].first != ranges[index].second)
+            {
+                heap.emplace_back(*ranges[index].first, index);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), cmp);
 
-        for (auto &p : sChanges)
+        while (!heap.empty())
         {
-            if (p.first.get() == list)
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            HeapItemT &top(heap.back());
+
+            if (out.size() == 0u || out.back() < top.first)
+            { // The same ID may be in more than one range.
+                out.pushBack(top.first);
+            }
+
+            RangeT &range(ranges[top.second]);
+            if (++range.first != range.second)
+            {
+                top.first = *range.first;
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+            else
             {
-                p.second = true;
+                heap.pop_back();
             }
         }
     }
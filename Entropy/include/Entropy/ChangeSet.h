@@ -10,12 +10,84 @@
 #include "Types.h"
 #include "Util.h"
 #include "SortedList.h"
+#include "ActionLog.h"
+#include "MemoryReport.h"
 #include "EntityId.h"
 #include "ComponentManager.h"
 
 /// Main Entropy namespace
 namespace ent
 {
+    /**
+     * Merge policy - when multiple ChangeSets write the same
+     * Component of the same Entity, the last applied write wins.
+     */
+    struct MergeLastWriter
+    { };
+
+    /**
+     * Merge policy - when multiple ChangeSets write the same
+     * Component of the same Entity, the first applied write wins.
+     */
+    struct MergeFirstWriter
+    { };
+
+    /**
+     * Merge policy - when multiple ChangeSets write the same
+     * Component of the same Entity, the writes are combined.
+     * First write replaces the Component, each following write
+     * is combined with the current value. Writes within a single
+     * ChangeSet are combined in the order of the writes.
+     * @code
+     * struct Force
+     * {
+     *     struct Add
+     *     {
+     *         void operator()(Force &acc, Force &&f) const
+     *         { acc.x += f.x; }
+     *     };
+     *     using MergePolicyT = ent::MergeCombine<Add>;
+     *     float x;
+     * };
+     * @endcode
+     * @tparam CombineT Default constructible functor, called
+     *   as combine(ComponentT &current, ComponentT &&incoming).
+     */
+    template <typename CombineT>
+    struct MergeCombine
+    {
+        using CombineFunT = CombineT;
+    };
+
+    /**
+     * Extract merge policy type from given Component.
+     * Default value is ent::MergeLastWriter.
+     * This is the case, when Component does not have a policy specified.
+     * @tparam ComponentT Type of the Component.
+     * @tparam Check SFINAE check.
+     */
+    template <typename ComponentT,
+              typename = void>
+    struct MergePolicyExtractor
+    {
+        using type = ent::MergeLastWriter;
+    };
+
+    /**
+     * Extract merge policy type from given Component.
+     * This is the case, when Component does have a policy specified.
+     * @tparam ComponentT Type of the Component.
+     * @tparam Check SFINAE check.
+     */
+    template <typename ComponentT>
+    struct MergePolicyExtractor<ComponentT,
+        typename std::enable_if<
+            !std::is_void<typename ComponentT::MergePolicyT>::value
+        >::type>
+    {
+        using type = typename ComponentT::MergePolicyT;
+    };
+
     /**
      * Holds information about newly crated Component.
      * Alternatively can hold Component removal action.
@@ -42,12 +114,14 @@ namespace ent
          * @param cArgs Component constructor arguments.
          */
         template <typename... CArgTs>
-        ComponentChange(EntityId id, bool remove, CArgTs... cArgs);
+        ComponentChange(EntityId id, bool remove, CArgTs &&...cArgs);
 
         /// ID of the owner.
         EntityId id;
         /// Type of action.
         bool remove;
+        /// Does this action cancel the previous actions?
+        bool cancel;
         /// Component instance.
         ComponentT comp;
     }; // class ComponentChange
@@ -64,6 +138,18 @@ namespace ent
         /// Cleanup.
         virtual inline ~ComponentActions();
 
+        /**
+         * Resolve the logged actions, only the last
+         * action for each Entity is kept.
+         */
+        virtual void finalize() = 0;
+
+        /// Remove all actions, memory is kept for reuse.
+        virtual void clear() = 0;
+
+        /// Memory used by this holder, including itself.
+        virtual MemoryUsage memoryUsage() const = 0;
+
         /**
          * Used for static dispatch of actions to
          * ComponentActionsSpec.
@@ -90,12 +176,26 @@ namespace ent
         using HolderT = typename HolderExtractor<ComponentT>::type;
         // TODO - Use Holder for temporary Component storage?
 
-        using AddedListT = ent::SortedList<ComponentChange<ComponentT>,
+        using AddedListT = ent::ActionLog<ComponentChange<ComponentT>,
             typename ComponentChange<ComponentT>::ComponentChangeCmp>;
 
         /// Cleanup.
         virtual ~ComponentActionsSpec();
 
+        /**
+         * Resolve the logged actions, only the last
+         * action for each Entity is kept, cancelled
+         * actions are removed. Writes of Components with
+         * ent::MergeCombine policy are combined instead.
+         */
+        virtual void finalize() override final;
+
+        /// Remove all actions, memory is kept for reuse.
+        virtual void clear() override final;
+
+        /// Memory used by this holder, including itself.
+        virtual MemoryUsage memoryUsage() const override final;
+
         /**
          * Request removal of Component from given Entity.
          * @tparam ComponentT Component type.
@@ -126,8 +226,8 @@ namespace ent
          * to it and leave it in current state.
          * @param id ID of the Entity.
          * @return Returns ptr to the new, or old, Component data.
-         * @remarks Each call may invalidate pointers to
-         *   previously returned Component pointers.
+         * @remarks Does NOT invalidate previously returned
+         *   pointers, they are valid until the commit.
          */
         inline ComponentT *add(EntityId id);
         inline ComponentT *addT(EntityId id);
@@ -141,27 +241,65 @@ namespace ent
          * @param id ID of the Entity.
          * @return Returns ptr to the new temporary Component,
          *   constructed with given constructor parameters.
-         * @remarks Each call may invalidate pointers to
-         *   previously returned Component pointers.
+         * @remarks Does NOT invalidate previously returned
+         *   pointers, they are valid until the commit.
          */
         template <typename... CArgTs>
-        inline ComponentT *add(EntityId id, CArgTs... cArgs);
+        inline ComponentT *add(EntityId id, CArgTs &&...cArgs);
         template <typename... CArgTs>
-        inline ComponentT *addT(EntityId id, CArgTs... cArgs);
+        inline ComponentT *addT(EntityId id, CArgTs &&...cArgs);
 
-        /// Get List of added Components.
+        /**
+         * Get List of added Components.
+         * Sorted by Entity ID, after finalize.
+         */
         const AddedListT &added() const
         { return mAdded; };
+        AddedListT &added()
+        { return mAdded; };
 
-        /// Get List of added Components for temporary Entities.
+        /**
+         * Get List of added Components for temporary Entities.
+         * Sorted by Entity ID, after finalize.
+         */
         const AddedListT &tempAdded() const
         { return mTempAdded; };
+        AddedListT &tempAdded()
+        { return mTempAdded; };
     private:
-        /// Get pointer from iterator to given list.
-        inline ComponentT *ptrFromIt(typename AddedListT::iterator it, const AddedListT &list);
+        /**
+         * Get the Component from the newest action for
+         * given Entity.
+         * @param list Searched list.
+         * @param id ID of the Entity.
+         * @return Returns ptr to the Component, or nullptr
+         *   if there is no such action.
+         */
+        static inline ComponentT *findComponent(AddedListT &list, EntityId id);
+
+        /// Merge policy of the Component.
+        using PolicyT = typename MergePolicyExtractor<ComponentT>::type;
+
+        /**
+         * Resolve the log, keeping only the last action
+         * for each Entity.
+         * @param list Resolved list.
+         * @param policy Merge policy tag.
+         */
+        template <typename P>
+        static inline void resolve(AddedListT &list, P policy);
+
+        /**
+         * Resolve the log, combining the written Components
+         * for each Entity.
+         * @param list Resolved list.
+         * @param policy Merge policy tag.
+         */
+        template <typename CombineT>
+        static inline void resolve(AddedListT &list, MergeCombine<CombineT> policy);
 
         /**
-         * List of Entities which will either have a new Component
+         * Log of Entities which will either have a new Component
          * added, or the old one changed.
          */
         AddedListT mAdded;
@@ -227,6 +365,18 @@ namespace ent
          */
         inline void deactivateT(EntityId id);
 
+        /**
+         * Resolve the logged actions, only the last
+         * action for each Entity is kept.
+         */
+        inline void finalize();
+
+        /// Remove all actions, memory is kept for reuse.
+        inline void clear();
+
+        /// Memory used by the action logs.
+        inline MemoryUsage memoryUsage() const;
+
         /// Get list of requested Entity activity changes.
         const auto &changes() const
         { return mChanges; }
@@ -239,12 +389,12 @@ namespace ent
         const auto &destroyed() const
         { return mDestroyed; }
     private:
-        /// List of requested Entity activity changes.
-        ent::SortedList<ActivityChange, ActivityChange::ActivityChangeCmp> mChanges;
-        /// List of requested temporary Entity activity changes.
-        ent::SortedList<ActivityChange, ActivityChange::ActivityChangeCmp> mTempChanges;
-        /// List of Entities which should be destroyed.
-        ent::SortedList<EntityId> mDestroyed;
+        /// Log of requested Entity activity changes.
+        ent::ActionLog<ActivityChange, ActivityChange::ActivityChangeCmp> mChanges;
+        /// Log of requested temporary Entity activity changes.
+        ent::ActionLog<ActivityChange, ActivityChange::ActivityChangeCmp> mTempChanges;
+        /// Log of Entities which should be destroyed.
+        ent::ActionLog<EntityId> mDestroyed;
     protected:
     }; // class MetadataActions
 
@@ -254,6 +404,9 @@ namespace ent
     class ChangeSet
     {
     public:
+        /// Create an empty ChangeSet.
+        inline ChangeSet();
+
         /// Clean up any used memory.
         inline ~ChangeSet();
 
@@ -290,7 +443,7 @@ namespace ent
          * @param compId ID of the Component.
          * @param id Entity ID.
          * @return Returns ptr to the temporary Component.
-         * @remarks Calls invalidate previously returned pointers.
+         * @remarks Pointer is valid until the commit.
          */
         template <typename ComponentT>
         inline ComponentT *addComponent(u64 compId, EntityId id);
@@ -306,14 +459,14 @@ namespace ent
          * @param id Entity ID.
          * @param cArgs Constructor arguments.
          * @return Returns ptr to the temporary Component.
-         * @remarks Calls invalidate previously returned pointers.
+         * @remarks Pointer is valid until the commit.
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addComponent(u64 compId, EntityId id, CArgTs... cArgs);
+        inline ComponentT *addComponent(u64 compId, EntityId id, CArgTs &&...cArgs);
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addComponentT(u64 compId, EntityId id, CArgTs... cArgs);
+        inline ComponentT *addComponentT(u64 compId, EntityId id, CArgTs &&...cArgs);
 
         /**
          * Mark Component for removal.
@@ -380,6 +533,23 @@ namespace ent
          */
         inline EntityId createEntity();
 
+        /**
+         * Resolve all logged actions, only the last action
+         * for each Entity is kept. Called when the ChangeSet
+         * is being committed.
+         */
+        inline void finalize();
+
+        /**
+         * Remove all actions, so the ChangeSet can be
+         * used again. Allocated memory, including the
+         * Component action holders, is kept.
+         */
+        inline void clear();
+
+        /// Memory used by this ChangeSet, including itself.
+        inline MemoryUsage memoryUsage() const;
+
         /// Metadata changes getter.
         inline const MetadataActions &metadataChanges() const;
 
@@ -388,6 +558,31 @@ namespace ent
 
         /// ComponentsActions list getter.
         inline ent::List<ComponentActions*> &components();
+
+        /**
+         * Next ChangeSet in an intrusive list.
+         * Used by ActionsCache for queueing the ChangeSets.
+         */
+        ChangeSet *&next()
+        { return mNext; }
+        const ChangeSet *next() const
+        { return mNext; }
+
+        /**
+         * Order key of this ChangeSet. When the deterministic
+         * merge is enabled, ChangeSets are applied in the order
+         * of their keys, instead of the order of commits.
+         */
+        u64 key() const
+        { return mKey; }
+
+        /**
+         * Set order key of this ChangeSet, the key is
+         * reset to 0 when the ChangeSet is cleared.
+         * @param key The new key.
+         */
+        void setKey(u64 key)
+        { mKey = key; }
     private:
         /**
          * Get Component actions holder for hiven Component type.
@@ -413,6 +608,15 @@ namespace ent
          * EntityId of the created Entity.
          */
         ent::List<EntityId> mTempEntities;
+
+        /// Next ChangeSet in an intrusive list.
+        ChangeSet *mNext;
+
+        /// Order key used by the deterministic merge.
+        u64 mKey;
+
+        /// Resource used by the Component action holders.
+        MemoryResource *mMemory;
     protected:
     }; // class ChangeSet
 
@@ -436,19 +640,25 @@ namespace ent
         /**
          * Release ownership of the current ChangeSet
          * and return a pointer to it.
-         * Also initializes a new ChangeSet.
+         * Given ChangeSet is used in its place, if none
+         * is provided, a new ChangeSet is created.
+         * @param replacement Empty ChangeSet, which will
+         *   be owned by this container.
          * @return Returns ptr to the current ChangeSet.
          */
-        inline ChangeSet *releaseChangeSet();
+        inline ChangeSet *releaseChangeSet(ChangeSet *replacement = nullptr);
 
         /**
          * Get the ChangeSet currently in use.
          * @return Returns reference to the ChangeSet in use.
          */
         inline ChangeSet &currentChangeSet();
+        inline const ChangeSet &currentChangeSet() const;
     private:
         /// ChangeSet currently in use.
         std::unique_ptr<ChangeSet> mCurrectChangeSet;
+        /// Resource used for new ChangeSets.
+        MemoryResource *mMemory;
     protected:
     }; // class ActionsContainer
 #endif
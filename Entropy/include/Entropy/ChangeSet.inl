@@ -12,8 +12,8 @@ namespace ent
     // ComponentChange implementation.
     template <typename ComponentT>
     template <typename... CArgTs>
-    ComponentChange<ComponentT>::ComponentChange(EntityId id, bool removeAct, CArgTs... cArgs) :
-        id{id}, remove{removeAct}, comp(std::forward<CArgTs>(cArgs)...)
+    ComponentChange<ComponentT>::ComponentChange(EntityId id, bool removeAct, CArgTs &&...cArgs) :
+        id{id}, remove{removeAct}, cancel{false}, comp(std::forward<CArgTs>(cArgs)...)
     { }
     // ComponentChange implementation end.
 
@@ -56,73 +56,124 @@ namespace ent
     ComponentActionsSpec<ComponentT>::~ComponentActionsSpec()
     { }
 
+    template <typename ComponentT>
+    void ComponentActionsSpec<ComponentT>::finalize()
+    {
+        auto cancelled = [] (const ComponentChange<ComponentT> &cc) {
+            return cc.cancel;
+        };
+
+        resolve(mAdded, PolicyT());
+        mAdded.eraseIf(cancelled);
+        resolve(mTempAdded, PolicyT());
+        mTempAdded.eraseIf(cancelled);
+    }
+
+    template <typename ComponentT>
+    void ComponentActionsSpec<ComponentT>::clear()
+    {
+        mAdded.clear();
+        mTempAdded.clear();
+    }
+
+    template <typename ComponentT>
+    MemoryUsage ComponentActionsSpec<ComponentT>::memoryUsage() const
+    {
+        MemoryUsage result{sizeof(*this), sizeof(*this), sizeof(*this)};
+
+        result += MemoryUsage::ofList(mAdded);
+        result += MemoryUsage::ofList(mTempAdded);
+
+        return result;
+    }
+
     template <typename ComponentT>
     void ComponentActionsSpec<ComponentT>::remove(EntityId id)
     {
-        mAdded.replaceUnique(id, id, true);
+        mAdded.append(id, true);
     }
 
     template <typename ComponentT>
     void ComponentActionsSpec<ComponentT>::removeTemp(EntityId id)
     {
-        mAdded.erase(id);
+        mAdded.append(id, false).cancel = true;
     }
 
     template <typename ComponentT>
     void ComponentActionsSpec<ComponentT>::removeTempT(EntityId id)
     {
-        mTempAdded.erase(id);
+        mTempAdded.append(id, false).cancel = true;
     }
 
     template <typename ComponentT>
     ComponentT *ComponentActionsSpec<ComponentT>::get(EntityId id)
     {
-        auto it = mAdded.find(id);
-        return ptrFromIt(it, mAdded);
+        return findComponent(mAdded, id);
     }
 
     template <typename ComponentT>
     ComponentT *ComponentActionsSpec<ComponentT>::getT(EntityId id)
     {
-        auto it = mTempAdded.find(id);
-        return ptrFromIt(it, mTempAdded);
+        return findComponent(mTempAdded, id);
     }
 
     template <typename ComponentT>
     ComponentT *ComponentActionsSpec<ComponentT>::add(EntityId id)
     {
-        auto it =  mAdded.replaceUnique(id, id, false);
-        return ptrFromIt(it, mAdded);
+        return &mAdded.append(id, false).comp;
     }
 
     template <typename ComponentT>
     ComponentT *ComponentActionsSpec<ComponentT>::addT(EntityId id)
     {
-        auto it =  mTempAdded.replaceUnique(id, id, false);
-        return ptrFromIt(it, mTempAdded);
+        return &mTempAdded.append(id, false).comp;
     }
 
     template <typename ComponentT>
     template <typename... CArgTs>
     ComponentT *ComponentActionsSpec<ComponentT>::add(EntityId id,
-                                                      CArgTs... cArgs)
+                                                      CArgTs &&...cArgs)
     {
-        auto it = mAdded.replaceUnique(id, id, false, std::forward<CArgTs>(cArgs)...);
-        return ptrFromIt(it, mAdded);
+        return &mAdded.append(id, false, std::forward<CArgTs>(cArgs)...).comp;
     }
 
     template <typename ComponentT>
     template <typename... CArgTs>
     ComponentT *ComponentActionsSpec<ComponentT>::addT(EntityId id,
-                                                      CArgTs... cArgs)
+                                                      CArgTs &&...cArgs)
+    {
+        return &mTempAdded.append(id, false, std::forward<CArgTs>(cArgs)...).comp;
+    }
+
+    template <typename ComponentT>
+    ComponentT *ComponentActionsSpec<ComponentT>::findComponent(AddedListT &list, EntityId id)
+    {
+        ComponentChange<ComponentT> *cc{list.findLast(id)};
+        return (cc && !cc->cancel) ? &cc->comp : nullptr;
+    }
+
+    template <typename ComponentT>
+    template <typename P>
+    void ComponentActionsSpec<ComponentT>::resolve(AddedListT &list, P /*policy*/)
     {
-        auto it = mTempAdded.replaceUnique(id, id, false, std::forward<CArgTs>(cArgs)...);
-        return ptrFromIt(it, mTempAdded);
+        list.resolve();
     }
 
     template <typename ComponentT>
-    ComponentT *ComponentActionsSpec<ComponentT>::ptrFromIt(typename AddedListT::iterator it, const AddedListT &list)
-    { return it != list.end() ? &(it->comp) : nullptr; }
+    template <typename CombineT>
+    void ComponentActionsSpec<ComponentT>::resolve(AddedListT &list, MergeCombine<CombineT> /*policy*/)
+    {
+        list.resolve([] (ComponentChange<ComponentT> &older, ComponentChange<ComponentT> &&newer) {
+            if (older.remove || older.cancel || newer.remove || newer.cancel)
+            { // Following write starts from scratch.
+                older = std::move(newer);
+            }
+            else
+            {
+                CombineT()(older.comp, std::move(newer.comp));
+            }
+        });
+    }
     // ComponentActionsSpec implementation end.
 
     // ActivityChangeCmp implementation.
@@ -137,31 +188,60 @@ namespace ent
     // MetadataActions implementation.
     void MetadataActions::activate(EntityId id)
     {
-        mChanges.replaceUnique(id, ActivityChange{id, true});
+        mChanges.append(ActivityChange{id, true});
     }
 
     void MetadataActions::deactivate(EntityId id)
     {
-        mChanges.replaceUnique(id, ActivityChange{id, false});
+        mChanges.append(ActivityChange{id, false});
     }
 
     void MetadataActions::destroy(EntityId id)
     {
-        mDestroyed.insertUnique(id);
+        mDestroyed.append(id);
     }
 
     void MetadataActions::activateT(EntityId id)
     {
-        mTempChanges.replaceUnique(id, ActivityChange{id, true});
+        mTempChanges.append(ActivityChange{id, true});
     }
 
     void MetadataActions::deactivateT(EntityId id)
     {
-        mTempChanges.replaceUnique(id, ActivityChange{id, false});
+        mTempChanges.append(ActivityChange{id, false});
+    }
+
+    void MetadataActions::finalize()
+    {
+        mChanges.resolve();
+        mTempChanges.resolve();
+        mDestroyed.resolve();
+    }
+
+    void MetadataActions::clear()
+    {
+        mChanges.clear();
+        mTempChanges.clear();
+        mDestroyed.clear();
+    }
+
+    MemoryUsage MetadataActions::memoryUsage() const
+    {
+        MemoryUsage result;
+
+        result += MemoryUsage::ofList(mChanges);
+        result += MemoryUsage::ofList(mTempChanges);
+        result += MemoryUsage::ofList(mDestroyed);
+
+        return result;
     }
     // MetadataActions implementation end.
 
     // ChangeSet implementation.
+    ChangeSet::ChangeSet() :
+        mNext{nullptr}, mKey{0u}, mMemory{MemoryResource::current()}
+    { }
+
     ChangeSet::~ChangeSet()
     {
         for (ComponentActions *cc : mComponentActions)
@@ -193,11 +273,11 @@ namespace ent
 
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *ChangeSet::addComponent(u64 compId, EntityId id, CArgTs... cArgs)
+    ComponentT *ChangeSet::addComponent(u64 compId, EntityId id, CArgTs &&...cArgs)
     { ENT_ASSERT_SLOW(!id.isTemp()); return componentActions<ComponentT>(compId).add(id, std::forward<CArgTs>(cArgs)...); }
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *ChangeSet::addComponentT(u64 compId, EntityId id, CArgTs... cArgs)
+    ComponentT *ChangeSet::addComponentT(u64 compId, EntityId id, CArgTs &&...cArgs)
     { ENT_ASSERT_SLOW(id.isTemp()); return componentActions<ComponentT>(compId).addT(id, std::forward<CArgTs>(cArgs)...); }
 
     template <typename ComponentT>
@@ -242,6 +322,52 @@ namespace ent
         return EntityId(static_cast<EIdType>(mTempEntities.size()) - 1u, EntityId::TEMP_ENTITY_GEN);
     }
 
+    void ChangeSet::finalize()
+    {
+        for (ComponentActions *ca : mComponentActions)
+        {
+            if (ca)
+            {
+                ca->finalize();
+            }
+        }
+
+        mMetadataActions.finalize();
+    }
+
+    void ChangeSet::clear()
+    {
+        for (ComponentActions *ca : mComponentActions)
+        {
+            if (ca)
+            {
+                ca->clear();
+            }
+        }
+
+        mMetadataActions.clear();
+        mTempEntities.clear();
+        mKey = 0u;
+    }
+
+    MemoryUsage ChangeSet::memoryUsage() const
+    {
+        MemoryUsage result{sizeof(*this), sizeof(*this), sizeof(*this)};
+
+        result += MemoryUsage::ofList(mComponentActions);
+        for (const ComponentActions *ca : mComponentActions)
+        {
+            if (ca)
+            {
+                result += ca->memoryUsage();
+            }
+        }
+        result += mMetadataActions.memoryUsage();
+        result += MemoryUsage::ofList(mTempEntities);
+
+        return result;
+    }
+
     const MetadataActions &ChangeSet::metadataChanges() const
     { return mMetadataActions; }
 
@@ -264,6 +390,7 @@ namespace ent
         result = mComponentActions[componentId];
         if (result == nullptr)
         { // ComponentSet has not been created yet.
+            MemoryScope scope(mMemory);
             result = new ComponentActionsSpec< ComponentT>;
             mComponentActions[componentId] = result;
         }
@@ -274,7 +401,7 @@ namespace ent
 
     // ActionsContainer implementation.
     ActionsContainer::ActionsContainer() :
-        mCurrectChangeSet{new ChangeSet}
+        mCurrectChangeSet{new ChangeSet}, mMemory{MemoryResource::current()}
     { }
 
     ActionsContainer::~ActionsContainer()
@@ -283,10 +410,18 @@ namespace ent
     ChangeSet &ActionsContainer::currentChangeSet()
     { return *mCurrectChangeSet; }
 
-    ChangeSet *ActionsContainer::releaseChangeSet()
+    const ChangeSet &ActionsContainer::currentChangeSet() const
+    { return *mCurrectChangeSet; }
+
+    ChangeSet *ActionsContainer::releaseChangeSet(ChangeSet *replacement)
     {
         ChangeSet *result{mCurrectChangeSet.release()};
-        mCurrectChangeSet.reset(new ChangeSet);
+        if (!replacement)
+        {
+            MemoryScope scope(mMemory);
+            replacement = new ChangeSet;
+        }
+        mCurrectChangeSet.reset(replacement);
         return result;
     }
     // ActionsContainer implementation.
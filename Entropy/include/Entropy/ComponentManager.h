@@ -8,6 +8,9 @@
 #ifndef ECS_FIT_COMPONENTMANAGER_H
 #define ECS_FIT_COMPONENTMANAGER_H
 
+#include <memory>
+#include <vector>
+
 #include "Types.h"
 #include "Util.h"
 #include "ComponentStorage.h"
@@ -47,6 +50,47 @@ namespace ent
         using type = typename ComponentT::HolderT;
     };
 
+    /**
+     * Check, if the Component holder is index-addressed - Components
+     * are stored in contiguous memory, indexed by the Entity index.
+     * Such holders have to provide data() method, returning
+     * pointer to Component for Entity with index 0.
+     * This is the base case, where the holder is not index-addressed.
+     * @tparam HolderT Type of the holder.
+     * @tparam ComponentT Type of the Component.
+     * @tparam Check SFINAE check.
+     */
+    template <typename HolderT,
+              typename ComponentT,
+              typename = void>
+    struct IndexedHolder
+    {
+        static constexpr bool value{false};
+
+        static ComponentT *data(HolderT &/*holder*/)
+        { return nullptr; }
+    };
+
+    /**
+     * Check, if the Component holder is index-addressed.
+     * This is the case, when the holder does provide the data() method.
+     * @tparam HolderT Type of the holder.
+     * @tparam ComponentT Type of the Component.
+     * @tparam Check SFINAE check.
+     */
+    template <typename HolderT,
+              typename ComponentT>
+    struct IndexedHolder<HolderT, ComponentT,
+        typename std::enable_if<
+            std::is_same<decltype(std::declval<HolderT&>().data()), ComponentT*>::value
+        >::type>
+    {
+        static constexpr bool value{true};
+
+        static ComponentT *data(HolderT &holder)
+        { return holder.data(); }
+    };
+
     /**
      * ComponentManager is a part of Entropy ECS Universe.
      * Used for handling list of ComponentHolders.
@@ -68,15 +112,90 @@ namespace ent
         ~ComponentManager();
 
         /**
-         * Refresh all Component Holders.
+         * Refresh all Component Holders. Components of
+         * destroyed Entities are removed first, using a
+         * single batch for each holder.
          */
         void refresh();
 
+        /**
+         * Remove queued Components of destroyed Entities,
+         * using a single batch for each holder.
+         */
+        inline void removeDestroyed();
+
+        /**
+         * Queue removal of Component of a destroyed Entity.
+         * Components are removed on the next refresh.
+         * @param id ID of the destroyed Entity.
+         * @param cId ID of the Component type.
+         */
+        inline void entityDestroyed(EntityId id, CIdType cId);
+
         /**
          * Reset Component holders.
          */
         void reset();
 
+        /**
+         * Write Components of all registered types to the snapshot.
+         * @param writer The snapshot writer.
+         * @return Returns true, if all holders support snapshots.
+         */
+        inline bool saveSnapshot(SnapshotWriter &writer) const;
+
+        /**
+         * Replace Components of all registered types with
+         * Components from the snapshot. Pending removals of
+         * Components of destroyed Entities are dropped.
+         * @param reader The snapshot reader.
+         * @return Returns true, if all holders have been loaded.
+         */
+        inline bool loadSnapshot(SnapshotReader &reader);
+
+        /**
+         * Replace Components of all registered types with copies
+         * of Components from another manager. Holders of trivially
+         * copyable Components are copied as whole blocks of memory,
+         * reusing already allocated memory where possible.
+         * Pending removals are copied as well.
+         * @param source Manager with the same registered Component
+         *   types, in the same order.
+         * @return Returns true, if all holders have been copied.
+         */
+        inline bool copyFrom(const ComponentManager &source);
+
+        /**
+         * Write Component of given type and Entity to the snapshot.
+         * @param writer The snapshot writer.
+         * @param id ID of the Entity, which has the Component.
+         * @param cId ID of the Component type.
+         * @return Returns true, if the Component has been saved.
+         */
+        bool saveComponent(SnapshotWriter &writer, EntityId id, CIdType cId) const
+        { return cId < mHolders.size() && mHolders[cId]->saveComponent(writer, id); }
+
+        /**
+         * Add/replace Component of given type and Entity with
+         * Component from the snapshot.
+         * @param reader The snapshot reader.
+         * @param id ID of the Entity.
+         * @param cId ID of the Component type.
+         * @return Returns true, if the Component has been loaded.
+         */
+        bool loadComponent(SnapshotReader &reader, EntityId id, CIdType cId)
+        { return cId < mHolders.size() && mHolders[cId]->loadComponent(reader, id); }
+
+        /**
+         * Remove Component of given type from the Entity, the
+         * Component bit in EntityManager is not changed.
+         * @param id ID of the Entity.
+         * @param cId ID of the Component type.
+         * @return Returns true, if the Component has been removed.
+         */
+        bool removeComponent(EntityId id, CIdType cId)
+        { return cId < mHolders.size() && mHolders[cId]->remove(id); }
+
         /**
          * Register given Component with its ComponentHolder.
          * @tparam ComponentT Type of the Component.
@@ -87,7 +206,7 @@ namespace ent
         template <typename ComponentT,
                   typename HolderT = typename HolderExtractor<ComponentT>::type,
                   typename... CArgTs>
-        inline CIdType registerComponent(CArgTs... cArgs);
+        inline CIdType registerComponent(CArgTs &&...cArgs);
 
         /**
          * Add Component for given Entity.
@@ -110,7 +229,7 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *add(EntityId id, CArgTs... cArgs);
+        inline ComponentT *add(EntityId id, CArgTs &&...cArgs);
 
         /**
          * Add or replace a Component for given Entity.
@@ -123,6 +242,17 @@ namespace ent
         template <typename ComponentT>
         inline ComponentT *replace(EntityId id, const ComponentT &comp);
 
+        /**
+         * Add or replace a Component for given Entity.
+         * Given Component is moved into the holder.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity.
+         * @param comp Component data.
+         * @return Returns pointer to the changed Component.
+         */
+        template <typename ComponentT>
+        inline ComponentT *replace(EntityId id, ComponentT &&comp);
+
         /**
          * Get Component of given Entity.
          * Returns pointer to read-write Component.
@@ -153,6 +283,17 @@ namespace ent
         template <typename ComponentT>
         inline bool remove(EntityId id);
 
+        /**
+         * Get the Component storage of index-addressed holder.
+         * @tparam ComponentT Component type.
+         * @return Returns pointer to the Component of Entity with
+         *   index 0, or nullptr, if the holder is not index-addressed.
+         * @remarks Pointer is valid only until a Component of the
+         *   same type is added.
+         */
+        template <typename ComponentT>
+        inline ComponentT *indexedData();
+
         /**
          * Get ID for given Component type.
          * @tparam ComponentT Component type.
@@ -168,6 +309,15 @@ namespace ent
          */
         inline CIdType numRegistered() const;
 
+        /**
+         * Get memory used by the holder of given Component type
+         * and by the list of its destroyed Entities.
+         * @param cId ID of the Component.
+         * @param count Number of Entities, which have the Component.
+         * @return Returns the memory usage.
+         */
+        inline MemoryUsage memoryUsage(CIdType cId, u64 count) const;
+
         /**
          * Check, if given Component type is registered in this manager.
          * @tparam ComponentT Type of the Component.
@@ -176,34 +326,22 @@ namespace ent
         template <typename ComponentT>
         inline bool registered() const;
     private:
-        /**
-         * Information about registered Component.
-         * @tparam HolderT Type of the Component holder.
-         */
-        template <typename HolderT>
-        struct ComponentRegister
-        {
-            ComponentRegister() :
-                id{0u}
-            { }
-
-            /// ID of the Component.
-            CIdType id;
+        /// Generator of type indices, used for mapping Component types to their IDs.
+        class TypeIdGenerator : public StaticClassIdGenerator<TypeIdGenerator>
+        { };
 
-            /// Used for storing Component data.
-            ConstructionHandler<HolderT> holder;
-        };
+        /// Marks Component types, which are not registered in this manager.
+        static constexpr CIdType UNREGISTERED{static_cast<CIdType>(ENT_MAX_COMPONENTS)};
 
-        /// Reset the Component ID counter to 0.
-        static void resetComponentIdCounter()
-        { sComponentIdCounter = 0; }
-
-        /// Get new unique Component ID and increment the counter.
-        static CIdType compIdInc()
-        {
-            ENT_ASSERT_FAST(sComponentIdCounter < ENT_MAX_COMPONENTS);
-            return sComponentIdCounter++;
-        }
+        /**
+         * Get type index of given Component type, shared by
+         * all managers of the same Universe type.
+         * @tparam ComponentT Type of the Component.
+         * @return Returns the type index.
+         */
+        template <typename ComponentT>
+        static u64 typeIndex()
+        { return TypeIdGenerator::template getId<ComponentT>(); }
 
         /**
          * Get ComponentHolder.
@@ -217,26 +355,14 @@ namespace ent
                   typename HolderT = typename HolderExtractor<ComponentT>::type>
         inline const HolderT &getHolder() const;
 
-        /**
-         * Component information register.
-         * @tparam ComponentT Type of the Component.
-         */
-        template <typename ComponentT,
-                  typename HolderT = typename HolderExtractor<ComponentT>::type>
-		static ConstructionHandler<ComponentRegister<HolderT>> &componentInfo()
-		{
-			static ConstructionHandler<ComponentRegister<HolderT>> reg;
-			return reg;
-		}
-
-        /// List of holders to refresh.
-        std::vector<BaseComponentHolderBase*> mRefreshHolders;
+        /// Component IDs indexed by the type index, UNREGISTERED for unknown types.
+        std::vector<CIdType> mTypeIds;
 
-        /// List of things to destruct on reset.
-        std::vector<std::function<void()>> mDestructOnReset;
+        /// Holders of the registered Components, indexed by the Component ID.
+        std::vector<std::unique_ptr<BaseComponentHolderBase>> mHolders;
 
-        /// Counter for Component IDs.
-        static CIdType sComponentIdCounter;
+        /// Destroyed Entities for each Component type, removed on refresh.
+        std::vector<List<EntityId>> mDestroyed;
     protected:
     }; // ComponentManager
 } // namespace ent
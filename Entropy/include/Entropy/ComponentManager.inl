@@ -11,9 +11,6 @@
 namespace ent
 {
     // ComponentManager implementation.
-    template <typename UT>
-    CIdType ComponentManager<UT>::sComponentIdCounter = 0u;
-
     template <typename UT>
     ComponentManager<UT>::ComponentManager()
     { reset(); }
@@ -25,31 +22,112 @@ namespace ent
     template <typename UT>
     void ComponentManager<UT>::refresh()
     {
-        for (BaseComponentHolderBase *h: mRefreshHolders)
+        removeDestroyed();
+
+        for (auto &h : mHolders)
         { // Refresh all the Component holders.
             h->refresh();
         }
     }
 
+    template <typename UT>
+    void ComponentManager<UT>::removeDestroyed()
+    {
+        for (CIdType cId = 0; cId < mDestroyed.size(); ++cId)
+        { // Remove Components of destroyed Entities.
+            List<EntityId> &destroyed(mDestroyed[cId]);
+            if (destroyed.size())
+            {
+                std::sort(destroyed.begin(), destroyed.end());
+                mHolders[cId]->removeBatch(destroyed.begin(), destroyed.end());
+                destroyed.clear();
+            }
+        }
+    }
+
+    template <typename UT>
+    void ComponentManager<UT>::entityDestroyed(EntityId id, CIdType cId)
+    {
+        ENT_ASSERT_SLOW(cId < mDestroyed.size());
+        mDestroyed[cId].pushBack(id);
+    }
+
     template <typename UT>
     void ComponentManager<UT>::reset()
     {
-        for (auto &h : mDestructOnReset)
+        mHolders.clear();
+        mDestroyed.clear();
+        mTypeIds.clear();
+    }
+
+    template <typename UT>
+    bool ComponentManager<UT>::saveSnapshot(SnapshotWriter &writer) const
+    {
+        writer.write<u64>(mHolders.size());
+        for (const auto &h : mHolders)
+        {
+            if (!h->saveSnapshot(writer))
+            {
+                return false;
+            }
+        }
+
+        return writer.good();
+    }
+
+    template <typename UT>
+    bool ComponentManager<UT>::loadSnapshot(SnapshotReader &reader)
+    {
+        u64 numHolders{0u};
+        if (!reader.read(numHolders) || numHolders != mHolders.size())
+        {
+            return false;
+        }
+
+        for (auto &h : mHolders)
+        {
+            if (!h->loadSnapshot(reader))
+            {
+                return false;
+            }
+        }
+
+        if (!reader.validating())
+        {
+            for (List<EntityId> &destroyed : mDestroyed)
+            {
+                destroyed.clear();
+            }
+        }
+
+        return true;
+    }
+
+    template <typename UT>
+    bool ComponentManager<UT>::copyFrom(const ComponentManager &source)
+    {
+        if (source.mHolders.size() != mHolders.size())
         {
-            h();
+            return false;
         }
-        mDestructOnReset.clear();
 
-        mRefreshHolders.clear();
+        for (CIdType cId = 0; cId < mHolders.size(); ++cId)
+        {
+            mDestroyed[cId] = source.mDestroyed[cId];
+            if (!mHolders[cId]->copyFrom(*source.mHolders[cId]))
+            {
+                return false;
+            }
+        }
 
-        resetComponentIdCounter();
+        return true;
     }
 
     template <typename UT>
     template <typename ComponentT,
         typename HolderT,
         typename... CArgTs>
-    CIdType ComponentManager<UT>::registerComponent(CArgTs... cArgs)
+    CIdType ComponentManager<UT>::registerComponent(CArgTs &&...cArgs)
     {
         static_assert(std::is_base_of<ent::BaseComponentHolder<ComponentT>, HolderT>::value,
                       "Component holder has to inherit from ent::BaseComponentHolder!");
@@ -83,27 +161,20 @@ namespace ent
             return id<ComponentT>();
         }
 
-        // Create register for the new Component.
-        componentInfo<ComponentT>().construct();
-        ENT_ASSERT_FAST(componentInfo<ComponentT>().constructed());
-        auto &regInfo = componentInfo<ComponentT>()();
-
         // Check, if there is enough space for one more Component.
-        ENT_ASSERT_FAST(sComponentIdCounter < ENT_MAX_COMPONENTS);
+        ENT_ASSERT_FAST(mHolders.size() < ENT_MAX_COMPONENTS);
         // Assign unique ID to the new Component.
-        regInfo.id = compIdInc();
-        const CIdType cId{id<ComponentT>()};
-        ENT_ASSERT_FAST(regInfo.id == cId);
+        const CIdType cId{static_cast<CIdType>(mHolders.size())};
+        const u64 typeIdx{typeIndex<ComponentT>()};
+        if (typeIdx >= mTypeIds.size())
+        {
+            mTypeIds.resize(typeIdx + 1u, CIdType{UNREGISTERED});
+        }
+        mTypeIds[typeIdx] = cId;
 
         // Initialize the Component storage.
-        regInfo.holder.construct(std::forward<CArgTs>(cArgs)...);
-
-        // Register the Component storage for refresh.
-        mRefreshHolders.emplace_back(regInfo.holder.ptr());
-
-        // Register the registered component to destruct on system reset.
-        mDestructOnReset.emplace_back(regInfo.holder.destructLater());
-        mDestructOnReset.emplace_back(componentInfo<ComponentT>().destructLater());
+        mHolders.emplace_back(new HolderT(std::forward<CArgTs>(cArgs)...));
+        mDestroyed.resize(mHolders.size());
 
         return cId;
     }
@@ -113,19 +184,33 @@ namespace ent
     CIdType ComponentManager<UT>::id() const
     {
         ENT_ASSERT_SLOW(registered<ComponentT>());
-        return componentInfo<ComponentT>()().id;
+        return mTypeIds[typeIndex<ComponentT>()];
     }
 
     template <typename UT>
     CIdType ComponentManager<UT>::numRegistered() const
     {
-        return sComponentIdCounter;
+        return static_cast<CIdType>(mHolders.size());
+    }
+
+    template <typename UT>
+    MemoryUsage ComponentManager<UT>::memoryUsage(CIdType cId, u64 count) const
+    {
+        ENT_ASSERT_FAST(cId < mHolders.size());
+
+        MemoryUsage result{mHolders[cId]->memoryUsage(count)};
+        result += MemoryUsage::ofList(mDestroyed[cId]);
+
+        return result;
     }
 
     template <typename UT>
     template <typename ComponentT>
     bool ComponentManager<UT>::registered() const
-    { return componentInfo<ComponentT>().constructed(); }
+    {
+        const u64 typeIdx{typeIndex<ComponentT>()};
+        return typeIdx < mTypeIds.size() && mTypeIds[typeIdx] != UNREGISTERED;
+    }
 
     template <typename UT>
     template <typename ComponentT>
@@ -137,7 +222,7 @@ namespace ent
     template <typename UT>
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *ComponentManager<UT>::add(EntityId id, CArgTs... cArgs)
+    ComponentT *ComponentManager<UT>::add(EntityId id, CArgTs &&...cArgs)
     {
         return getHolder<ComponentT>().add(id, std::forward<CArgTs>(cArgs)...);
     }
@@ -149,6 +234,13 @@ namespace ent
         return getHolder<ComponentT>().replace(id, std::forward<const ComponentT&>(comp));
     }
 
+    template <typename UT>
+    template <typename ComponentT>
+    ComponentT *ComponentManager<UT>::replace(EntityId id, ComponentT &&comp)
+    {
+        return getHolder<ComponentT>().replace(id, std::move(comp));
+    }
+
     template <typename UT>
     template <typename ComponentT>
     ComponentT *ComponentManager<UT>::get(EntityId id)
@@ -170,13 +262,21 @@ namespace ent
         return getHolder<ComponentT>().remove(id);
     }
 
+    template <typename UT>
+    template <typename ComponentT>
+    ComponentT *ComponentManager<UT>::indexedData()
+    {
+        using HolderT = typename HolderExtractor<ComponentT>::type;
+        return IndexedHolder<HolderT, ComponentT>::data(getHolder<ComponentT>());
+    }
+
     template <typename UT>
     template <typename ComponentT,
         typename HolderT>
     HolderT &ComponentManager<UT>::getHolder()
     {
         ENT_ASSERT_SLOW(registered<ComponentT>());
-        return componentInfo<ComponentT>()().holder();
+        return static_cast<HolderT&>(*mHolders[id<ComponentT>()]);
     }
 
     template <typename UT>
@@ -184,7 +284,8 @@ namespace ent
         typename HolderT>
     const HolderT &ComponentManager<UT>::getHolder() const
     {
-        return componentInfo<ComponentT>()().holder();
+        ENT_ASSERT_SLOW(registered<ComponentT>());
+        return static_cast<const HolderT&>(*mHolders[id<ComponentT>()]);
     }
     // ComponentManager implementation end.
 } // namespace ent
@@ -7,10 +7,13 @@
 #ifndef ECS_FIT_COMPONENTSTORAGE_H
 #define ECS_FIT_COMPONENTSTORAGE_H
 
+#include <tuple>
+
 #include "Types.h"
 #include "Util.h"
 #include "EntityId.h"
 #include "Memory.h"
+#include "Snapshot.h"
 
 /// Main Entropy namespace
 namespace ent
@@ -39,6 +42,82 @@ namespace ent
          *   for given Entity.
          */
         virtual bool remove(EntityId id) noexcept = 0;
+
+        /**
+         * Remove Components of all given Entities, used for
+         * removing Components of destroyed Entities at once.
+         * Default implementation calls remove for each Entity.
+         * @param begin First Entity ID, IDs are sorted and unique.
+         * @param end Pointer behind the last Entity ID.
+         */
+        virtual void removeBatch(const EntityId *begin, const EntityId *end) noexcept
+        {
+            for (const EntityId *it = begin; it != end; ++it)
+            {
+                remove(*it);
+            }
+        }
+
+        /**
+         * Write all Components to the snapshot.
+         * Default implementation does not support snapshots.
+         * @param writer The snapshot writer.
+         * @return Returns true, if the Components have been saved.
+         */
+        virtual bool saveSnapshot(SnapshotWriter &/*writer*/) const noexcept
+        { return false; }
+
+        /**
+         * Replace all Components with Components from
+         * the snapshot. When the reader is only validating,
+         * the data should be read and checked, without
+         * changing the Components.
+         * Default implementation does not support snapshots.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the Components have been loaded.
+         */
+        virtual bool loadSnapshot(SnapshotReader &/*reader*/) noexcept
+        { return false; }
+
+        /**
+         * Write Component of given Entity to the snapshot.
+         * Default implementation does not support snapshots.
+         * @param writer The snapshot writer.
+         * @param id ID of the Entity, which has the Component.
+         * @return Returns true, if the Component has been saved.
+         */
+        virtual bool saveComponent(SnapshotWriter &/*writer*/, EntityId /*id*/) const noexcept
+        { return false; }
+
+        /**
+         * Add/replace Component of given Entity with Component
+         * from the snapshot.
+         * Default implementation does not support snapshots.
+         * @param reader The snapshot reader.
+         * @param id ID of the Entity.
+         * @return Returns true, if the Component has been loaded.
+         */
+        virtual bool loadComponent(SnapshotReader &/*reader*/, EntityId /*id*/) noexcept
+        { return false; }
+
+        /**
+         * Replace all Components with copies of Components
+         * from another holder of the same type.
+         * Default implementation does not support copying.
+         * @param source The source holder.
+         * @return Returns true, if the Components have been copied.
+         */
+        virtual bool copyFrom(const BaseComponentHolderBase &/*source*/) noexcept
+        { return false; }
+
+        /**
+         * Get memory used by this holder.
+         * Default implementation reports no memory.
+         * @param count Number of Entities, which have the Component.
+         * @return Returns the memory usage.
+         */
+        virtual MemoryUsage memoryUsage(u64 /*count*/) const noexcept
+        { return {}; }
     private:
     protected:
     }; // class BaseComponentHolderBase
@@ -70,6 +149,17 @@ namespace ent
          */
         virtual ComponentT *replace(EntityId id, const ComponentT &comp) noexcept = 0;
 
+        /**
+         * Add/replace Component of given Entity, given Component
+         * is moved into the holder.
+         * Default implementation falls back to the copying version.
+         * @param id ID of the Entity.
+         * @param comp Component to move.
+         * @return Return ptr to the Component.
+         */
+        virtual ComponentT *replace(EntityId id, ComponentT &&comp) noexcept
+        { return replace(id, static_cast<const ComponentT&>(comp)); }
+
         /**
          * Optional operation for holders.
          *
@@ -84,7 +174,7 @@ namespace ent
          * @return Returns pointer to the Component.
          */
         //template <typename... CArgTs>
-        //inline ComponentT *add(EntityId id, CArgTs... cArgs) noexcept;
+        //inline ComponentT *add(EntityId id, CArgTs &&...cArgs) noexcept;
 
         /**
          * Get Component belonging to given EntityId.
@@ -101,7 +191,37 @@ namespace ent
          * @return Returns pointer to the Component, or nullptr, if it does not exist.
          */
         virtual const ComponentT *get(EntityId id) const noexcept = 0;
+
+        /**
+         * Write Component of given Entity to the snapshot, only
+         * trivially copyable Components are supported.
+         * @param writer The snapshot writer.
+         * @param id ID of the Entity, which has the Component.
+         * @return Returns true, if the Component has been saved.
+         */
+        virtual bool saveComponent(SnapshotWriter &writer, EntityId id) const noexcept override
+        { return saveComponentImpl(writer, id, std::is_trivially_copyable<ComponentT>{}); }
+
+        /**
+         * Add/replace Component of given Entity with Component
+         * from the snapshot, only trivially copyable Components
+         * are supported.
+         * @param reader The snapshot reader.
+         * @param id ID of the Entity.
+         * @return Returns true, if the Component has been loaded.
+         */
+        virtual bool loadComponent(SnapshotReader &reader, EntityId id) noexcept override
+        { return loadComponentImpl(reader, id, std::is_trivially_copyable<ComponentT>{}); }
     private:
+        /// Snapshot implementation for trivially copyable Components.
+        inline bool saveComponentImpl(SnapshotWriter &writer, EntityId id, std::true_type) const noexcept;
+        inline bool loadComponentImpl(SnapshotReader &reader, EntityId id, std::true_type) noexcept;
+
+        /// Other Components are not supported.
+        bool saveComponentImpl(SnapshotWriter &/*writer*/, EntityId /*id*/, std::false_type) const noexcept
+        { return false; }
+        bool loadComponentImpl(SnapshotReader &/*reader*/, EntityId /*id*/, std::false_type) noexcept
+        { return false; }
     protected:
     }; // class BaseComponentHolder
 
@@ -138,6 +258,15 @@ namespace ent
          */
         virtual inline ComponentT *replace(EntityId id, const ComponentT &comp) noexcept override;
 
+        /**
+         * Add/replace Component of given Entity, given Component
+         * is moved into the holder.
+         * @param id ID of the Entity.
+         * @param comp Component to move.
+         * @return Return ptr to the Component.
+         */
+        virtual inline ComponentT *replace(EntityId id, ComponentT &&comp) noexcept override;
+
         /**
          * Add Component for given EntityId, if the Component
          * already exists, It will be overwritten with element
@@ -150,7 +279,7 @@ namespace ent
          * @return Returns pointer to the Component.
          */
         template <typename... CArgTs>
-        inline ComponentT *add(EntityId id, CArgTs... cArgs) noexcept;
+        inline ComponentT *add(EntityId id, CArgTs &&...cArgs) noexcept;
 
         /**
          * Get Component belonging to given EntityId.
@@ -169,14 +298,72 @@ namespace ent
          */
         virtual inline bool remove(EntityId id) noexcept override;
 
+        /**
+         * Remove Components of all given Entities.
+         * @param begin First Entity ID, IDs are sorted and unique.
+         * @param end Pointer behind the last Entity ID.
+         */
+        virtual inline void removeBatch(const EntityId *begin, const EntityId *end) noexcept override;
+
         /**
          * Refresh the Component holder.
          * Called during the Universe refresh.
          */
         virtual inline void refresh() noexcept override;
+
+        /**
+         * Write all Components to the snapshot, only
+         * trivially copyable Components are supported.
+         * @param writer The snapshot writer.
+         * @return Returns true, if the Components have been saved.
+         */
+        virtual inline bool saveSnapshot(SnapshotWriter &writer) const noexcept override;
+
+        /**
+         * Replace all Components with Components from the
+         * snapshot, only trivially copyable Components
+         * are supported.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the Components have been loaded.
+         */
+        virtual inline bool loadSnapshot(SnapshotReader &reader) noexcept override;
+
+        /**
+         * Replace all Components with copies of Components
+         * from another holder of the same type, only copy
+         * constructible Components are supported.
+         * @param source The source holder.
+         * @return Returns true, if the Components have been copied.
+         */
+        virtual inline bool copyFrom(const BaseComponentHolderBase &source) noexcept override;
+
+        /**
+         * Get memory used by this holder.
+         * @param count Number of Entities, which have the Component.
+         * @return Returns the memory usage.
+         */
+        virtual inline MemoryUsage memoryUsage(u64 count) const noexcept override;
     private:
+        /// Snapshot implementation for trivially copyable Components.
+        inline bool saveSnapshotImpl(SnapshotWriter &writer, std::true_type) const;
+        inline bool loadSnapshotImpl(SnapshotReader &reader, std::true_type);
+
+        /// Other Components are not supported.
+        bool saveSnapshotImpl(SnapshotWriter &/*writer*/, std::false_type) const
+        { return false; }
+        bool loadSnapshotImpl(SnapshotReader &/*reader*/, std::false_type)
+        { return false; }
+
+        /// Copying of copy constructible Components.
+        inline bool copyFromImpl(const ComponentHolder &source, std::true_type);
+
+        /// Other Components are not supported.
+        bool copyFromImpl(const ComponentHolder &source, std::false_type)
+        { return false; }
+
         /// Mapping from EntityId to Component.
-        std::map<EntityId, ComponentT> mMap;
+        std::map<EntityId, ComponentT, std::less<EntityId>,
+                 ResourceAllocator<std::pair<const EntityId, ComponentT>>> mMap;
     protected:
     }; // class ComponentHolder
 
@@ -212,6 +399,15 @@ namespace ent
          */
         virtual inline ComponentT *replace(EntityId id, const ComponentT &comp) noexcept override;
 
+        /**
+         * Add/replace Component of given Entity, given Component
+         * is moved into the holder.
+         * @param id ID of the Entity.
+         * @param comp Component to move.
+         * @return Return ptr to the Component.
+         */
+        virtual inline ComponentT *replace(EntityId id, ComponentT &&comp) noexcept override;
+
         /**
          * Add Component for given EntityId, if the Component
          * already exists, It will be overwritten with element
@@ -224,7 +420,7 @@ namespace ent
          * @return Returns pointer to the Component.
          */
         template <typename... CArgTs>
-        inline ComponentT *add(EntityId id, CArgTs... cArgs) noexcept;
+        inline ComponentT *add(EntityId id, CArgTs &&...cArgs) noexcept;
 
         /**
          * Get Component belonging to given EntityId.
@@ -248,6 +444,35 @@ namespace ent
          * Called during the Universe refresh.
          */
         virtual inline void refresh() noexcept override;
+
+        /**
+         * Write all Components to the snapshot.
+         * @param writer The snapshot writer.
+         * @return Returns true, if the Components have been saved.
+         */
+        virtual inline bool saveSnapshot(SnapshotWriter &writer) const noexcept override;
+
+        /**
+         * Replace all Components with Components from the snapshot.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the Components have been loaded.
+         */
+        virtual inline bool loadSnapshot(SnapshotReader &reader) noexcept override;
+
+        /**
+         * Replace all Components with copies of Components
+         * from another holder of the same type.
+         * @param source The source holder.
+         * @return Returns true, if the Components have been copied.
+         */
+        virtual inline bool copyFrom(const BaseComponentHolderBase &source) noexcept override;
+
+        /**
+         * Get memory used by this holder.
+         * @param count Number of Entities, which have the Component.
+         * @return Returns the memory usage.
+         */
+        virtual inline MemoryUsage memoryUsage(u64 count) const noexcept override;
     private:
         /**
          * Get already existing index, or create a new element.
@@ -258,7 +483,8 @@ namespace ent
         u64 getCreateIndex(EntityId id);
 
         /// Mapping from EntityId to index in the List.
-        std::map<EntityId, u64> mMapping;
+        std::map<EntityId, u64, std::less<EntityId>,
+                 ResourceAllocator<std::pair<const EntityId, u64>>> mMapping;
         /// List of free IDs.
         List<u64> mFreeIds;
         /// List containing the components.
@@ -298,6 +524,15 @@ namespace ent
          */
         virtual inline ComponentT *replace(EntityId id, const ComponentT &comp) noexcept override;
 
+        /**
+         * Add/replace Component of given Entity, given Component
+         * is moved into the holder.
+         * @param id ID of the Entity.
+         * @param comp Component to move.
+         * @return Return ptr to the Component.
+         */
+        virtual inline ComponentT *replace(EntityId id, ComponentT &&comp) noexcept override;
+
         /**
          * Add Component for given EntityId, if the Component
          * already exists, It will be overwritten with element
@@ -310,7 +545,7 @@ namespace ent
          * @return Returns pointer to the Component.
          */
         template <typename... CArgTs>
-        inline ComponentT *add(EntityId id, CArgTs... cArgs) noexcept;
+        inline ComponentT *add(EntityId id, CArgTs &&...cArgs) noexcept;
 
         /**
          * Get Component belonging to given EntityId.
@@ -329,11 +564,59 @@ namespace ent
          */
         virtual inline bool remove(EntityId id) noexcept override;
 
+        /**
+         * Components are addressed by the Entity index and
+         * overwritten when the index is reused, nothing
+         * needs to be done.
+         * @param begin First Entity ID.
+         * @param end Pointer behind the last Entity ID.
+         */
+        virtual void removeBatch(const EntityId * /*begin*/, const EntityId * /*end*/) noexcept override
+        { }
+
         /**
          * Refresh the Component holder.
          * Called during the Universe refresh.
          */
         virtual inline void refresh() noexcept override;
+
+        /**
+         * Get the Component storage, Components are
+         * addressed by the Entity index.
+         * @return Returns pointer to Component of Entity
+         *   with index 0.
+         */
+        inline ComponentT *data() noexcept;
+        inline const ComponentT *data() const noexcept;
+
+        /**
+         * Write all Components to the snapshot.
+         * @param writer The snapshot writer.
+         * @return Returns true, if the Components have been saved.
+         */
+        virtual inline bool saveSnapshot(SnapshotWriter &writer) const noexcept override;
+
+        /**
+         * Replace all Components with Components from the snapshot.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the Components have been loaded.
+         */
+        virtual inline bool loadSnapshot(SnapshotReader &reader) noexcept override;
+
+        /**
+         * Replace all Components with copies of Components
+         * from another holder of the same type.
+         * @param source The source holder.
+         * @return Returns true, if the Components have been copied.
+         */
+        virtual inline bool copyFrom(const BaseComponentHolderBase &source) noexcept override;
+
+        /**
+         * Get memory used by this holder.
+         * @param count Number of Entities, which have the Component.
+         * @return Returns the memory usage.
+         */
+        virtual inline MemoryUsage memoryUsage(u64 count) const noexcept override;
     private:
         /// List containing the components.
         List<ComponentT> mList;
@@ -9,6 +9,43 @@
 /// Main Entropy namespace
 namespace ent
 {
+    // BaseComponentHolder implementation.
+    template <typename ComponentT>
+    bool BaseComponentHolder<ComponentT>::saveComponentImpl(SnapshotWriter &writer, EntityId id,
+                                                            std::true_type) const noexcept
+    {
+        const ComponentT *comp{get(id)};
+        if (!comp)
+        {
+            return false;
+        }
+
+        try {
+            writer.writeBlock(comp, sizeof(ComponentT));
+            return writer.good();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename ComponentT>
+    bool BaseComponentHolder<ComponentT>::loadComponentImpl(SnapshotReader &reader, EntityId id,
+                                                            std::true_type) noexcept
+    {
+        u64 size{0u};
+        const void *data{reader.readBlock(size)};
+        if (!data || size != sizeof(ComponentT))
+        {
+            return false;
+        }
+
+        typename std::aligned_storage<sizeof(ComponentT), alignof(ComponentT)>::type comp;
+        std::memcpy(&comp, data, sizeof(ComponentT));
+
+        return replace(id, *reinterpret_cast<const ComponentT*>(&comp)) != nullptr;
+    }
+    // BaseComponentHolder implementation end.
+
     // ComponentHolder implementation.
     template <typename ComponentT>
     ComponentHolder<ComponentT>::ComponentHolder()
@@ -32,17 +69,33 @@ namespace ent
     template <typename ComponentT>
     ComponentT *ComponentHolder<ComponentT>::replace(EntityId id, const ComponentT &comp) noexcept
     {
-        return add(id, std::forward<const ComponentT&>(comp));
+        return add(id, comp);
+    }
+
+    template <typename ComponentT>
+    ComponentT *ComponentHolder<ComponentT>::replace(EntityId id, ComponentT &&comp) noexcept
+    {
+        return add(id, std::move(comp));
     }
 
     template <typename ComponentT>
     template <typename... CArgTs>
-    ComponentT *ComponentHolder<ComponentT>::add(EntityId id, CArgTs... cArgs) noexcept
+    ComponentT *ComponentHolder<ComponentT>::add(EntityId id, CArgTs &&...cArgs) noexcept
     {
         ComponentT* result{nullptr};
         try {
-            //result = &(mMap.try_emplace(id, std::forward<CArgTs>(cArgs)...).first->second);
-            result = &(mMap.emplace(id, std::move(ComponentT(std::forward<CArgTs>(cArgs)...))).first->second);
+            auto findIt = mMap.find(id);
+            if (findIt != mMap.end())
+            { // Overwrite the old Component.
+                findIt->second = ComponentT(std::forward<CArgTs>(cArgs)...);
+                result = &findIt->second;
+            }
+            else
+            { // Construct the Component inplace.
+                result = &(mMap.emplace_hint(findIt, std::piecewise_construct,
+                                             std::forward_as_tuple(id),
+                                             std::forward_as_tuple(std::forward<CArgTs>(cArgs)...))->second);
+            }
         } catch(...) {
         }
         return result;
@@ -80,6 +133,138 @@ namespace ent
         }
         return false;
     }
+
+    template <typename ComponentT>
+    void ComponentHolder<ComponentT>::removeBatch(const EntityId *begin, const EntityId *end) noexcept
+    {
+        auto mapIt{mMap.begin()};
+        for (const EntityId *it = begin; it != end && mapIt != mMap.end(); ++it)
+        {
+            // IDs are sorted, search continues from the last position.
+            if (mapIt->first < *it)
+            {
+                mapIt = mMap.lower_bound(*it);
+            }
+
+            if (mapIt != mMap.end() && !(*it < mapIt->first))
+            {
+                mapIt = mMap.erase(mapIt);
+            }
+        }
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::saveSnapshot(SnapshotWriter &writer) const noexcept
+    {
+        try {
+            return saveSnapshotImpl(writer, std::is_trivially_copyable<ComponentT>{});
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::loadSnapshot(SnapshotReader &reader) noexcept
+    {
+        try {
+            return loadSnapshotImpl(reader, std::is_trivially_copyable<ComponentT>{});
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::saveSnapshotImpl(SnapshotWriter &writer, std::true_type) const
+    {
+        writer.write<u64>(sizeof(ComponentT));
+        writer.write<u64>(mMap.size());
+
+        writer.beginBlock(mMap.size() * sizeof(EntityId));
+        for (const auto &rec : mMap)
+        {
+            writer.writeData(&rec.first, sizeof(EntityId));
+        }
+
+        writer.beginBlock(mMap.size() * sizeof(ComponentT));
+        for (const auto &rec : mMap)
+        {
+            writer.writeData(&rec.second, sizeof(ComponentT));
+        }
+
+        return writer.good();
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::loadSnapshotImpl(SnapshotReader &reader, std::true_type)
+    {
+        u64 compSize{0u};
+        u64 count{0u};
+        if (!reader.read(compSize) || compSize != sizeof(ComponentT) || !reader.read(count))
+        {
+            return false;
+        }
+
+        u64 idsSize{0u};
+        u64 compsSize{0u};
+        const u8 *ids{static_cast<const u8*>(reader.readBlock(idsSize))};
+        const u8 *comps{static_cast<const u8*>(reader.readBlock(compsSize))};
+        if (!ids || !comps ||
+            idsSize != count * sizeof(EntityId) ||
+            compsSize != count * sizeof(ComponentT))
+        {
+            return false;
+        }
+
+        if (reader.validating())
+        {
+            return true;
+        }
+
+        mMap.clear();
+        for (u64 iii = 0; iii < count; ++iii)
+        {
+            EntityId id;
+            std::memcpy(&id, ids + iii * sizeof(EntityId), sizeof(EntityId));
+            typename std::aligned_storage<sizeof(ComponentT), alignof(ComponentT)>::type comp;
+            std::memcpy(&comp, comps + iii * sizeof(ComponentT), sizeof(ComponentT));
+
+            // IDs are sorted, so each Component is inserted at the end.
+            mMap.emplace_hint(mMap.end(), id, *reinterpret_cast<const ComponentT*>(&comp));
+        }
+
+        return true;
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::copyFrom(const BaseComponentHolderBase &source) noexcept
+    {
+        const ComponentHolder *holder{dynamic_cast<const ComponentHolder*>(&source)};
+        if (!holder)
+        {
+            return false;
+        }
+
+        try {
+            return copyFromImpl(*holder, std::is_copy_constructible<ComponentT>{});
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename ComponentT>
+    bool ComponentHolder<ComponentT>::copyFromImpl(const ComponentHolder &source, std::true_type)
+    {
+        if (&source != this)
+        {
+            mMap = source.mMap;
+        }
+
+        return true;
+    }
+
+    template <typename ComponentT>
+    MemoryUsage ComponentHolder<ComponentT>::memoryUsage(u64 /*count*/) const noexcept
+    { return MemoryUsage::ofNodes(mMap); }
     // ComponentHolder implementation end.
 
     // ComponentHolderMapList implementation.
@@ -106,19 +291,26 @@ namespace ent
     template <typename CT>
     inline CT *ComponentHolderMapList<CT>::replace(EntityId id, const CT &comp) noexcept
     {
-        return add(id, std::forward<const CT&>(comp));
+        return add(id, comp);
+    }
+
+    template <typename CT>
+    inline CT *ComponentHolderMapList<CT>::replace(EntityId id, CT &&comp) noexcept
+    {
+        return add(id, std::move(comp));
     }
 
     template <typename CT>
     template <typename... CArgTs>
-    CT *ComponentHolderMapList<CT>::add(EntityId id, CArgTs... cArgs) noexcept
+    CT *ComponentHolderMapList<CT>::add(EntityId id, CArgTs &&...cArgs) noexcept
     {
         try {
             u64 index{getCreateIndex(id)};
 
-            mList.emplace(mList.begin() + index, std::forward<CArgTs>(cArgs)...);
+            CT *result{&mList[index]};
+            *result = CT(std::forward<CArgTs>(cArgs)...);
 
-            return &mList[index];
+            return result;
         } catch (...) {
             return nullptr;
         }
@@ -180,6 +372,121 @@ namespace ent
         }
         return false;
     }
+
+    template <typename CT>
+    bool ComponentHolderMapList<CT>::saveSnapshot(SnapshotWriter &writer) const noexcept
+    {
+        try {
+            writer.write<u64>(sizeof(CT));
+            writer.write<u64>(mMapping.size());
+
+            writer.beginBlock(mMapping.size() * sizeof(EntityId));
+            for (const auto &rec : mMapping)
+            {
+                writer.writeData(&rec.first, sizeof(EntityId));
+            }
+
+            writer.beginBlock(mMapping.size() * sizeof(u64));
+            for (const auto &rec : mMapping)
+            {
+                writer.writeData(&rec.second, sizeof(u64));
+            }
+
+            writer.writeList(mFreeIds);
+            writer.writeList(mList);
+
+            return writer.good();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename CT>
+    bool ComponentHolderMapList<CT>::loadSnapshot(SnapshotReader &reader) noexcept
+    {
+        try {
+            u64 compSize{0u};
+            u64 count{0u};
+            if (!reader.read(compSize) || compSize != sizeof(CT) || !reader.read(count))
+            {
+                return false;
+            }
+
+            u64 idsSize{0u};
+            u64 indexesSize{0u};
+            const u8 *ids{static_cast<const u8*>(reader.readBlock(idsSize))};
+            const u8 *indexes{static_cast<const u8*>(reader.readBlock(indexesSize))};
+            decltype(mFreeIds) freeIds(mFreeIds.getAllocator());
+            decltype(mList) list(mList.getAllocator());
+            if (!ids || !indexes ||
+                idsSize != count * sizeof(EntityId) ||
+                indexesSize != count * sizeof(u64) ||
+                !reader.readList(freeIds) || !reader.readList(list))
+            {
+                return false;
+            }
+
+            if (reader.validating())
+            {
+                return true;
+            }
+
+            mMapping.clear();
+            for (u64 iii = 0; iii < count; ++iii)
+            {
+                EntityId id;
+                u64 index{0u};
+                std::memcpy(&id, ids + iii * sizeof(EntityId), sizeof(EntityId));
+                std::memcpy(&index, indexes + iii * sizeof(u64), sizeof(u64));
+
+                // IDs are sorted, so each record is inserted at the end.
+                mMapping.emplace_hint(mMapping.end(), id, index);
+            }
+            mFreeIds.swap(freeIds);
+            mList.swap(list);
+
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename CT>
+    bool ComponentHolderMapList<CT>::copyFrom(const BaseComponentHolderBase &source) noexcept
+    {
+        const ComponentHolderMapList *holder{dynamic_cast<const ComponentHolderMapList*>(&source)};
+        if (!holder)
+        {
+            return false;
+        }
+
+        try {
+            if (holder != this)
+            {
+                mMapping = holder->mMapping;
+                // Lists reuse their memory and copy the data as a single block.
+                mFreeIds = holder->mFreeIds;
+                mList = holder->mList;
+            }
+
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    template <typename CT>
+    MemoryUsage ComponentHolderMapList<CT>::memoryUsage(u64 count) const noexcept
+    {
+        MemoryUsage result{MemoryUsage::ofNodes(mMapping)};
+
+        result += MemoryUsage::ofList(mFreeIds);
+        // Free Components are holes in the list.
+        MemoryUsage list{MemoryUsage::ofList(mList)};
+        list.live -= mFreeIds.size() * sizeof(CT);
+        result += list;
+
+        return result;
+    }
     // ComponentHolderMapList implementation end.
 
     // ComponentHolderList implementation.
@@ -224,9 +531,27 @@ namespace ent
         //return add(id, std::forward<const CT&>(comp));
     }
 
+    template <typename CT>
+    inline CT *ComponentHolderList<CT>::replace(EntityId id, CT &&comp) noexcept
+    {
+        if (id.index() >= mList.size())
+        {
+            try {
+                mList.resize(id.index() + 1);
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        CT *result{&mList[id.index()]};
+        *result = std::move(comp);
+
+        return result;
+    }
+
     template <typename CT>
     template <typename... CArgTs>
-    CT *ComponentHolderList<CT>::add(EntityId id, CArgTs... cArgs) noexcept
+    CT *ComponentHolderList<CT>::add(EntityId id, CArgTs &&...cArgs) noexcept
     {
         if (id.index() >= mList.size())
         {
@@ -272,9 +597,80 @@ namespace ent
     }
 
     template <typename CT>
-    bool ComponentHolderList<CT>::remove(EntityId id) noexcept
+    CT *ComponentHolderList<CT>::data() noexcept
+    { return mList.data(); }
+
+    template <typename CT>
+    const CT *ComponentHolderList<CT>::data() const noexcept
+    { return mList.data(); }
+
+    template <typename CT>
+    bool ComponentHolderList<CT>::remove(EntityId /*id*/) noexcept
     {
         return true;
     }
+
+    template <typename CT>
+    bool ComponentHolderList<CT>::saveSnapshot(SnapshotWriter &writer) const noexcept
+    {
+        try {
+            writer.write<u64>(sizeof(CT));
+            writer.writeList(mList);
+
+            return writer.good();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename CT>
+    bool ComponentHolderList<CT>::loadSnapshot(SnapshotReader &reader) noexcept
+    {
+        try {
+            u64 compSize{0u};
+            decltype(mList) list(mList.getAllocator());
+            if (!reader.read(compSize) || compSize != sizeof(CT) || !reader.readList(list))
+            {
+                return false;
+            }
+
+            if (!reader.validating())
+            {
+                mList.swap(list);
+            }
+
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    template <typename CT>
+    bool ComponentHolderList<CT>::copyFrom(const BaseComponentHolderBase &source) noexcept
+    {
+        const ComponentHolderList *holder{dynamic_cast<const ComponentHolderList*>(&source)};
+        if (!holder)
+        {
+            return false;
+        }
+
+        try {
+            // List reuses its memory and copies the data as a single block.
+            mList = holder->mList;
+
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    template <typename CT>
+    MemoryUsage ComponentHolderList<CT>::memoryUsage(u64 count) const noexcept
+    {
+        // Components are addressed by the Entity index, unused indices are holes.
+        MemoryUsage result{MemoryUsage::ofList(mList)};
+        result.live = (count < mList.size() ? count : mList.size()) * sizeof(CT);
+
+        return result;
+    }
     // ComponentHolderList implementation end.
 } // namespace ent
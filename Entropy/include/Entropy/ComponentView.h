@@ -0,0 +1,216 @@
+/**
+ * @file Entropy/ComponentView.h
+ * @author Tomas Polasek
+ * @brief Versioned read-only view of Components, readable from other threads.
+ */
+
+#ifndef ECS_FIT_COMPONENTVIEW_H
+#define ECS_FIT_COMPONENTVIEW_H
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Types.h"
+#include "Util.h"
+#include "EntityId.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Base class for ComponentViews, used by the Universe
+     * to update all of the views.
+     */
+    class BaseComponentView : NonCopyable
+    {
+    public:
+        virtual ~BaseComponentView() = default;
+
+        /**
+         * Copy Component of given Entity into the next version.
+         * @param id ID of the Entity.
+         * @param comp Ptr to the Component, or nullptr if
+         *   the Entity does not have it.
+         */
+        virtual void update(EntityId id, const void *comp) = 0;
+
+        /**
+         * Publish the next version, if it contains any changes.
+         * @return Returns false, if the version could not be
+         *   published, because all of the versions are in use.
+         *   Changes are published with the next version.
+         */
+        virtual bool publish() = 0;
+
+        /// Remove all Components from the next version.
+        virtual void clear() = 0;
+    private:
+    protected:
+    }; // class BaseComponentView
+
+    /**
+     * Versioned read-only view of Components of a single type.
+     * Versions are published by the Universe at the end of
+     * refresh, readers on other threads pin the current version
+     * without locking and read it, while the Universe continues
+     * with the next frame.
+     * Components are stored in pages of ENT_VIEW_PAGE_SIZE
+     * Entities. Pages are shared between versions and copied
+     * only when they contain changed Entities (copy-on-write).
+     * Publishing never waits for readers, when all of the
+     * ENT_VIEW_VERSIONS versions are in use, publishing is
+     * postponed to the next refresh.
+     * @tparam ComponentT Type of the Component, has to be
+     *   trivially copyable.
+     */
+    template <typename ComponentT>
+    class ComponentView final : public BaseComponentView
+    {
+    private:
+        static_assert(std::is_trivially_copyable<ComponentT>::value,
+                      "Only trivially copyable Components can be viewed!");
+
+        /// Number of Entities per page.
+        static constexpr u64 PAGE_SIZE{ENT_VIEW_PAGE_SIZE};
+
+        /// Components of a contiguous range of Entity indices.
+        struct Page
+        {
+            /// Which Entities have the Component.
+            InfoBitset<PAGE_SIZE> present;
+            /// Generations of Entities with the Component.
+            EIdType generations[PAGE_SIZE];
+            /// Storage for the Components.
+            typename std::aligned_storage<sizeof(ComponentT), alignof(ComponentT)>::type data[PAGE_SIZE];
+        }; // struct Page
+
+        /// Published state of the Components.
+        struct Version
+        {
+            /// Number of readers using this version.
+            mutable std::atomic<u64> readers{0u};
+            /// Number of this version, starting at 1.
+            u64 number{0u};
+            /// Pages of this version, nullptr for empty pages.
+            std::vector<std::shared_ptr<const Page>> pages;
+        }; // struct Version
+    public:
+        /**
+         * Pinned version of the view. Version stays unchanged,
+         * until the reader is destroyed. Reader should be held
+         * only for a short time, since pinned versions cannot
+         * be reused for newer versions.
+         */
+        class Reader final
+        {
+        public:
+            Reader(const Reader &other) = delete;
+            Reader &operator=(const Reader &rhs) = delete;
+
+            Reader(Reader &&other) :
+                mVersion{other.mVersion}
+            { other.mVersion = nullptr; }
+
+            /// Release the pinned version.
+            inline ~Reader();
+
+            /// Does this reader contain any version?
+            bool valid() const
+            { return mVersion != nullptr; }
+
+            /// Number of the pinned version, 0 for invalid reader.
+            u64 version() const
+            { return mVersion ? mVersion->number : 0u; }
+
+            /**
+             * Get Component of given Entity.
+             * @param id ID of the Entity.
+             * @return Returns ptr to the Component, or nullptr, if
+             *   the Entity did not have it in this version.
+             */
+            inline const ComponentT *get(EntityId id) const;
+
+            /**
+             * Call given function for each Entity, which has
+             * the Component in this version, in the order of
+             * Entity indices.
+             * @tparam FunT Type of the function, called as
+             *   fun(EntityId, const ComponentT&).
+             * @param fun The function.
+             */
+            template <typename FunT>
+            inline void foreach(FunT fun) const;
+        private:
+            friend class ComponentView;
+
+            /// Take ownership of already pinned version.
+            Reader(const Version *version) :
+                mVersion{version}
+            { }
+
+            /// The pinned version.
+            const Version *mVersion;
+        protected:
+        }; // class Reader
+
+        /// Create empty view, without any published version.
+        inline ComponentView();
+
+        /**
+         * Pin the current version.
+         * @return Returns reader of the current version, which
+         *   is invalid, if no version has been published yet.
+         * @remarks Is thread-safe and lock-free.
+         */
+        inline Reader acquire() const;
+
+        /**
+         * Number of the current version, 0 if no version
+         * has been published yet.
+         * @remarks Is thread-safe.
+         */
+        inline u64 version() const;
+
+        /**
+         * Copy Component of given Entity into the next version.
+         * @param id ID of the Entity.
+         * @param comp Ptr to the Component, or nullptr if
+         *   the Entity does not have it.
+         * @remarks Not thread-safe, only used by the Universe.
+         */
+        inline virtual void update(EntityId id, const void *comp) override final;
+
+        /**
+         * Publish the next version, if it contains any changes.
+         * @return Returns false, if the version could not be
+         *   published, because all of the versions are in use.
+         * @remarks Not thread-safe, only used by the Universe.
+         */
+        inline virtual bool publish() override final;
+
+        /**
+         * Remove all Components from the next version.
+         * @remarks Not thread-safe, only used by the Universe.
+         */
+        inline virtual void clear() override final;
+    private:
+        /// Working copy of the pages, used for the next version.
+        std::vector<std::shared_ptr<Page>> mPages;
+        /// Have the pages changed since the last published version?
+        bool mChanged;
+        /// Number of the last published version.
+        u64 mLastNumber;
+        /// Storage for the versions.
+        Version mVersions[ENT_VIEW_VERSIONS];
+        /// The current version.
+        std::atomic<Version*> mCurrent;
+    protected:
+    }; // class ComponentView
+} // namespace ent
+
+#include "ComponentView.inl"
+
+#endif //ECS_FIT_COMPONENTVIEW_H
@@ -0,0 +1,180 @@
+/**
+ * @file Entropy/ComponentView.inl
+ * @author Tomas Polasek
+ * @brief Versioned read-only view of Components, readable from other threads.
+ */
+
+#include "ComponentView.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    // ComponentView::Reader implementation.
+    template <typename ComponentT>
+    ComponentView<ComponentT>::Reader::~Reader()
+    {
+        if (mVersion)
+        {
+            mVersion->readers.fetch_sub(1u);
+        }
+    }
+
+    template <typename ComponentT>
+    const ComponentT *ComponentView<ComponentT>::Reader::get(EntityId id) const
+    {
+        const u64 page{id.index() / PAGE_SIZE};
+        const u64 pos{id.index() % PAGE_SIZE};
+        if (!mVersion || page >= mVersion->pages.size() || !mVersion->pages[page])
+        {
+            return nullptr;
+        }
+
+        const Page &p(*mVersion->pages[page]);
+        return (p.present.test(pos) && p.generations[pos] == id.generation()) ?
+               reinterpret_cast<const ComponentT*>(&p.data[pos]) : nullptr;
+    }
+
+    template <typename ComponentT>
+    template <typename FunT>
+    void ComponentView<ComponentT>::Reader::foreach(FunT fun) const
+    {
+        if (!mVersion)
+        {
+            return;
+        }
+
+        for (u64 page = 0; page < mVersion->pages.size(); ++page)
+        {
+            if (!mVersion->pages[page])
+            {
+                continue;
+            }
+
+            const Page &p(*mVersion->pages[page]);
+            for (u64 pos = p.present.findNext(0u); pos < PAGE_SIZE; pos = p.present.findNext(pos + 1u))
+            {
+                fun(EntityId(static_cast<EIdType>(page * PAGE_SIZE + pos), p.generations[pos]),
+                    *reinterpret_cast<const ComponentT*>(&p.data[pos]));
+            }
+        }
+    }
+    // ComponentView::Reader implementation end.
+
+    // ComponentView implementation.
+    template <typename ComponentT>
+    ComponentView<ComponentT>::ComponentView() :
+        mChanged{false}, mLastNumber{0u}, mCurrent{nullptr}
+    { }
+
+    template <typename ComponentT>
+    auto ComponentView<ComponentT>::acquire() const -> Reader
+    {
+        Version *version{mCurrent.load()};
+        while (version)
+        {
+            version->readers.fetch_add(1u);
+            Version *current{mCurrent.load()};
+            if (current == version)
+            { // Version cannot be reused, while it is pinned.
+                break;
+            }
+
+            // Version has been replaced in the meantime.
+            version->readers.fetch_sub(1u);
+            version = current;
+        }
+
+        return Reader(version);
+    }
+
+    template <typename ComponentT>
+    u64 ComponentView<ComponentT>::version() const
+    {
+        Reader reader{acquire()};
+        return reader.version();
+    }
+
+    template <typename ComponentT>
+    void ComponentView<ComponentT>::update(EntityId id, const void *comp)
+    {
+        const u64 page{id.index() / PAGE_SIZE};
+        const u64 pos{id.index() % PAGE_SIZE};
+        if (page >= mPages.size())
+        {
+            if (!comp)
+            { // Nothing to remove.
+                return;
+            }
+            mPages.resize(page + 1u);
+        }
+
+        std::shared_ptr<Page> &p(mPages[page]);
+        if (!p)
+        {
+            if (!comp)
+            {
+                return;
+            }
+            p = std::make_shared<Page>();
+        }
+        else if (p.use_count() > 1)
+        { // Page is used by published versions.
+            p = std::make_shared<Page>(*p);
+        }
+
+        if (comp)
+        {
+            p->present.set(pos);
+            p->generations[pos] = id.generation();
+            std::memcpy(&p->data[pos], comp, sizeof(ComponentT));
+        }
+        else
+        {
+            p->present.reset(pos);
+        }
+
+        mChanged = true;
+    }
+
+    template <typename ComponentT>
+    bool ComponentView<ComponentT>::publish()
+    {
+        if (!mChanged)
+        {
+            return true;
+        }
+
+        Version *current{mCurrent.load()};
+        for (Version &version : mVersions)
+        {
+            /*
+             * Readers pin the version before checking, that it
+             * is still current, so unpinned version, which is
+             * not current, cannot be pinned by anyone.
+             */
+            if (&version == current || version.readers.load() != 0u)
+            {
+                continue;
+            }
+
+            version.pages.assign(mPages.begin(), mPages.end());
+            version.number = ++mLastNumber;
+            mCurrent.store(&version);
+            mChanged = false;
+
+            return true;
+        }
+
+        // All of the versions are used, try again on next refresh.
+        return false;
+    }
+
+    template <typename ComponentT>
+    void ComponentView<ComponentT>::clear()
+    {
+        // Published versions keep their own pages.
+        mPages.clear();
+        mChanged = true;
+    }
+    // ComponentView implementation end.
+} // namespace ent
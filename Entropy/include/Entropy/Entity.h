@@ -195,7 +195,7 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *add(CArgTs... cArgs);
+        inline ComponentT *add(CArgTs &&...cArgs);
 
         /**
          * Add Component to this Entity.
@@ -224,7 +224,7 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addD(CArgTs... cArgs);
+        inline ComponentT *addD(CArgTs &&...cArgs);
 
         /**
          * Remove Component from this Entity.
@@ -448,7 +448,7 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *add(CArgTs... cArgs);
+        inline ComponentT *add(CArgTs &&...cArgs);
 
         /**
          * Remove temporary Component from this Entity.
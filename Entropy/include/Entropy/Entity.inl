@@ -96,7 +96,7 @@ namespace ent
     template <typename UniverseT>
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *Entity<UniverseT>::add(CArgTs... cArgs)
+    ComponentT *Entity<UniverseT>::add(CArgTs &&...cArgs)
     { return mUniverse->template addComponent<ComponentT>(mId, std::forward<CArgTs>(cArgs)...); }
 
     template <typename UniverseT>
@@ -107,7 +107,7 @@ namespace ent
     template <typename UniverseT>
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *Entity<UniverseT>::addD(CArgTs... cArgs)
+    ComponentT *Entity<UniverseT>::addD(CArgTs &&...cArgs)
     { return mUniverse->template addComponentD<ComponentT>(mId, std::forward<CArgTs>(cArgs)...); }
 
     template <typename UniverseT>
@@ -202,7 +202,7 @@ namespace ent
     template <typename UniverseT>
     template<typename ComponentT,
              typename... CArgTs>
-    ComponentT *TemporaryEntity<UniverseT>::add(CArgTs... cArgs)
+    ComponentT *TemporaryEntity<UniverseT>::add(CArgTs &&...cArgs)
     { return mUniverse->template addComponentT<ComponentT>(mId, std::forward<CArgTs>(cArgs)...); }
 
     template <typename UniverseT>
@@ -171,6 +171,227 @@ namespace ent
     protected:
     }; // class EntityList
 
+    /**
+     * Contiguous span of Entity IDs with consecutive indices.
+     * Components stored in index-addressed holders are
+     * also contiguous for the whole chunk.
+     */
+    class EntityChunk final
+    {
+    public:
+        /**
+         * Create chunk from given range.
+         * @param begin First Entity ID in the chunk.
+         * @param end Pointer behind the last Entity ID.
+         */
+        EntityChunk(const EntityId *begin, const EntityId *end) :
+            mBegin{begin}, mEnd{end} { }
+
+        /// Get begin iterator.
+        const EntityId *begin() const
+        { return mBegin; }
+
+        /// Get end iterator.
+        const EntityId *end() const
+        { return mEnd; }
+
+        /// Number of Entities in this chunk.
+        u64 size() const
+        { return static_cast<u64>(mEnd - mBegin); }
+
+        /// Index of the first Entity, following Entities have consecutive indices.
+        EIdType firstIndex() const
+        { return mBegin->index(); }
+
+        /// Access operator.
+        const EntityId &operator[](u64 pos) const
+        { return mBegin[pos]; }
+    private:
+        /// First Entity ID in the chunk.
+        const EntityId *mBegin;
+        /// Pointer behind the last Entity ID.
+        const EntityId *mEnd;
+    protected:
+    }; // class EntityChunk
+
+    /**
+     * Iterator over EntityChunks within sorted range
+     * of Entity IDs.
+     */
+    class EntityChunkIterator final
+    {
+    public:
+        /**
+         * Create iterator pointing to a chunk starting at given position.
+         * @param it Start of the chunk.
+         * @param end End of the whole range.
+         */
+        EntityChunkIterator(const EntityId *it, const EntityId *end) :
+            mChunk{it, chunkEnd(it, end)}, mEnd{end} { }
+
+        /// Prefix increment.
+        EntityChunkIterator &operator++()
+        {
+            mChunk = EntityChunk(mChunk.end(), chunkEnd(mChunk.end(), mEnd));
+            return *this;
+        }
+
+        /// Equality comparison operator.
+        bool operator==(const EntityChunkIterator &rhs) const
+        { return mChunk.begin() == rhs.mChunk.begin(); }
+
+        /// Inequality comparison operator.
+        bool operator!=(const EntityChunkIterator &rhs) const
+        { return !(*this == rhs); }
+
+        /// Access operator.
+        const EntityChunk &operator*() const
+        { return mChunk; }
+
+        /// Access operator.
+        const EntityChunk *operator->() const
+        { return &mChunk; }
+    private:
+        /**
+         * Find end of chunk starting at given position.
+         * @param it Start of the chunk.
+         * @param end End of the whole range.
+         * @return Returns pointer behind the last Entity in the chunk.
+         */
+        static const EntityId *chunkEnd(const EntityId *it, const EntityId *end)
+        {
+            if (it == end)
+            {
+                return end;
+            }
+
+            EIdType nextIndex{it->index() + 1u};
+            for (++it; it != end && it->index() == nextIndex; ++it, ++nextIndex);
+
+            return it;
+        }
+
+        /// Current chunk.
+        EntityChunk mChunk;
+        /// End of the whole range.
+        const EntityId *mEnd;
+    protected:
+    }; // class EntityChunkIterator
+
+    /**
+     * Helper object, used in foreach loops over EntityChunks.
+     */
+    class EntityChunkList final
+    {
+    public:
+        /**
+         * Create iterable object over given sorted range.
+         * @param begin Start of the range.
+         * @param end End of the range.
+         */
+        EntityChunkList(const EntityId *begin, const EntityId *end) :
+            mBegin{begin}, mEnd{end} { }
+
+        /// Get begin iterator.
+        EntityChunkIterator begin() const
+        { return EntityChunkIterator(mBegin, mEnd); }
+
+        /// Get end iterator.
+        EntityChunkIterator end() const
+        { return EntityChunkIterator(mEnd, mEnd); }
+    private:
+        /// Start of the range.
+        const EntityId *mBegin;
+        /// End of the range.
+        const EntityId *mEnd;
+    protected:
+    }; // class EntityChunkList
+
+    /**
+     * Handle owning a contiguous range of sorted Entity IDs,
+     * allowing direct writes to existing Components of the
+     * owned Entities. Ranges given to different threads are
+     * disjoint, so the writes do not need to be deferred
+     * through ChangeSets. Adding and removing of Components
+     * still has to be deferred.
+     * Ownership of the written Entities is checked in debug builds.
+     * @code
+     * for (auto &e : writer)
+     * {
+     *     writer.write<Position>(e.id())->x += 1.0f;
+     * }
+     * @endcode
+     * @tparam UniverseT Type of the Universe.
+     */
+    template <typename UniverseT>
+    class PartitionWriter final
+    {
+    public:
+        using IteratorT = EntityGroupIterator<UniverseT, const EntityId*>;
+
+        /**
+         * Create writer for given range.
+         * @param uni Universe instance pointer.
+         * @param begin First owned Entity ID.
+         * @param end Pointer behind the last owned Entity ID.
+         */
+        PartitionWriter(UniverseT *uni, const EntityId *begin, const EntityId *end) :
+            mUniverse{uni}, mBegin{begin}, mEnd{end} { }
+
+        /// Get begin iterator.
+        IteratorT begin() const
+        { return IteratorT(mUniverse, mBegin); }
+
+        /// Get end iterator.
+        IteratorT end() const
+        { return IteratorT(mUniverse, mEnd); }
+
+        /// Number of owned Entities.
+        u64 size() const
+        { return static_cast<u64>(mEnd - mBegin); }
+
+        /**
+         * Is given Entity in the range of this writer?
+         * @param id ID of the Entity.
+         * @return Returns true, if the Entity is owned.
+         */
+        bool owns(EntityId id) const
+        { return std::binary_search(mBegin, mEnd, id); }
+
+        /**
+         * Get existing Component of an owned Entity,
+         * for direct modification. The Entity is marked
+         * as written, so the change is recorded in deltas
+         * and published in ComponentViews.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity, has to be in the range
+         *   of this writer.
+         * @return Returns ptr to the Component, or nullptr,
+         *   if the Entity does not have such Component.
+         * @remarks Is thread-safe, if the ranges of the
+         *   writers are disjoint.
+         */
+        template <typename ComponentT>
+        ComponentT *write(EntityId id)
+        {
+            ENT_ASSERT_SLOW(owns(id));
+            ComponentT *result{mUniverse->template getComponent<ComponentT>(id)};
+            if (result)
+            {
+                mUniverse->markWritten(id);
+            }
+            return result;
+        }
+    private:
+        /// Universe instance pointer.
+        UniverseT *mUniverse;
+        /// First owned Entity ID.
+        const EntityId *mBegin;
+        /// Pointer behind the last owned Entity ID.
+        const EntityId *mEnd;
+    protected:
+    }; // class PartitionWriter
+
     /**
      * Helper object, used in parallel foreach loops.
      * @tparam UniverseT Type of the Universe.
@@ -229,6 +450,24 @@ namespace ent
          *   used in ranged for loop.
          */
         EntityList<UniverseT, IterationHelper> forThread(u64 threadId);
+
+        /**
+         * Get chunk iteration object for given thread.
+         * @param threadId Which thread is being used.
+         * @return Returns object, which can be used in ranged
+         *   for loop, iterating over EntityChunks.
+         */
+        EntityChunkList chunksForThread(u64 threadId);
+
+        /**
+         * Get partitioned writer for given thread. The writer
+         * allows direct modification of existing Components of
+         * the Entities in the range of the thread.
+         * @param threadId Which thread is being used.
+         * @return Returns the writer, which can also be used
+         *   in ranged for loop.
+         */
+        PartitionWriter<UniverseT> writerForThread(u64 threadId);
     private:
         /// Universe instance pointer.
         UniverseT *mUniverse;
@@ -272,6 +511,16 @@ namespace ent
         u64 id() const
         { return mId; }
 
+        /**
+         * Get the parent Group. Filter of this Group is a
+         * refinement of the parent filter, so only members
+         * of the parent Group need to be checked.
+         * @return Returns ptr to the parent Group, or nullptr,
+         *   if this Group has no parent.
+         */
+        const EntityGroup *parent() const
+        { return mParent; }
+
         /// Return the usage counter.
         u64 usage() const
         { return mUsageCounter; }
@@ -316,6 +565,26 @@ namespace ent
         EntityListParallel<UT, EntityListT, false> foreachP(UT *uni, u64 numThreads)
         { return EntityListParallel<UT, EntityListT, false>(uni, *entitiesFront(), numThreads); }
 
+        /**
+         * Get iterator object, iterating over contiguous chunks
+         * of Entities with consecutive indices.
+         * @return Returns object, which can be used in foreach loop.
+         */
+        EntityChunkList chunks()
+        { return EntityChunkList(entitiesFront()->begin(), entitiesFront()->end()); }
+
+        /**
+         * Get partitioned writer for given range of Entities.
+         * @tparam UT Universe type.
+         * @param uni Universe ptr.
+         * @param begin Position of the first Entity in the range.
+         * @param end Position behind the last Entity in the range.
+         * @return Returns the writer.
+         */
+        template <typename UT>
+        PartitionWriter<UT> partition(UT *uni, u64 begin, u64 end)
+        { return PartitionWriter<UT>(uni, entitiesFront()->begin() + begin, entitiesFront()->begin() + end); }
+
         /**
          * Get foreach iterator object, iterating over added Entities.
          * @tparam UT Universe type.
@@ -390,16 +659,45 @@ namespace ent
          */
         inline void remove(EntityId id);
 
+        /**
+         * Remove destroyed Entity from this group, before
+         * the next refresh. Removal is reported by the
+         * next refresh.
+         * @param id ID of the Entity.
+         */
+        inline void removeDestroyed(EntityId id);
+
         /**
          * Refresh this Group - clear added/removed lists.
+         * @param frame Resource, which is used for the new
+         *   added/removed lists. They are re-created on each
+         *   refresh, so they can use the frame arena. When
+         *   nullptr is used, the lists are moved out of the
+         *   frame arena.
          */
-        inline void refresh();
+        inline void refresh(MemoryResource *frame);
 
         /**
          * Finalize adding and removing of Entities.
          */
         inline void finalize();
 
+        /// Number of Entities added during the last refresh.
+        u64 numAdded() const
+        { return mAdded.size(); }
+
+        /// Number of Entities removed during the last refresh.
+        u64 numRemoved() const
+        { return mRemoved.size(); }
+
+        /**
+         * Memory used by the front and back Entity buffers
+         * and by the destroyed Entities.
+         * Added and removed lists are transient and they
+         * are accounted for in the frame arena.
+         */
+        inline MemoryUsage memoryUsage() const;
+
         /// Get the front Entity buffer.
         EntityListT *entitiesFront()
         { return mEntities; }
@@ -414,6 +712,10 @@ namespace ent
         EntityFilter mFilter;
         /// ID of this Group.
         u64 mId;
+        /// Group, whose members are superset of members of this Group.
+        EntityGroup *mParent;
+        /// Conditions of the filter, which are not checked by the parent Group.
+        EntityFilter mResidual;
         /// List of Entities, corresponding with the filter.
         EntityListT *mEntities;
         /// List of Entities, corresponding with the filter.
@@ -424,8 +726,12 @@ namespace ent
         AddedListT mAdded;
         /// List of Entities, which were removed since the last refresh.
         RemovedListT mRemoved;
+        /// Destroyed Entities removed before the next refresh.
+        RemovedListT mDestroyed;
         /// "Reference" counter of how many objects are using this Group.
         u64 mUsageCounter;
+        /// Resource used by this Group, outside of the frame arena.
+        MemoryResource *mMemory;
     protected:
     }; // EntityGroup
 
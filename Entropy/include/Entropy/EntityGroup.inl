@@ -63,13 +63,48 @@ namespace ent
             return EntityList<UniverseT, IterationHelper>(mUniverse, sEmptyHelper);
         }
     }
+
+    template <typename UniverseT,
+              typename IteratedT,
+              bool IsConst>
+    EntityChunkList EntityListParallel<UniverseT, IteratedT, IsConst>::chunksForThread(u64 threadId)
+    {
+        if (threadId < mHelpers.size() && mHelpers[threadId].begin() != mHelpers[threadId].end())
+        {
+            return EntityChunkList(&*mHelpers[threadId].begin(), &*mHelpers[threadId].begin() +
+                                                                 mHelpers[threadId].size());
+        }
+        else
+        {
+            return EntityChunkList(nullptr, nullptr);
+        }
+    }
+
+    template <typename UniverseT,
+              typename IteratedT,
+              bool IsConst>
+    PartitionWriter<UniverseT> EntityListParallel<UniverseT, IteratedT, IsConst>::writerForThread(u64 threadId)
+    {
+        if (threadId < mHelpers.size() && mHelpers[threadId].begin() != mHelpers[threadId].end())
+        {
+            const EntityId *begin{&*mHelpers[threadId].begin()};
+            return PartitionWriter<UniverseT>(mUniverse, begin, begin + mHelpers[threadId].size());
+        }
+        else
+        {
+            return PartitionWriter<UniverseT>(mUniverse, nullptr, nullptr);
+        }
+    }
     // EntityListParallel implementation end.
 
     // EntityGroup implementation.
     EntityGroup::EntityGroup(const EntityFilter &filter, u64 groupId) :
         mFilter{filter},
         mId{groupId},
-        mUsageCounter{0u}
+        mParent{nullptr},
+        mResidual{filter},
+        mUsageCounter{0u},
+        mMemory{MemoryResource::current()}
     {
         mEntities = &mEntityBuffers[0];
         mEntitiesBack = &mEntityBuffers[1];
@@ -96,6 +131,7 @@ namespace ent
         mEntityBuffers[1].reclaim();
         mAdded.reclaim();
         mRemoved.reclaim();
+        mDestroyed.reclaim();
     }
 
     void EntityGroup::add(EntityId id)
@@ -110,12 +146,31 @@ namespace ent
         mRemoved.pushBack(id);
     }
 
-    void EntityGroup::refresh()
+    void EntityGroup::removeDestroyed(EntityId id)
     {
-        mAdded.clear();
-        mAdded.shrinkToFit();
-        mRemoved.clear();
-        mAdded.shrinkToFit();
+        mDestroyed.pushBack(id);
+    }
+
+    void EntityGroup::refresh(MemoryResource *frame)
+    {
+        // Lists of the last refresh stay in the previous frame.
+        AddedListT(frame ? frame : mMemory).swap(mAdded);
+        RemovedListT(frame ? frame : mMemory).swap(mRemoved);
+
+        for (EntityId id : mDestroyed)
+        { // Index may have been reused by a new Entity.
+            mRemoved.pushBack(id);
+        }
+        mDestroyed.clear();
+    }
+
+    MemoryUsage EntityGroup::memoryUsage() const
+    {
+        MemoryUsage result{MemoryUsage::ofList(mEntityBuffers[0])};
+        result += MemoryUsage::ofList(mEntityBuffers[1]);
+        result += MemoryUsage::ofList(mDestroyed);
+
+        return result;
     }
 
     void EntityGroup::finalize()
@@ -149,8 +204,10 @@ namespace ent
              * Merge-sort mAdded and entities front buffer, while removing Entities
              * from the mRemoved list.
              * All 3 lists are sorted and contain only unique elements.
-             * mAdded and mRemoved do not contain same elements.
-             * mAdded and entities front buffer do not contain same elements.
+             * mAdded and mRemoved contain the same element only when
+             *   index of a destroyed Entity has been reused.
+             * mAdded and entities front buffer contain the same element
+             *   only when it is also in mRemoved.
              * Each element in mRemoved MUST be in entities front buffer.
              */
 
@@ -499,6 +499,17 @@ namespace ent
         bool hasComponent(EntityId id, u64 index) const
         { return mEntities.hasComponent(id, index); }
 
+        /**
+         * Mark all Components of given Entity as not present.
+         * @tparam FunT Type of the function, called as fun(CIdType)
+         *   for each Component, which has been present.
+         * @param id ID of the Entity.
+         * @param fun The function.
+         */
+        template <typename FunT>
+        void removeComponents(EntityId id, FunT fun)
+        { mEntities.removeComponents(id, fun); }
+
         /**
          * Get the current generation for given
          * Entity index.
@@ -508,6 +519,14 @@ namespace ent
         EIdType currentGen(EIdType index) const
         { return mEntities.currentGen(index); }
 
+        /**
+         * Get index behind the last Entity, which
+         * has ever been created.
+         * @return Returns the end index.
+         */
+        EIdType endIndex() const
+        { return mEntities.endIndex(); }
+
         /**
          * Set activity of given Entity to
          * desired value.
@@ -544,6 +563,26 @@ namespace ent
         bool destroy(EntityId id)
         { return mEntities.destroy(id); }
 
+        /// Indexes of Entities destroyed since the last clearDestroyed.
+        const ent::List<EIdType> &destroyedIndexes() const
+        { return mEntities.destroyedIndexes(); }
+
+        /**
+         * Forget the destroyed Entities, called once they
+         * have been removed from the Component holders and
+         * EntityGroups.
+         */
+        void clearDestroyed()
+        { mEntities.clearDestroyed(); }
+
+        /**
+         * Will the next create use index of a destroyed
+         * Entity, which may still be in Component holders
+         * or EntityGroups?
+         */
+        bool createReusesDestroyed() const
+        { return mEntities.createReusesDestroyed(); }
+
         /**
          * Checks validity of given Entity.
          * @param id ID of the Entity.
@@ -618,6 +657,71 @@ namespace ent
          */
         void removeGroup(u64 groupId)
         { mEntities.removeGroup(groupId); }
+
+        /**
+         * Write the Entity metadata to the snapshot.
+         * @param writer The snapshot writer.
+         */
+        void saveSnapshot(SnapshotWriter &writer) const
+        { mEntities.saveSnapshot(writer); }
+
+        /**
+         * Replace the Entity metadata with data from the snapshot.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the load has been successful.
+         */
+        bool loadSnapshot(SnapshotReader &reader)
+        { return mEntities.loadSnapshot(reader); }
+
+        /**
+         * Replace the Entity metadata with copy of metadata
+         * from another manager.
+         * @param source Manager to copy the metadata from.
+         * @return Returns true, if the copy has been successful.
+         */
+        bool copyFrom(const EntityManager &source)
+        { return mEntities.copyFrom(source.mEntities); }
+
+        /**
+         * Write number of Entities and changes of the free
+         * index list since the last delta.
+         * @param writer The snapshot writer.
+         */
+        void saveDelta(SnapshotWriter &writer)
+        { mEntities.saveDelta(writer); }
+
+        /**
+         * Apply number of Entities and changes of the free
+         * index list written by saveDelta.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the load has been successful.
+         */
+        bool loadDelta(SnapshotReader &reader)
+        { return mEntities.loadDelta(reader); }
+
+        /// Start the next delta from the current state.
+        void resetDelta()
+        { mEntities.resetDelta(); }
+
+        /**
+         * Overwrite generation and flags of given Entity.
+         * @param id Index and the new generation of the Entity.
+         * @param created Should the Entity exist?
+         * @param active Should the Entity be active?
+         * @param previous ID of the Entity before the change is
+         *   returned here, invalid ID, if it has not existed.
+         * @return Returns false, if the index is out of range.
+         */
+        bool setState(EntityId id, bool created, bool active, EntityId &previous)
+        { return mEntities.setState(id, created, active, previous); }
+
+        /// Count Entities, which have given Component.
+        u64 numComponents(CIdType compId) const
+        { return mEntities.numComponents(compId); }
+
+        /// Fill memory used by the Entity metadata into given report.
+        void memoryUsage(MemoryReport &report) const
+        { mEntities.memoryUsage(report); }
     private:
     protected:
         /// Container for the Entities.
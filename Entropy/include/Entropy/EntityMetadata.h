@@ -15,6 +15,8 @@
 #include "EntityId.h"
 #include "List.h"
 #include "SortedList.h"
+#include "Snapshot.h"
+#include "MemoryReport.h"
 
 /// Main Entropy namespace
 namespace ent
@@ -86,6 +88,32 @@ namespace ent
         /// Compare 2 filters.
         inline bool operator==(const EntityFilter &rhs) const;
 
+        /**
+         * Check, if this filter is a refinement of the other
+         * filter - every Entity passing this filter also passes
+         * the other filter.
+         * @param other The other, more general, filter.
+         * @return Returns true, if all of the other filter
+         *   conditions are also present in this filter.
+         */
+        inline bool refines(const EntityFilter &other) const;
+
+        /**
+         * Create filter containing only conditions, which
+         * are not already present in the other filter.
+         * Required activity is kept.
+         * @param other The other filter.
+         * @return Returns filter with remaining conditions.
+         */
+        inline EntityFilter residual(const EntityFilter &other) const;
+
+        /**
+         * Calculate hash of this filter. Filters which
+         * are equal have the same hash.
+         * @return Returns hash value of this filter.
+         */
+        inline u64 hash() const;
+
         /// Print operator.
         friend inline std::ostream &operator<<(std::ostream &out, const EntityFilter &rhs);
     private:
@@ -98,6 +126,14 @@ namespace ent
          */
         inline bool compPosEqual(const CIdType *rhsCompPos) const;
 
+        /**
+         * Check, if this filter contains given condition.
+         * @param cId ID of the Component.
+         * @param required Required value of the Component.
+         * @return Returns true, if the condition is present.
+         */
+        inline bool hasCondition(CIdType cId, bool required) const;
+
         /// Required value in order to pass this filter.
         FilterBitset mValue;
         /// List of Component position within the filter.
@@ -107,6 +143,13 @@ namespace ent
     protected:
     }; // class EntityFilter
 
+    /// Hashing functor for EntityFilter, used in hash-based containers.
+    struct EntityFilterHash
+    {
+        std::size_t operator()(const EntityFilter &filter) const
+        { return static_cast<std::size_t>(filter.hash()); }
+    }; // struct EntityFilterHash
+
     /**
      * Iterator for read-only iteration over all valid
      * Entities and their metadata.
@@ -345,6 +388,21 @@ namespace ent
          */
         inline u64 capacity() const;
 
+        /**
+         * Count set bits in given column.
+         * @param column Index of the column.
+         * @return Returns the number of set bits.
+         */
+        inline u64 count(u64 column) const;
+
+        /**
+         * Get memory used by the table.
+         * @param liveRows Number of rows, which are in use,
+         *   other rows are considered holes.
+         * @return Returns the memory usage.
+         */
+        inline MemoryUsage memoryUsage(u64 liveRows) const;
+
         /**
          * Get pointer to the first bitset in
          * requested column.
@@ -384,6 +442,34 @@ namespace ent
          * @param column ID of the column.
          */
         inline void setZero(u64 column);
+
+        /**
+         * Zero all bits and change the number of rows,
+         * number of columns stays the same.
+         * @param rows New number of rows.
+         */
+        inline void resetRows(u64 rows);
+
+        /**
+         * Swap content with another group.
+         * @param other The other group.
+         */
+        inline void swap(MetadataGroup &other);
+
+        /**
+         * Write content of this group to the snapshot.
+         * @param writer The snapshot writer.
+         */
+        inline void saveSnapshot(SnapshotWriter &writer) const;
+
+        /**
+         * Replace content of this group with data from
+         * the snapshot.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the load has been
+         *   successful. Content is kept on failure.
+         */
+        inline bool loadSnapshot(SnapshotReader &reader);
     private:
         /// Number of Entities per bitset.
         static constexpr u64 ENT_PER_BITSET{MetadataBitset::size()};
@@ -482,6 +568,89 @@ namespace ent
     protected:
     }; // class MetadataGroup
 
+    /**
+     * Set of Entities changed since the last refresh.
+     * Each Entity index is represented by a single bit, bits
+     * are stored in MetadataBitsets with the same layout as a
+     * single MetadataGroup column. Marking Entity as changed
+     * is O(1) and iteration returns sorted unique indices,
+     * blocks without any changed Entities are skipped.
+     * IDs of destroyed Entities are kept separately, since
+     * their generation cannot be recovered from the index.
+     */
+    class ChangedEntities
+    {
+    public:
+        /// Create empty set.
+        inline ChangedEntities();
+
+        /**
+         * Mark given Entity as changed.
+         * @param id ID of the Entity.
+         */
+        inline void entityChanged(EntityId id);
+
+        /**
+         * Mark given Entity as changed and remember its
+         * ID, which is no longer valid.
+         * @param id ID of the destroyed Entity.
+         */
+        inline void entityDestroyed(EntityId id);
+
+        /**
+         * Has given Entity been marked as changed?
+         * Only the index of the Entity is checked.
+         * @param id ID of the Entity.
+         * @return Returns true, if the Entity is in the set.
+         */
+        inline bool contains(EntityId id) const;
+
+        /**
+         * Call given function for each changed Entity
+         * index, in increasing order.
+         * @tparam FunT Type of the function, called as fun(EIdType).
+         * @param fun The function.
+         */
+        template <typename FunT>
+        inline void forEach(FunT fun) const;
+
+        /// IDs of Entities destroyed since the last clear.
+        const ent::List<EntityId> &destroyed() const
+        { return mDestroyed; }
+
+        /// Number of unique changed Entities.
+        u64 size() const
+        { return mNumChanged; }
+
+        /// Is the set empty?
+        bool empty() const
+        { return mNumChanged == 0u; }
+
+        /// Remove all Entities, memory is kept.
+        inline void clear();
+
+        /// Remove all Entities and free memory.
+        inline void reclaim();
+
+        /// Memory used by the bits and the destroyed list.
+        inline MemoryUsage memoryUsage() const;
+    private:
+        /// Number of Entities per bitset.
+        static constexpr u64 ENT_PER_BITSET{MetadataBitset::size()};
+
+        /// Bits for changed Entities.
+        ent::List<MetadataBitset> mBits;
+        /// IDs of destroyed Entities.
+        ent::List<EntityId> mDestroyed;
+        /// Index of the first bitset containing any changed Entity.
+        u64 mFirstBitset;
+        /// Index behind the last bitset containing any changed Entity.
+        u64 mEndBitset;
+        /// Number of unique changed Entities.
+        u64 mNumChanged;
+    protected:
+    }; // class ChangedEntities
+
     /**
      * Holder for Entity metadata.
      * Structure:
@@ -550,6 +719,17 @@ namespace ent
          */
         inline bool hasComponent(EntityId id, CIdType compId) const;
 
+        /**
+         * Mark all Components of given Entity as not present.
+         * Given function is called for each Component, which
+         * has been present.
+         * @tparam FunT Type of the function, called as fun(CIdType).
+         * @param id ID of the Entity.
+         * @param fun The function.
+         */
+        template <typename FunT>
+        inline void removeComponents(EntityId id, FunT fun);
+
         /**
          * Get the current generation for given
          * Entity index.
@@ -558,6 +738,27 @@ namespace ent
          */
         inline EIdType currentGen(EIdType index) const;
 
+        /**
+         * Get index behind the last Entity, which
+         * has ever been created.
+         * @return Returns the end index.
+         */
+        inline EIdType endIndex() const;
+
+        /**
+         * Count Entities, which have given Component.
+         * @param compId ID of the Component.
+         * @return Returns the number of Entities.
+         */
+        inline u64 numComponents(CIdType compId) const;
+
+        /**
+         * Fill memory used by the columns, generations and
+         * free lists into given report.
+         * @param report Report filled with the usage.
+         */
+        inline void memoryUsage(MemoryReport &report) const;
+
         /**
          * Set activity of given Entity to
          * desired value.
@@ -587,6 +788,30 @@ namespace ent
          */
         inline bool destroy(EntityId id);
 
+        /**
+         * Get indexes of Entities destroyed since the last
+         * call to clearDestroyed. Component holders and
+         * EntityGroups may still contain these Entities.
+         */
+        const ent::List<EIdType> &destroyedIndexes() const
+        { return mDestroyedIndexes; }
+
+        /**
+         * Forget the destroyed Entities, called once they
+         * have been removed from the Component holders and
+         * EntityGroups.
+         */
+        void clearDestroyed()
+        { mDestroyedIndexes.clear(); }
+
+        /**
+         * Will the next create use index of a destroyed
+         * Entity, which may still be in Component holders
+         * or EntityGroups?
+         */
+        bool createReusesDestroyed() const
+        { return mDestroyedIndexes.size() && mFreeIndexes.size() >= ENT_MIN_FREE; }
+
         /**
          * Checks validity of given Entity.
          * Does not check for activity.
@@ -654,6 +879,65 @@ namespace ent
          * @return Returns the iterator.
          */
         inline ValidEntityIterator validEntities() const;
+
+        /**
+         * Write the Entity metadata to the snapshot.
+         * Group flags and EntityGroup IDs are not saved.
+         * @param writer The snapshot writer.
+         */
+        inline void saveSnapshot(SnapshotWriter &writer) const;
+
+        /**
+         * Replace the Entity metadata with data from the
+         * snapshot. Number of Components has to be the same.
+         * Group flags of all Entities are reset.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the load has been
+         *   successful. Metadata are kept on failure.
+         */
+        inline bool loadSnapshot(SnapshotReader &reader);
+
+        /**
+         * Replace the Entity metadata with copy of metadata
+         * from another instance. Number of Components has to be
+         * the same. Already allocated memory is reused, metadata
+         * are copied as whole blocks.
+         * Group flags of all Entities are reset.
+         * @param source Metadata to copy.
+         * @return Returns true, if the copy has been successful.
+         *   Metadata are kept on failure.
+         */
+        inline bool copyFrom(const EntityMetadata &source);
+
+        /**
+         * Write number of Entities and changes of the free
+         * index list since the last delta.
+         * @param writer The snapshot writer.
+         */
+        inline void saveDelta(SnapshotWriter &writer);
+
+        /**
+         * Apply number of Entities and changes of the free
+         * index list written by saveDelta.
+         * @param reader The snapshot reader.
+         * @return Returns true, if the load has been successful.
+         */
+        inline bool loadDelta(SnapshotReader &reader);
+
+        /// Start the next delta from the current state.
+        inline void resetDelta();
+
+        /**
+         * Overwrite generation and flags of given Entity,
+         * used for replaying deltas.
+         * @param id Index and the new generation of the Entity.
+         * @param created Should the Entity exist?
+         * @param active Should the Entity be active?
+         * @param previous ID of the Entity before the change is
+         *   returned here, invalid ID, if it has not existed.
+         * @return Returns false, if the index is out of range.
+         */
+        inline bool setState(EntityId id, bool created, bool active, EntityId &previous);
     private:
         /**
          * Push new Entity to the metadata list.
@@ -855,11 +1139,17 @@ namespace ent
         /// Contains the currently used metadata.
         MetadataContainer mMetadata;
         /// Indexes of free Entity IDs.
-        std::deque<EIdType> mFreeIndexes;
+        std::deque<EIdType, ResourceAllocator<EIdType>> mFreeIndexes;
+        /// Indexes of Entities destroyed since the last clearDestroyed.
+        ent::List<EIdType> mDestroyedIndexes;
         /// Free EntityGroup indexes.
         ent::SortedList<u64, std::greater<u64>> mFreeGroupIds;
         /// How many new groups will be created on refresh.
         u64 mNewGroupRequests;
+        /// Number of indexes taken from the free list since the last delta.
+        u64 mFreePopped;
+        /// Number of indexes added to the free list since the last delta.
+        u64 mFreePushed;
     protected:
     }; // class EntityMetadata
 } // namespace ent
@@ -112,6 +112,56 @@ namespace ent
                mValue == rhs.mValue;
     }
 
+    bool EntityFilter::refines(const EntityFilter &other) const
+    {
+        if (mValue.test(ACTIVITY_BIT) != other.mValue.test(ACTIVITY_BIT))
+        {
+            return false;
+        }
+
+        for (u64 index = 0; index < other.mCompPosUsed; ++index)
+        {
+            if (!hasCondition(other.mCompPos[index], other.mValue.test(index)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    EntityFilter EntityFilter::residual(const EntityFilter &other) const
+    {
+        EntityFilter result;
+
+        for (u64 index = 0; index < mCompPosUsed; ++index)
+        {
+            if (!other.hasCondition(mCompPos[index], mValue.test(index)))
+            {
+                result.addComponent(mCompPos[index], mValue.test(index));
+            }
+        }
+        result.setRequiredActivity(mValue.test(ACTIVITY_BIT));
+
+        return result;
+    }
+
+    u64 EntityFilter::hash() const
+    {
+        // FNV-1a over Component positions and their required values.
+        static constexpr u64 FNV_OFFSET{14695981039346656037ull};
+        static constexpr u64 FNV_PRIME{1099511628211ull};
+
+        u64 result{FNV_OFFSET};
+        for (u64 index = 0; index < mCompPosUsed; ++index)
+        {
+            result = (result ^ ((static_cast<u64>(mCompPos[index]) << 1u) | mValue.test(index))) * FNV_PRIME;
+        }
+        result = (result ^ mValue.test(ACTIVITY_BIT)) * FNV_PRIME;
+
+        return result;
+    }
+
     bool EntityFilter::compPosEqual(const CIdType *rhsCompPos) const
     {
         for (u64 index = 0; index < mCompPosUsed; ++index)
@@ -124,6 +174,18 @@ namespace ent
         return true;
     }
 
+    bool EntityFilter::hasCondition(CIdType cId, bool required) const
+    {
+        for (u64 index = 0; index < mCompPosUsed; ++index)
+        {
+            if (mCompPos[index] == cId && mValue.test(index) == required)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     std::ostream &operator<<(std::ostream &out, const EntityFilter &rhs)
     {
         out << "val: " << rhs.mValue;
@@ -180,7 +242,7 @@ namespace ent
         u64 realRows{realColumnSize * ENT_PER_BITSET};
         ENT_ASSERT_SLOW(rows <= realRows);
 
-        decltype(mData) newData;
+        decltype(mData) newData(mData.getAllocator());
         newData.resize(realSize);
         ENT_ASSERT_FAST(newData.capacity() == realSize);
 
@@ -307,9 +369,93 @@ namespace ent
     u64 MetadataGroup::capacity() const
     { return mEntityCapacity; }
 
+    u64 MetadataGroup::count(u64 column) const
+    {
+        u64 result{0u};
+
+        for (const MetadataBitset *it = begin(column); it != end(column); ++it)
+        {
+            result += it->count();
+        }
+
+        return result;
+    }
+
+    MemoryUsage MetadataGroup::memoryUsage(u64 liveRows) const
+    {
+        MemoryUsage result{MemoryUsage::ofList(mData)};
+        result.used = mColumns * ((mEntities + ENT_PER_BITSET - 1u) / ENT_PER_BITSET) * sizeof(MetadataBitset);
+        result.live = mEntities ? result.used * liveRows / mEntities : 0u;
+
+        return result;
+    }
+
     void MetadataGroup::setZero(u64 column)
     { zeroInitialize(begin(column), end(column)); }
 
+    void MetadataGroup::resetRows(u64 rows)
+    {
+        if (rows <= mEntityCapacity)
+        { // Already allocated memory can be reused.
+            zeroInitialize(begin(), end());
+            mEntities = rows;
+            return;
+        }
+
+        const u64 columns{mColumns};
+        reset();
+        init(columns, rows);
+    }
+
+    void MetadataGroup::swap(MetadataGroup &other)
+    {
+        std::swap(mColumns, other.mColumns);
+        std::swap(mEntities, other.mEntities);
+        std::swap(mEntityCapacity, other.mEntityCapacity);
+        std::swap(mColumnSize, other.mColumnSize);
+        mData.swap(other.mData);
+    }
+
+    void MetadataGroup::saveSnapshot(SnapshotWriter &writer) const
+    {
+        writer.write(mColumns);
+        writer.write(mEntities);
+        writer.write(mEntityCapacity);
+        writer.write(mColumnSize);
+        writer.writeList(mData);
+    }
+
+    bool MetadataGroup::loadSnapshot(SnapshotReader &reader)
+    {
+        u64 columns{0u};
+        u64 entities{0u};
+        u64 entityCapacity{0u};
+        u64 columnSize{0u};
+        decltype(mData) data(mData.getAllocator());
+
+        if (!reader.read(columns) || !reader.read(entities) ||
+            !reader.read(entityCapacity) || !reader.read(columnSize) ||
+            !reader.readList(data))
+        {
+            return false;
+        }
+
+        if (data.size() != columns * columnSize ||
+            (columns && columnSize * ENT_PER_BITSET < entityCapacity) ||
+            entityCapacity < entities)
+        { // Inconsistent layout.
+            return false;
+        }
+
+        mColumns = columns;
+        mEntities = entities;
+        mEntityCapacity = entityCapacity;
+        mColumnSize = columnSize;
+        mData.swap(data);
+
+        return true;
+    }
+
     void MetadataGroup::init(u64 columns, u64 rows)
     {
         resize(columns, rows);
@@ -386,7 +532,8 @@ namespace ent
 
     // EntityMetadata implementation.
     EntityMetadata::EntityMetadata() :
-        mEntityCapacity{0u}, mEntityLast{0u}, mNewGroupRequests{0u}
+        mEntityCapacity{0u}, mEntityLast{0u}, mNewGroupRequests{0u},
+        mFreePopped{0u}, mFreePushed{0u}
     {
     }
 
@@ -401,8 +548,10 @@ namespace ent
         mMetadata.generations.reclaim();
 
         mFreeIndexes.clear();
+        mDestroyedIndexes.reclaim();
         mFreeGroupIds.reclaim();
         mNewGroupRequests = 0u;
+        resetDelta();
     }
 
     void EntityMetadata::init(CIdType numComponents)
@@ -489,9 +638,50 @@ namespace ent
     bool EntityMetadata::hasComponent(EntityId id, CIdType compId) const
     { ENT_ASSERT_SLOW(validInd(id.index())); return getCompInd(id.index(), compId); }
 
+    template <typename FunT>
+    void EntityMetadata::removeComponents(EntityId id, FunT fun)
+    {
+        ENT_ASSERT_SLOW(validInd(id.index()));
+        const u64 numComponents{mMetadata.components.columns()};
+        for (u64 compId = 0; compId < numComponents; ++compId)
+        {
+            if (getCompInd(id.index(), compId))
+            {
+                setCompInd(id.index(), compId, false);
+                fun(static_cast<CIdType>(compId));
+            }
+        }
+    }
+
     EIdType EntityMetadata::currentGen(EIdType index) const
     { ENT_ASSERT_SLOW(validInd(index)); return genInd(index); }
 
+    EIdType EntityMetadata::endIndex() const
+    { return mEntityLast; }
+
+    u64 EntityMetadata::numComponents(CIdType compId) const
+    { return compId < mMetadata.components.columns() ? mMetadata.components.count(compId) : 0u; }
+
+    void EntityMetadata::memoryUsage(MemoryReport &report) const
+    {
+        const u64 rows{mEntityLast};
+        const u64 liveRows{rows > mFreeIndexes.size() ? rows - mFreeIndexes.size() : 0u};
+
+        report.metadataColumns = mMetadata.components.memoryUsage(liveRows);
+        report.metadataColumns += mMetadata.groups.memoryUsage(liveRows);
+        report.metadataColumns += mMetadata.flags.memoryUsage(liveRows);
+
+        report.generations = MemoryUsage::ofList(mMetadata.generations);
+        report.generations.used = rows * sizeof(EIdType);
+        report.generations.live = liveRows * sizeof(EIdType);
+
+        // Deque does not provide its capacity.
+        const u64 freeIndexes{mFreeIndexes.size() * sizeof(EIdType)};
+        report.freeList = MemoryUsage{freeIndexes, freeIndexes, freeIndexes};
+        report.freeList += MemoryUsage::ofList(mDestroyedIndexes);
+        report.freeList += MemoryUsage::ofList(mFreeGroupIds);
+    }
+
     bool EntityMetadata::setActivity(EntityId id, bool activity)
     { ENT_ASSERT_SLOW(validImpl(id)); return setActivityInd(id.index(), activity); }
 
@@ -513,6 +703,7 @@ namespace ent
         gen = (gen + 1u == EntityId::MAX_GEN) ? 0u : gen + 1u;
         resetEntity(index);
         pushFreeIndex(index);
+        mDestroyedIndexes.pushBack(index);
 
         return true;
     }
@@ -583,6 +774,163 @@ namespace ent
         );
     }
 
+    void EntityMetadata::saveSnapshot(SnapshotWriter &writer) const
+    {
+        writer.write(mEntityCapacity);
+        writer.write(mEntityLast);
+
+        // Group flags are restored from the Group member lists.
+        mMetadata.components.saveSnapshot(writer);
+        mMetadata.flags.saveSnapshot(writer);
+        writer.writeList(mMetadata.generations);
+
+        writer.beginBlock(mFreeIndexes.size() * sizeof(EIdType));
+        for (EIdType index : mFreeIndexes)
+        {
+            writer.writeData(&index, sizeof(EIdType));
+        }
+    }
+
+    bool EntityMetadata::loadSnapshot(SnapshotReader &reader)
+    {
+        u64 entityCapacity{0u};
+        EIdType entityLast{0u};
+        MetadataContainer metadata;
+        u64 freeSize{0u};
+        const EIdType *freeIndexes{nullptr};
+
+        if (!reader.read(entityCapacity) || !reader.read(entityLast) ||
+            !metadata.components.loadSnapshot(reader) ||
+            !metadata.flags.loadSnapshot(reader) ||
+            !reader.readList(metadata.generations) ||
+            !(freeIndexes = static_cast<const EIdType*>(reader.readBlock(freeSize))))
+        {
+            return false;
+        }
+
+        if (metadata.components.columns() != mMetadata.components.columns() ||
+            metadata.flags.columns() != mMetadata.flags.columns() ||
+            metadata.components.rows() != entityLast ||
+            metadata.flags.rows() != entityLast ||
+            metadata.generations.size() != entityCapacity ||
+            entityCapacity < entityLast ||
+            freeSize % sizeof(EIdType))
+        { // Snapshot of a different Universe.
+            return false;
+        }
+
+        if (reader.validating())
+        {
+            return true;
+        }
+
+        // Group flags are set by the GroupManager.
+        mMetadata.groups.resetRows(entityLast);
+        mEntityCapacity = entityCapacity;
+        mEntityLast = entityLast;
+        mMetadata.components.swap(metadata.components);
+        mMetadata.flags.swap(metadata.flags);
+        mMetadata.generations.swap(metadata.generations);
+        mFreeIndexes.assign(freeIndexes, freeIndexes + freeSize / sizeof(EIdType));
+        mDestroyedIndexes.clear();
+        resetDelta();
+
+        return true;
+    }
+
+    bool EntityMetadata::copyFrom(const EntityMetadata &source)
+    {
+        if (source.mMetadata.components.columns() != mMetadata.components.columns() ||
+            source.mMetadata.flags.columns() != mMetadata.flags.columns())
+        { // Metadata of a different Universe.
+            return false;
+        }
+
+        if (&source == this)
+        {
+            return true;
+        }
+
+        // Group flags are set by the GroupManager.
+        mMetadata.groups.resetRows(source.mEntityLast);
+        mEntityCapacity = source.mEntityCapacity;
+        mEntityLast = source.mEntityLast;
+        mMetadata.components = source.mMetadata.components;
+        mMetadata.flags = source.mMetadata.flags;
+        mMetadata.generations = source.mMetadata.generations;
+        mFreeIndexes = source.mFreeIndexes;
+        mDestroyedIndexes = source.mDestroyedIndexes;
+        resetDelta();
+
+        return true;
+    }
+
+    void EntityMetadata::saveDelta(SnapshotWriter &writer)
+    {
+        writer.write(mEntityLast);
+        writer.write(mFreePopped);
+
+        // Pushed indexes, which have not been popped yet, are at the end.
+        const u64 pushed{std::min<u64>(mFreePushed, mFreeIndexes.size())};
+        writer.beginBlock(pushed * sizeof(EIdType));
+        for (auto it = mFreeIndexes.end() - pushed; it != mFreeIndexes.end(); ++it)
+        {
+            const EIdType index{*it};
+            writer.writeData(&index, sizeof(EIdType));
+        }
+
+        resetDelta();
+    }
+
+    bool EntityMetadata::loadDelta(SnapshotReader &reader)
+    {
+        EIdType entityLast{0u};
+        u64 popped{0u};
+        u64 pushedSize{0u};
+        const EIdType *pushed{nullptr};
+
+        if (!reader.read(entityLast) || !reader.read(popped) ||
+            !(pushed = static_cast<const EIdType*>(reader.readBlock(pushedSize))) ||
+            entityLast < mEntityLast || pushedSize % sizeof(EIdType))
+        {
+            return false;
+        }
+
+        while (mEntityLast < entityLast)
+        {
+            pushEntity();
+        }
+
+        mFreeIndexes.erase(mFreeIndexes.begin(),
+                           mFreeIndexes.begin() + std::min<u64>(popped, mFreeIndexes.size()));
+        mFreeIndexes.insert(mFreeIndexes.end(), pushed, pushed + pushedSize / sizeof(EIdType));
+        resetDelta();
+
+        return true;
+    }
+
+    void EntityMetadata::resetDelta()
+    {
+        mFreePopped = 0u;
+        mFreePushed = 0u;
+    }
+
+    bool EntityMetadata::setState(EntityId id, bool created, bool active, EntityId &previous)
+    {
+        if (!validInd(id.index()))
+        {
+            return false;
+        }
+
+        previous = createdInd(id.index()) ? EntityId(id.index(), genInd(id.index())) : EntityId();
+
+        genInd(id.index()) = id.generation();
+        setCreatedInd(id.index(), created);
+        setActivityInd(id.index(), active);
+
+        return true;
+    }
+
     EIdType EntityMetadata::pushEntity()
     {
         if (mEntityLast < mEntityCapacity)
@@ -611,7 +959,10 @@ namespace ent
     }
 
     void EntityMetadata::pushFreeIndex(EIdType index)
-    { mFreeIndexes.push_back(index); }
+    {
+        mFreeIndexes.push_back(index);
+        mFreePushed++;
+    }
 
     EIdType EntityMetadata::popFreeIndex()
     {
@@ -619,6 +970,7 @@ namespace ent
 
         EIdType result{mFreeIndexes.front()};
         mFreeIndexes.pop_front();
+        mFreePopped++;
 
         return result;
     }
@@ -707,5 +1059,90 @@ namespace ent
     }
 
     // EntityMetadata implementation end.
+
+    // ChangedEntities implementation.
+    ChangedEntities::ChangedEntities() :
+        mFirstBitset{0u}, mEndBitset{0u}, mNumChanged{0u}
+    { }
+
+    void ChangedEntities::entityChanged(EntityId id)
+    {
+        const u64 bitset{id.index() / ENT_PER_BITSET};
+        if (bitset >= mBits.size())
+        {
+            mBits.resize(bitset + 1u, MetadataBitset());
+        }
+
+        if (!mBits[bitset].testAndSet(id.index() % ENT_PER_BITSET, true))
+        { // Entity has not been changed yet.
+            if (mNumChanged == 0u)
+            {
+                mFirstBitset = bitset;
+                mEndBitset = bitset + 1u;
+            }
+            else
+            {
+                mFirstBitset = std::min(mFirstBitset, bitset);
+                mEndBitset = std::max(mEndBitset, bitset + 1u);
+            }
+            mNumChanged++;
+        }
+    }
+
+    bool ChangedEntities::contains(EntityId id) const
+    {
+        const u64 bitset{id.index() / ENT_PER_BITSET};
+        return bitset < mBits.size() && mBits[bitset].test(id.index() % ENT_PER_BITSET);
+    }
+
+    void ChangedEntities::entityDestroyed(EntityId id)
+    {
+        entityChanged(id);
+        mDestroyed.pushBack(id);
+    }
+
+    template <typename FunT>
+    void ChangedEntities::forEach(FunT fun) const
+    {
+        for (u64 bitset = mFirstBitset; bitset < mEndBitset; ++bitset)
+        {
+            const MetadataBitset &bits(mBits[bitset]);
+            for (u64 bit = bits.findNext(0u); bit < ENT_PER_BITSET; bit = bits.findNext(bit + 1u))
+            {
+                fun(static_cast<EIdType>(bitset * ENT_PER_BITSET + bit));
+            }
+        }
+    }
+
+    void ChangedEntities::clear()
+    {
+        for (u64 bitset = mFirstBitset; bitset < mEndBitset; ++bitset)
+        {
+            mBits[bitset].reset();
+        }
+
+        mDestroyed.clear();
+        mFirstBitset = 0u;
+        mEndBitset = 0u;
+        mNumChanged = 0u;
+    }
+
+    void ChangedEntities::reclaim()
+    {
+        mBits.reclaim();
+        mDestroyed.reclaim();
+        mFirstBitset = 0u;
+        mEndBitset = 0u;
+        mNumChanged = 0u;
+    }
+
+    MemoryUsage ChangedEntities::memoryUsage() const
+    {
+        MemoryUsage result{MemoryUsage::ofList(mBits)};
+        result += MemoryUsage::ofList(mDestroyed);
+
+        return result;
+    }
+    // ChangedEntities implementation end.
 } // namespace ent
 
@@ -7,10 +7,15 @@
 #ifndef ECS_FIT_GROUPMANAGER_H
 #define ECS_FIT_GROUPMANAGER_H
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "Util.h"
 #include "List.h"
 #include "EntityGroup.h"
 #include "EntityManager.h"
+#include "RefreshMetrics.h"
 
 /// Main Entropy namespace
 namespace ent
@@ -40,14 +45,74 @@ namespace ent
          * @param changed List of changed Entity IDs.
          * @param em Used for checking present Components for Entities and
          *   changing their Group metadata.
+         * @param frame Resource used for the transient lists
+         *   of this refresh.
+         * @param metrics Metrics of the current refresh, end of the
+         *   Group check and finalize phases and the Group deltas
+         *   are recorded.
+         */
+        void refresh(const ent::SortedList<EntityId> &changed, EntityManager &em,
+                     MemoryResource *frame, RefreshMetrics &metrics);
+
+        /**
+         * Refresh active groups with changed Entities. Groups with
+         * usage counter which reached zero will be removed and their
+         * IDs recycled.
+         * @param changed Set of changed Entities.
+         * @param em Used for checking present Components for Entities and
+         *   changing their Group metadata.
+         * @param frame Resource used for the transient lists
+         *   of this refresh.
+         * @param metrics Metrics of the current refresh, end of the
+         *   Group check and finalize phases and the Group deltas
+         *   are recorded.
+         */
+        void refresh(const ChangedEntities &changed, EntityManager &em,
+                     MemoryResource *frame, RefreshMetrics &metrics);
+
+        /**
+         * Remove Entities destroyed since the last refresh
+         * from the active Groups, before their indexes are
+         * reused. Removals are reported on the next refresh.
+         * @param em Manager containing the destroyed Entities.
          */
-        void refresh(const ent::SortedList<EntityId> &changed, EntityManager &em);
+        inline void removeDestroyed(EntityManager &em);
 
         /**
          * Reset the Manager and all of the Entity Groups.
          */
         void reset();
 
+        /**
+         * Write members of all active Groups to the snapshot.
+         * @param writer The snapshot writer.
+         */
+        inline void saveSnapshot(SnapshotWriter &writer) const;
+
+        /**
+         * Restore members of all active Groups from the snapshot.
+         * If the active Groups differ from the saved ones, members
+         * are recalculated from the Entity metadata instead.
+         * Group flags of the Entities are set and the lists of
+         * added and removed Entities are empty afterwards.
+         * @param reader The snapshot reader.
+         * @param em EntityManager with already loaded metadata.
+         * @return Returns true, if the load has been successful.
+         */
+        inline bool loadSnapshot(SnapshotReader &reader, EntityManager &em);
+
+        /**
+         * Replace members of all active Groups with members of
+         * Groups from another manager. If the active Groups differ
+         * from the Groups of the other manager, members are
+         * recalculated from the Entity metadata instead.
+         * Group flags of the Entities are set and the lists of
+         * added and removed Entities are empty afterwards.
+         * @param source Manager, whose Groups are copied.
+         * @param em EntityManager with already copied metadata.
+         */
+        inline void copyFrom(const GroupManager &source, EntityManager &em);
+
         /**
          * Add Entity group with Required and Rejected Components.
          * The pointer is guaranteed to be valid as long as the
@@ -115,7 +180,60 @@ namespace ent
         template <typename RequireT,
                   typename RejectT>
         inline EntityFilter buildFilter(const ComponentManager<UniverseT> &cm) const;
+
+        /**
+         * Add Entity group specified by filter built on runtime.
+         * Groups are kept in a registry keyed by the filter, so
+         * repeated calls with equal filters return the same,
+         * incrementally refreshed, Group.
+         * Groups which are no longer in use are kept in cache
+         * and the least recently used ones are removed, when
+         * there are more than ENT_GROUP_CACHE_SIZE of them.
+         * The pointer is guaranteed to be valid until the
+         * Group is removed from the cache.
+         * @param filter Filter specifying the Group.
+         * @param em EntityManager used for adding Group metadata.
+         * @return Returns ptr to the requested Entity Group.
+         * @remarks Each time this method is called the corresponding usage
+         *   counter is incremented!
+         */
+        inline EntityGroup *addGroup(const EntityFilter &filter, EntityManager &em);
+
+        /**
+         * Get already existing runtime EntityGroup.
+         * @param filter Filter specifying the Group.
+         * @return Returns ptr to the requested EntityGroup, or
+         *   nullptr, if such group does not exist.
+         */
+        inline EntityGroup *getGroup(const EntityFilter &filter);
+
+        /**
+         * Generate filter for given lists of Component IDs.
+         * Resulting filter does not depend on the order of the IDs.
+         * If both lists contain the same ID, the require list
+         * has higher priority.
+         * @param require List of required Component IDs.
+         * @param reject List of rejected Component IDs.
+         * @return Returns Component filter for given lists.
+         */
+        inline EntityFilter buildFilter(const std::vector<CIdType> &require,
+                                        const std::vector<CIdType> &reject) const;
+
+        /**
+         * Fill memory used by the Entity lists of all Groups,
+         * including the cached ones, into given report.
+         * @param report Report filled with the usage.
+         */
+        inline void memoryUsage(MemoryReport &report) const;
     private:
+        /// Runtime EntityGroup record within the cache.
+        struct CachedGroup
+        {
+            /// The EntityGroup itself.
+            std::unique_ptr<EntityGroup> group;
+            /// Value of the cache clock, when the Group was last requested.
+            u64 lastUsed;
+        }; // struct CachedGroup
 #ifdef ENT_NOT_USED
         /**
          * Build a filter bitset using template magic.
@@ -139,19 +257,33 @@ namespace ent
 
         /**
          * Call refresh on all active Groups.
+         * @param frame Resource used for the added/removed lists.
          */
-        inline void refreshGroups();
+        inline void refreshGroups(MemoryResource *frame);
 
         /**
          * Check EntityGroups, if they are still in use. If there is any
          * Group, which is not in use, it will be removed.
+         * Order of the remaining Groups is kept.
          * @param em Used for changing Group metadata of Entities.
          */
         inline void checkGroups(EntityManager &em);
 
+        /**
+         * Remove least recently used runtime Groups, which are
+         * not in use, until there is at most ENT_GROUP_CACHE_SIZE
+         * of them.
+         * @param em Used for changing Group metadata of Entities.
+         * @param frame Resource used for the temporary lists.
+         */
+        inline void evictCachedGroups(EntityManager &em, MemoryResource *frame);
+
         /**
          * Test all Entities on the changed list, if they should
          * be added/removed from any groups.
+         * Groups with parent are checked only for Entities, which
+         * are members of the parent Group, new Groups with parent
+         * are populated only from members of the parent Group.
          * @param changed List of changed Entities since last refresh.
          * @param em EntityManager used for getting information about
          *   the Entities and write back Group changes.
@@ -159,11 +291,55 @@ namespace ent
         inline void checkEntities(const ent::SortedList<EntityId> &changed,
                                   EntityManager &em);
 
+        /**
+         * Test all Entities in the changed set, if they should
+         * be added/removed from any groups.
+         * Destroyed Entities are removed using their original
+         * IDs, the rest of the Entities is iterated by index.
+         * @param changed Set of changed Entities since last refresh.
+         * @param em EntityManager used for getting information about
+         *   the Entities and write back Group changes.
+         */
+        inline void checkEntities(const ChangedEntities &changed,
+                                  EntityManager &em);
+
+        /**
+         * Test a single changed Entity, if it should be added/removed
+         * from given Group.
+         * @param grp The tested Group.
+         * @param id ID of the Entity.
+         * @param em EntityManager used for getting information about
+         *   the Entity and write back Group changes.
+         */
+        inline void checkEntity(EntityGroup *grp, EntityId id, EntityManager &em);
+
+        /**
+         * Populate the newly created Groups and move them
+         * to the list of active Groups.
+         * @param em EntityManager used for getting information about
+         *   the Entities and write back Group changes.
+         */
+        inline void populateNewGroups(EntityManager &em);
+
         /**
          * Finish the operation of adding/removing Entities from all
          * affected Groups.
+         * @param metrics Sizes of the Group deltas are added
+         *   to these metrics, when not nullptr.
          */
-        inline void finalizeGroups();
+        inline void finalizeGroups(FrameMetrics *metrics);
+
+        /**
+         * Replace members of all active Groups.
+         * @param members Members for each of the active Groups,
+         *   as pairs of pointer to the first member and count.
+         * @param matches Do the members belong to the active
+         *   Groups? If not, members are recalculated from the
+         *   Entity metadata instead.
+         * @param em EntityManager with already replaced metadata.
+         */
+        inline void restoreMembers(const std::vector<std::pair<const EntityId*, u64>> &members,
+                                   bool matches, EntityManager &em);
 
         /**
          * Initialize group.
@@ -176,6 +352,41 @@ namespace ent
             typename RejectT>
         inline void initGroup(const EntityFilter &f, EntityManager &em);
 
+        /**
+         * Populate new Group using members of its parent.
+         * The parent has to be already refreshed.
+         * @param grp The new Group.
+         * @param em EntityManager used for getting information about
+         *   the Entities and write back Group changes.
+         */
+        inline void populateFromParent(EntityGroup *grp, EntityManager &em);
+
+        /**
+         * Find the most specific existing Group, whose filter
+         * is more general than the given filter.
+         * @param f Filter of the new Group.
+         * @return Returns ptr to the parent Group, or nullptr,
+         *   if there is no such Group.
+         */
+        inline EntityGroup *findParent(const EntityFilter &f);
+
+        /**
+         * Set parent of given Group and recalculate
+         * its residual filter.
+         * @param grp The child Group.
+         * @param parent The new parent, may be nullptr.
+         */
+        inline static void linkParent(EntityGroup *grp, EntityGroup *parent);
+
+        /**
+         * Move children of given Group to its parent and
+         * reset the parent of given Group. Added/removed lists
+         * of the Group are moved out of the frame arena.
+         * Should be called before removing the Group.
+         * @param grp Group which is being removed.
+         */
+        inline void unlinkGroup(EntityGroup *grp);
+
         /**
          * Check, if there is no EntityGroup already using this
          * filter.
@@ -188,32 +399,66 @@ namespace ent
          */
         inline bool checkGrpRedundancy(const EntityFilter &f);
 
+        /**
+         * Is the given Group kept alive by the runtime Group cache?
+         * @param grp Tested Group.
+         * @return Returns true, if the Group is a runtime Group.
+         */
+        inline bool cached(const EntityGroup *grp) const;
+
+        /**
+         * Should the given Group be removed?
+         * @param grp Tested Group.
+         * @return Returns true, if the Group is not in use
+         *   and is not kept by the runtime Group cache.
+         */
+        inline bool expired(const EntityGroup *grp) const;
+
         /**
          * Remove inactive Groups from given list.
          * @param groups List of Groups.
          */
-        inline static void removeInactive(std::vector<EntityGroup*> &groups);
+        inline void removeInactive(std::vector<EntityGroup*> &groups);
+
+        /// Generator of indices for Require and Reject lists of EntityGroups.
+        class GroupIdGenerator : public StaticClassIdGenerator<GroupIdGenerator>
+        { };
 
         /**
-         * Static instance of EntityGroup.
+         * Get index of EntityGroup with given Require and Reject
+         * lists, shared by all managers of the same Universe type.
          * @tparam RequireT List of required Component types.
          * @tparam RejectT List of rejected Component types.
+         * @return Returns the index.
          */
         template<typename RequireT,
             typename RejectT>
-        static ConstructionHandler<EntityGroup> &group()
-        {
-            static ConstructionHandler<EntityGroup> group;
-            return group;
-        }
+        static u64 groupIndex()
+        { return GroupIdGenerator::template getId<std::pair<RequireT, RejectT>>(); }
+
+        /**
+         * Get EntityGroup with given Require and Reject lists.
+         * @tparam RequireT List of required Component types.
+         * @tparam RejectT List of rejected Component types.
+         * @return Returns ptr to the Group, or nullptr, if
+         *   it has not been created.
+         */
+        template<typename RequireT,
+            typename RejectT>
+        inline EntityGroup *group() const;
 
         /// List of active EntityGroups, which are being refreshed.
         std::vector<EntityGroup*> mActiveGroups;
         /// List of newly created EntityGroups.
         std::vector<EntityGroup*> mNewGroups;
 
-        /// List of things to destruct on reset.
-        std::vector<std::function<void()>> mDestructOnReset;
+        /// Registry of runtime EntityGroups.
+        std::unordered_map<EntityFilter, CachedGroup, EntityFilterHash> mCachedGroups;
+        /// Incremented each time a runtime Group is requested.
+        u64 mCacheClock;
+
+        /// EntityGroups created from Require and Reject lists, indexed by groupIndex.
+        std::vector<std::unique_ptr<EntityGroup>> mGroups;
     protected:
     }; // class GroupManager
 } // namespace ent
@@ -10,7 +10,8 @@
 namespace ent
 {
     template <typename UT>
-    GroupManager<UT>::GroupManager()
+    GroupManager<UT>::GroupManager() :
+        mCacheClock{0u}
     { reset(); }
 
     template <typename UT>
@@ -18,24 +19,169 @@ namespace ent
     { reset(); }
 
     template <typename UT>
-    void GroupManager<UT>::refresh(const ent::SortedList<EntityId> &changed, EntityManager &em)
+    void GroupManager<UT>::refresh(const ent::SortedList<EntityId> &changed, EntityManager &em,
+                                   MemoryResource *frame, RefreshMetrics &metrics)
     {
-        refreshGroups();
+        refreshGroups(frame);
+        evictCachedGroups(em, frame);
         checkGroups(em);
         checkEntities(changed, em);
-        finalizeGroups();
+        populateNewGroups(em);
+        metrics.endPhase(FrameMetrics::PHASE_GROUP_CHECK);
+        finalizeGroups(&metrics.current());
+        metrics.endPhase(FrameMetrics::PHASE_GROUP_FINALIZE);
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::refresh(const ChangedEntities &changed, EntityManager &em,
+                                   MemoryResource *frame, RefreshMetrics &metrics)
+    {
+        refreshGroups(frame);
+        evictCachedGroups(em, frame);
+        checkGroups(em);
+        checkEntities(changed, em);
+        populateNewGroups(em);
+        metrics.endPhase(FrameMetrics::PHASE_GROUP_CHECK);
+        finalizeGroups(&metrics.current());
+        metrics.endPhase(FrameMetrics::PHASE_GROUP_FINALIZE);
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::removeDestroyed(EntityManager &em)
+    {
+        for (EIdType index : em.destroyedIndexes())
+        {
+            const EntityId id(index, em.currentGen(index));
+            for (EntityGroup *grp : mActiveGroups)
+            {
+                if (em.inGroup(id, grp->id()))
+                { // Group still contains the destroyed Entity.
+                    grp->removeDestroyed(id);
+                    em.resetGroup(id, grp->id());
+                }
+            }
+        }
     }
 
     template <typename UT>
     void GroupManager<UT>::reset()
     {
         mActiveGroups.clear();
+        mNewGroups.clear();
+        mCachedGroups.clear();
+        mCacheClock = 0u;
+        mGroups.clear();
+    }
 
-        for (auto &h : mDestructOnReset)
+    template <typename UT>
+    void GroupManager<UT>::saveSnapshot(SnapshotWriter &writer) const
+    {
+        writer.write<u64>(mActiveGroups.size());
+        for (EntityGroup *grp : mActiveGroups)
         {
-            h();
+            const EntityGroup::EntityListT &members(*grp->entitiesFront());
+
+            writer.write<u64>(grp->id());
+            writer.write<u64>(grp->filter().hash());
+            writer.writeBlock(members.begin(), members.size() * sizeof(EntityId));
+        }
+    }
+
+    template <typename UT>
+    bool GroupManager<UT>::loadSnapshot(SnapshotReader &reader, EntityManager &em)
+    {
+        u64 numGroups{0u};
+        if (!reader.read(numGroups))
+        {
+            return false;
+        }
+
+        bool matches{numGroups == mActiveGroups.size()};
+        std::vector<std::pair<const EntityId*, u64>> members;
+        for (u64 iii = 0; iii < numGroups; ++iii)
+        {
+            u64 groupId{0u};
+            u64 filterHash{0u};
+            u64 size{0u};
+            const EntityId *ids{nullptr};
+            if (!reader.read(groupId) || !reader.read(filterHash) ||
+                !(ids = static_cast<const EntityId*>(reader.readBlock(size))) ||
+                size % sizeof(EntityId))
+            {
+                return false;
+            }
+
+            matches = matches &&
+                      mActiveGroups[iii]->id() == groupId &&
+                      mActiveGroups[iii]->filter().hash() == filterHash;
+            members.emplace_back(ids, size / sizeof(EntityId));
+        }
+
+        if (!reader.validating())
+        {
+            restoreMembers(members, matches, em);
+        }
+
+        return true;
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::copyFrom(const GroupManager &source, EntityManager &em)
+    {
+        bool matches{source.mActiveGroups.size() == mActiveGroups.size()};
+        std::vector<std::pair<const EntityId*, u64>> members;
+        for (u64 iii = 0; iii < source.mActiveGroups.size(); ++iii)
+        {
+            EntityGroup *grp{source.mActiveGroups[iii]};
+            const EntityGroup::EntityListT &list(*grp->entitiesFront());
+
+            matches = matches &&
+                      mActiveGroups[iii]->id() == grp->id() &&
+                      mActiveGroups[iii]->filter() == grp->filter();
+            members.emplace_back(list.begin(), list.size());
+        }
+
+        restoreMembers(members, matches, em);
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::restoreMembers(const std::vector<std::pair<const EntityId*, u64>> &members,
+                                          bool matches, EntityManager &em)
+    {
+        for (EntityGroup *grp : mActiveGroups)
+        {
+            grp->reset();
+        }
+
+        if (matches)
+        { // Members can be used directly.
+            for (u64 iii = 0; iii < members.size(); ++iii)
+            {
+                EntityGroup *grp{mActiveGroups[iii]};
+                EntityGroup::EntityListT &list(*grp->entitiesFront());
+
+                list.resize(members[iii].second);
+                std::copy(members[iii].first, members[iii].first + members[iii].second, list.begin());
+
+                for (EntityId id : list)
+                {
+                    em.setGroup(id, grp->id());
+                }
+            }
+        }
+        else
+        { // Populate the Groups again, parent Groups are before their children.
+            std::vector<EntityGroup*> requested;
+            requested.swap(mNewGroups);
+            mNewGroups.swap(mActiveGroups);
+
+            populateNewGroups(em);
+            finalizeGroups(nullptr);
+            refreshGroups(nullptr);
+
+            // Groups requested before the replacement are populated on refresh.
+            mNewGroups.swap(requested);
         }
-        mDestructOnReset.clear();
     }
 
     template <typename UT>
@@ -59,7 +205,7 @@ namespace ent
         typename RejectT>
     bool GroupManager<UT>::hasGroup()
     {
-        return group<RequireT, RejectT>().constructed();
+        return group<RequireT, RejectT>() != nullptr;
     }
 
     template <typename UT>
@@ -67,7 +213,7 @@ namespace ent
         typename RejectT>
     EntityGroup *GroupManager<UT>::getGroup()
     {
-        return group<RequireT, RejectT>().ptr();
+        return group<RequireT, RejectT>();
     }
 
     template <typename UT>
@@ -78,6 +224,87 @@ namespace ent
         return getGroup<RequireT, RejectT>()->abandon() == 0u;
     }
 
+    template <typename UT>
+    EntityGroup *GroupManager<UT>::addGroup(const EntityFilter &filter, EntityManager &em)
+    {
+        auto found{mCachedGroups.find(filter)};
+
+        if (found == mCachedGroups.end())
+        { // Group with this filter does not exist yet.
+            u64 grpId{em.addGroup()};
+            EntityGroup *parent{findParent(filter)};
+            found = mCachedGroups.emplace(filter,
+                CachedGroup{std::make_unique<EntityGroup>(filter, grpId), 0u}).first;
+            linkParent(found->second.group.get(), parent);
+
+            // Activate the EntityGroup.
+            mNewGroups.emplace_back(found->second.group.get());
+        }
+
+        found->second.lastUsed = ++mCacheClock;
+        found->second.group->incUsage();
+
+        return found->second.group.get();
+    }
+
+    template <typename UT>
+    EntityGroup *GroupManager<UT>::getGroup(const EntityFilter &filter)
+    {
+        auto found{mCachedGroups.find(filter)};
+        return found == mCachedGroups.end() ? nullptr : found->second.group.get();
+    }
+
+    template <typename UT>
+    EntityFilter GroupManager<UT>::buildFilter(const std::vector<CIdType> &require,
+                                               const std::vector<CIdType> &reject) const
+    {
+        // Sort the IDs, so the same sets of Components result in the same filter.
+        std::vector<CIdType> req(require);
+        std::sort(req.begin(), req.end());
+        req.erase(std::unique(req.begin(), req.end()), req.end());
+
+        std::vector<CIdType> rej(reject);
+        std::sort(rej.begin(), rej.end());
+        rej.erase(std::unique(rej.begin(), rej.end()), rej.end());
+
+        EntityFilter result;
+        for (CIdType cId : req)
+        {
+            result.requireComponent(cId);
+        }
+        for (CIdType cId : rej)
+        {
+            if (!std::binary_search(req.begin(), req.end(), cId))
+            {
+                result.rejectComponent(cId);
+            }
+        }
+        result.setRequiredActivity(true);
+        return result;
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::memoryUsage(MemoryReport &report) const
+    {
+        report.groupLists = MemoryUsage{};
+        report.numGroups = 0u;
+
+        for (const std::unique_ptr<EntityGroup> &grp : mGroups)
+        {
+            if (grp)
+            {
+                report.groupLists += grp->memoryUsage();
+                report.numGroups++;
+            }
+        }
+
+        for (const auto &rec : mCachedGroups)
+        {
+            report.groupLists += rec.second.group->memoryUsage();
+            report.numGroups++;
+        }
+    }
+
 #ifdef ENT_NOT_USED
     template <typename UT>
     template <template<typename...> typename ContainerT,
@@ -179,11 +406,11 @@ namespace ent
     }
 
     template <typename UT>
-    void GroupManager<UT>::refreshGroups()
+    void GroupManager<UT>::refreshGroups(MemoryResource *frame)
     {
         for (EntityGroup *grp : mActiveGroups)
         {
-            grp->refresh();
+            grp->refresh(frame);
         }
     }
 
@@ -191,33 +418,73 @@ namespace ent
     void GroupManager<UT>::checkGroups(EntityManager &em)
     {
         // TODO - Unit test.
-        if (mActiveGroups.empty())
-        { // No Groups to check.
-            return;
-        }
-
-        u64 lastActive{mActiveGroups.size() - 1u};
-
         /*
          * Look for Groups which are not in use and remove then.
+         * The order has to be kept, parent Groups are always
+         * before their children.
          */
-        for (u64 index = 0; index <= lastActive; )
+        for (auto it = mActiveGroups.begin(); it != mActiveGroups.end(); )
         {
-            EntityGroup *grp{mActiveGroups[index]};
-            if (!grp->inUse())
+            EntityGroup *grp{*it};
+            if (expired(grp))
             { // Group needs to be removed.
                 em.removeGroup(grp->id());
-                // Swap-remove and decrement the number of active Groups.
-                std::swap(mActiveGroups[index], mActiveGroups[lastActive--]);
-                mActiveGroups.pop_back();
+                unlinkGroup(grp);
+                it = mActiveGroups.erase(it);
             }
             else
             {
-                index++;
+                ++it;
             }
         }
     }
 
+    template <typename UT>
+    void GroupManager<UT>::evictCachedGroups(EntityManager &em, MemoryResource *frame)
+    {
+        using IteratorT = typename decltype(mCachedGroups)::iterator;
+        std::vector<IteratorT, ResourceAllocator<IteratorT>> unused(frame);
+        for (auto it = mCachedGroups.begin(); it != mCachedGroups.end(); ++it)
+        {
+            if (!it->second.group->inUse())
+            {
+                unused.push_back(it);
+            }
+        }
+
+        if (unused.size() <= ENT_GROUP_CACHE_SIZE)
+        { // Everything fits into the cache.
+            return;
+        }
+
+        // Least recently used Groups go first.
+        u64 numEvicted{unused.size() - ENT_GROUP_CACHE_SIZE};
+        std::partial_sort(unused.begin(), unused.begin() + numEvicted, unused.end(),
+                          [] (const auto &first, const auto &second) {
+                              return first->second.lastUsed < second->second.lastUsed;
+                          });
+
+        for (u64 index = 0; index < numEvicted; ++index)
+        {
+            EntityGroup *grp{unused[index]->second.group.get()};
+
+            auto activeIt{std::find(mActiveGroups.begin(), mActiveGroups.end(), grp)};
+            if (activeIt != mActiveGroups.end())
+            {
+                mActiveGroups.erase(activeIt);
+            }
+            auto newIt{std::find(mNewGroups.begin(), mNewGroups.end(), grp)};
+            if (newIt != mNewGroups.end())
+            {
+                mNewGroups.erase(newIt);
+            }
+
+            em.removeGroup(grp->id());
+            unlinkGroup(grp);
+            mCachedGroups.erase(unused[index]);
+        }
+    }
+
     template <typename UT>
     void GroupManager<UT>::checkEntities(const ent::SortedList<EntityId> &changed,
                               EntityManager &em)
@@ -227,39 +494,77 @@ namespace ent
         // Every Group has to check for changes in Entities.
         for (EntityGroup *grp : mActiveGroups)
         {
-            const EntityFilter &filter(grp->filter());
-            const u64 groupId{grp->id()};
             for (EntityId id : changed)
-            {
-                // Tests, if the Entity has been destroyed
-                bool exists{em.valid(id)};
-                // Tests, if the Entity is currently in the Group.
-                bool inGroup{em.inGroup(id, groupId)};
+            { // Index of destroyed Entity may have been already reused.
+                checkEntity(grp, EntityId(id.index(), em.currentGen(id.index())), em);
+            }
+        }
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::checkEntities(const ChangedEntities &changed,
+                              EntityManager &em)
+    {
+        for (EntityGroup *grp : mActiveGroups)
+        {
+            const u64 groupId{grp->id()};
 
-                if (!exists && inGroup)
-                { // Entity is within the Group, but has been destroyed.
+            // Index of destroyed Entity may have been already reused.
+            for (EntityId id : changed.destroyed())
+            {
+                if (em.inGroup(id, groupId))
+                {
                     grp->remove(id);
                     em.resetGroup(id, groupId);
                 }
-                else if (exists)
-                {
-                    FilterBitset entInfo{em.compressInfo(filter, id.index())};
-                    bool passed{filter.match(entInfo)};
-
-                    if (passed && !inGroup)
-                    { // Not in Group, but should be.
-                        grp->add(id);
-                        em.setGroup(id, groupId);
-                    }
-                    else if (!passed && inGroup)
-                    { // In Group, but shouldn't be.
-                        grp->remove(id);
-                        em.resetGroup(id, groupId);
-                    }
-                }
+            }
+
+            changed.forEach([&] (EIdType index) {
+                checkEntity(grp, EntityId(index, em.currentGen(index)), em);
+            });
+        }
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::checkEntity(EntityGroup *grp, EntityId id, EntityManager &em)
+    {
+        // Conditions checked by the parent do not need to be checked again.
+        const EntityFilter &filter(grp->mResidual);
+        const EntityGroup *parent{grp->mParent};
+        const u64 groupId{grp->id()};
+
+        // Tests, if the Entity has been destroyed
+        bool exists{em.valid(id)};
+        // Tests, if the Entity is currently in the Group.
+        bool inGroup{em.inGroup(id, groupId)};
+
+        if (!exists && inGroup)
+        { // Entity is within the Group, but has been destroyed.
+            grp->remove(id);
+            em.resetGroup(id, groupId);
+        }
+        else if (exists)
+        {
+            // Parent is always checked first, Entities outside of it cannot pass.
+            bool passed{(parent == nullptr || em.inGroup(id, parent->id())) &&
+                        filter.match(em.compressInfo(filter, id.index()))};
+
+            if (passed && !inGroup)
+            { // Not in Group, but should be.
+                grp->add(id);
+                em.setGroup(id, groupId);
+            }
+            else if (!passed && inGroup)
+            { // In Group, but shouldn't be.
+                grp->remove(id);
+                em.resetGroup(id, groupId);
             }
         }
+    }
 
+    template <typename UT>
+    void GroupManager<UT>::populateNewGroups(EntityManager &em)
+    {
         // Some of the new Groups may not be in used any more...
         removeInactive(mNewGroups);
 
@@ -270,6 +575,12 @@ namespace ent
          */
         for (EntityGroup *grp : mNewGroups)
         {
+            if (grp->mParent)
+            { // Only members of the parent Group can pass.
+                populateFromParent(grp, em);
+                continue;
+            }
+
             const EntityFilter &filter(grp->filter());
             const u64 groupId{grp->id()};
             ValidEntityIterator it{em.validEntities()};
@@ -297,12 +608,21 @@ namespace ent
     }
 
     template <typename UT>
-    void GroupManager<UT>::finalizeGroups()
+    void GroupManager<UT>::finalizeGroups(FrameMetrics *metrics)
     {
         for (EntityGroup *grp : mActiveGroups)
         {
             grp->finalize();
         }
+
+        if (metrics)
+        {
+            for (EntityGroup *grp : mActiveGroups)
+            {
+                metrics->groupAdded += grp->numAdded();
+                metrics->groupRemoved += grp->numRemoved();
+            }
+        }
     }
 
     template <typename UT>
@@ -310,7 +630,7 @@ namespace ent
         typename RejectT>
     void GroupManager<UT>::initGroup(const EntityFilter &f, EntityManager &em)
     {
-        if (group<RequireT, RejectT>().constructed())
+        if (group<RequireT, RejectT>())
         { // Prevent double initialized Entity Groups.
             return;
         }
@@ -324,15 +644,112 @@ namespace ent
         }
 #endif
         u64 grpId{em.addGroup()};
+        EntityGroup *parent{findParent(f)};
 
         // Create the EntityGroup.
-        group<RequireT, RejectT>().construct(f, grpId);
+        const u64 index{groupIndex<RequireT, RejectT>()};
+        if (index >= mGroups.size())
+        {
+            mGroups.resize(index + 1u);
+        }
+        mGroups[index] = std::make_unique<EntityGroup>(f, grpId);
+        linkParent(mGroups[index].get(), parent);
 
         // Activate the EntityGroup.
-        mNewGroups.emplace_back(group<RequireT, RejectT>().ptr());
+        mNewGroups.emplace_back(mGroups[index].get());
+    }
+
+    template <typename UT>
+    template <typename RequireT,
+        typename RejectT>
+    EntityGroup *GroupManager<UT>::group() const
+    {
+        const u64 index{groupIndex<RequireT, RejectT>()};
+        return index < mGroups.size() ? mGroups[index].get() : nullptr;
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::populateFromParent(EntityGroup *grp, EntityManager &em)
+    {
+        const EntityFilter &filter(grp->mResidual);
+        const u64 groupId{grp->id()};
+        const u64 parentId{grp->mParent->id()};
+
+        auto testEntity = [&] (EntityId id) {
+            // Parent members may have been removed or destroyed in this refresh.
+            if (em.valid(id) && em.inGroup(id, parentId) &&
+                filter.match(em.compressInfo(filter, id.index())))
+            {
+                grp->add(id);
+                em.setGroup(id, groupId);
+            }
+        };
+
+        // Parent has already been refreshed, current members are front buffer + added.
+        for (EntityId id : *grp->mParent->entitiesFront())
+        {
+            testEntity(id);
+        }
+        for (EntityId id : grp->mParent->mAdded)
+        {
+            testEntity(id);
+        }
+    }
+
+    template <typename UT>
+    EntityGroup *GroupManager<UT>::findParent(const EntityFilter &f)
+    {
+        EntityGroup *result{nullptr};
+
+        auto testGroup = [&] (EntityGroup *grp) {
+            if (f.refines(grp->filter()) &&
+                (result == nullptr ||
+                 grp->filter().compPositionsUsed() > result->filter().compPositionsUsed()))
+            {
+                result = grp;
+            }
+        };
+
+        for (EntityGroup *grp : mActiveGroups)
+        {
+            testGroup(grp);
+        }
+        for (EntityGroup *grp : mNewGroups)
+        {
+            testGroup(grp);
+        }
+
+        return result;
+    }
 
-        // Register reset handle.
-        mDestructOnReset.emplace_back(group<RequireT, RejectT>().destructLater());
+    template <typename UT>
+    void GroupManager<UT>::linkParent(EntityGroup *grp, EntityGroup *parent)
+    {
+        grp->mParent = parent;
+        grp->mResidual = parent ? grp->filter().residual(parent->filter()) : grp->filter();
+    }
+
+    template <typename UT>
+    void GroupManager<UT>::unlinkGroup(EntityGroup *grp)
+    {
+        for (EntityGroup *child : mActiveGroups)
+        {
+            if (child->mParent == grp)
+            {
+                linkParent(child, grp->mParent);
+            }
+        }
+        for (EntityGroup *child : mNewGroups)
+        {
+            if (child->mParent == grp)
+            {
+                linkParent(child, grp->mParent);
+            }
+        }
+
+        linkParent(grp, nullptr);
+        // Removed Groups are not refreshed anymore.
+        grp->refresh(nullptr);
     }
 
     template <typename UT>
@@ -349,14 +766,35 @@ namespace ent
         return false;
     }
 
+    template <typename UT>
+    bool GroupManager<UT>::cached(const EntityGroup *grp) const
+    {
+        auto found{mCachedGroups.find(grp->filter())};
+        return found != mCachedGroups.end() && found->second.group.get() == grp;
+    }
+
+    template <typename UT>
+    bool GroupManager<UT>::expired(const EntityGroup *grp) const
+    {
+        return !grp->inUse() && !cached(grp);
+    }
+
     template <typename UT>
     void GroupManager<UT>::removeInactive(std::vector<EntityGroup*> &groups)
     {
         if (!groups.empty())
         {
+            for (EntityGroup *grp : groups)
+            {
+                if (expired(grp))
+                {
+                    unlinkGroup(grp);
+                }
+            }
+
             groups.erase(std::remove_if(groups.begin(), groups.end(),
-                                        [] (EntityGroup *grp) {
-                                            return !grp->inUse();
+                                        [this] (EntityGroup *grp) {
+                                            return expired(grp);
                                         }), groups.end());
         }
     }
@@ -14,6 +14,7 @@
 
 #include "Types.h"
 #include "Util.h"
+#include "MemoryResource.h"
 
 /// Main Entropy namespace
 namespace ent
@@ -23,10 +24,11 @@ namespace ent
      *  Constructors are NOT called automatically on elements.
      *  Destructors are NOT called automatically on elements.
      * @tparam T Type of the element.
-     * @tparam Allocator Type of the allocator used.
+     * @tparam Allocator Type of the allocator used, by default
+     *   the current MemoryResource is used.
      */
     template <typename T,
-        typename Allocator = std::allocator<T>>
+        typename Allocator = ResourceAllocator<T>>
     class List final
     {
     private:
@@ -119,8 +121,8 @@ namespace ent
         /// Copy constructor.
         inline List(const List &other, const Allocator &alloc);
 
-        /// Move constructor.
-        inline List(List &&other);
+        /// Move constructor, data are not moved.
+        inline List(List &&other) noexcept;
         /// Move constructor.
         inline List(List &&other, const Allocator &alloc);
 
@@ -269,7 +271,7 @@ namespace ent
          * @param cArgs Constructor arguments.
          */
         template <typename... CArgTs>
-        inline void emplaceBack(CArgTs... cArgs);
+        inline void emplaceBack(CArgTs &&...cArgs);
 
         /**
          * Pop the element from the back of the List.
@@ -331,7 +333,7 @@ namespace ent
          * @return Returns iterator to the position.
          */
         template <typename... CArgTs>
-        iterator emplace(iterator pos, CArgTs... cArgs)
+        iterator emplace(iterator pos, CArgTs &&...cArgs)
         { return emplaceImpl(pos - begin(), std::forward<CArgTs>(cArgs)...); }
 
         /**
@@ -372,10 +374,10 @@ namespace ent
         { reset(); }
 
         /**
-         * Swap values with the other List.
+         * Swap values and allocators with the other List.
          * @param other The swapped List.
          */
-        inline void swap(List &other);
+        inline void swap(List &other) noexcept;
 
         template <typename LT, typename AT>
         friend iterator begin(List<LT, AT> &list);
@@ -418,7 +420,7 @@ namespace ent
          * @param cArgs Constructor arguments.
          */
         template <typename... CArgTs>
-        inline void constructImpl(iterator it, CArgTs... cArgs);
+        inline void constructImpl(iterator it, CArgTs &&...cArgs);
 
         /**
          * Set element on given position to the value.
@@ -466,7 +468,7 @@ namespace ent
          * @return Returns iterator to the position.
          */
         template <typename... CArgTs>
-        inline iterator emplaceImpl(size_type pos, CArgTs... cArgs);
+        inline iterator emplaceImpl(size_type pos, CArgTs &&...cArgs);
 
         /**
          * Erase element on given position and move the List
@@ -499,7 +501,7 @@ namespace ent
          * @param cArgs Constructor arguments.
          */
         template <typename... CArgTs>
-        inline void emplaceBackImpl(CArgTs... cArgs);
+        inline void emplaceBackImpl(CArgTs &&...cArgs);
 
         /**
          * Copy range between iterators into this List.
@@ -61,7 +61,7 @@ namespace ent
 
     template <typename T,
         typename Allocator>
-    List<T, Allocator>::List(List &&other) :
+    List<T, Allocator>::List(List &&other) noexcept :
         mAllocator{std::move(other.mAllocator)}
     {
         swap(other);
@@ -270,11 +270,13 @@ namespace ent
 
     template <typename T,
         typename Allocator>
-    void List<T, Allocator>::swap(List &other)
+    void List<T, Allocator>::swap(List &other) noexcept
     {
         std::swap(mData, other.mData);
         std::swap(mAllocated, other.mAllocated);
         std::swap(mInUse, other.mInUse);
+        // Memory stays with the allocator, which allocated it.
+        std::swap(mAllocator, other.mAllocator);
     }
 
     template <typename T,
@@ -292,7 +294,7 @@ namespace ent
     template <typename T,
               typename Allocator>
     template <typename... CArgTs>
-    void List<T, Allocator>::constructImpl(iterator it, CArgTs... cArgs)
+    void List<T, Allocator>::constructImpl(iterator it, CArgTs &&...cArgs)
     {
         new (it) T(std::forward<CArgTs>(cArgs)...);
     }
@@ -364,7 +366,7 @@ namespace ent
     template <typename T,
               typename Allocator>
     template <typename... CArgTs>
-    auto List<T, Allocator>::emplaceImpl(size_type pos, CArgTs... cArgs) -> iterator
+    auto List<T, Allocator>::emplaceImpl(size_type pos, CArgTs &&...cArgs) -> iterator
     {
         reserve(size() + 1);
         iterator it{begin() + pos};
@@ -448,7 +450,7 @@ namespace ent
     template <typename T,
               typename Allocator>
     template <typename... CArgTs>
-    void List<T, Allocator>::emplaceBack(CArgTs... cArgs)
+    void List<T, Allocator>::emplaceBack(CArgTs &&...cArgs)
     {
         reserveOne();
         emplaceBackImpl(std::forward<CArgTs>(cArgs)...);
@@ -465,7 +467,7 @@ namespace ent
     template <typename T,
               typename Allocator>
     template <typename... CArgTs>
-    void List<T, Allocator>::emplaceBackImpl(CArgTs... cArgs)
+    void List<T, Allocator>::emplaceBackImpl(CArgTs &&...cArgs)
     {
         constructImpl(useEndPtr(), std::forward<CArgTs>(cArgs)...);
         ++mInUse;
@@ -1,12 +1,14 @@
 /**
  * @file Entropy/Memory.h
  * @author Tomas Polasek
- * @brief 
+ * @brief Memory resources and containers used in Entropy ECS.
  */
 
 #ifndef ECS_FIT_MEMORY_H
 #define ECS_FIT_MEMORY_H
 
+#include "MemoryResource.h"
+#include "MemoryReport.h"
 #include "List.h"
 #include "SortedList.h"
 
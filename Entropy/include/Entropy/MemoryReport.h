@@ -0,0 +1,132 @@
+/**
+ * @file Entropy/MemoryReport.h
+ * @author Tomas Polasek
+ * @brief Report of memory used by the Universe.
+ */
+
+#ifndef ECS_FIT_MEMORYREPORT_H
+#define ECS_FIT_MEMORYREPORT_H
+
+#include <ostream>
+#include <vector>
+
+#include "Types.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Memory used by a single container, or by a group
+     * of containers.
+     * Reserved memory contains the used memory, which
+     * contains the live data and holes left by removed
+     * elements.
+     */
+    struct MemoryUsage
+    {
+        /**
+         * Get usage of a list-like container without holes.
+         * @tparam ContainerT Type of the container, has to
+         *   provide size() and capacity().
+         * @param list The container.
+         * @return Returns usage of the container.
+         */
+        template <typename ContainerT>
+        static MemoryUsage ofList(const ContainerT &list)
+        {
+            using ValueT = typename ContainerT::value_type;
+            const u64 used{static_cast<u64>(list.size()) * sizeof(ValueT)};
+            return {static_cast<u64>(list.capacity()) * sizeof(ValueT), used, used};
+        }
+
+        /**
+         * Get estimated usage of a node based container, each
+         * node is expected to contain color and 3 pointers.
+         * @tparam ContainerT Type of the container, has to
+         *   provide size().
+         * @param map The container.
+         * @return Returns usage of the container.
+         */
+        template <typename ContainerT>
+        static MemoryUsage ofNodes(const ContainerT &map)
+        {
+            using ValueT = typename ContainerT::value_type;
+            const u64 used{static_cast<u64>(map.size()) * sizeof(ValueT)};
+            return {used + static_cast<u64>(map.size()) * 4u * sizeof(void*), used, used};
+        }
+
+        /// Fraction of the reserved memory, which contains live data.
+        double fillRatio() const
+        { return reserved ? static_cast<double>(live) / reserved : 1.0; }
+
+        /// Fraction of the used memory, which is taken by holes.
+        double fragmentation() const
+        { return used ? static_cast<double>(used - live) / used : 0.0; }
+
+        /// Add usage of another container.
+        MemoryUsage &operator+=(const MemoryUsage &other)
+        {
+            reserved += other.reserved;
+            used += other.used;
+            live += other.live;
+            return *this;
+        }
+
+        /// Bytes allocated by the container.
+        u64 reserved{0u};
+        /// Bytes of the elements, including holes.
+        u64 used{0u};
+        /// Bytes of the live elements.
+        u64 live{0u};
+    }; // struct MemoryUsage
+
+    /// Memory used by a single Component type.
+    struct ComponentMemoryUsage
+    {
+        /// ID of the Component, as returned by registerComponent.
+        CIdType id{0u};
+        /// Number of Entities, which have the Component.
+        u64 count{0u};
+        /// Memory used by the Component holder.
+        MemoryUsage holder;
+    }; // struct ComponentMemoryUsage
+
+    /**
+     * Memory used by the Universe, split by the subsystems.
+     */
+    struct MemoryReport
+    {
+        /// Print user readable information.
+        inline void print(std::ostream &out) const;
+
+        /// Memory used by all of the subsystems.
+        inline MemoryUsage total() const;
+
+        /// Component, group and flag columns of the Entity metadata.
+        MemoryUsage metadataColumns;
+        /// Generation numbers of the Entities.
+        MemoryUsage generations;
+        /// Free Entity indices and free Group IDs.
+        MemoryUsage freeList;
+        /// Component holders, indexed by the Component ID.
+        std::vector<ComponentMemoryUsage> components;
+        /// Entity lists of the Groups, including added and removed.
+        MemoryUsage groupLists;
+        /// Number of existing Groups, including the cached ones.
+        u64 numGroups{0u};
+        /// ChangeSets used by the threads, pending and pooled.
+        MemoryUsage changeSets;
+        /// Number of committed ChangeSets, waiting for refresh.
+        u64 pendingChangeSets{0u};
+        /// Number of cleared ChangeSets, ready for reuse.
+        u64 pooledChangeSets{0u};
+        /// Lists of changed and written Entities.
+        MemoryUsage changedLists;
+        /// Frame arena, used for transient lists.
+        MemoryUsage frameArena;
+    }; // struct MemoryReport
+} // namespace ent
+
+#include "MemoryReport.inl"
+
+#endif //ECS_FIT_MEMORYREPORT_H
@@ -0,0 +1,61 @@
+/**
+ * @file Entropy/MemoryReport.inl
+ * @author Tomas Polasek
+ * @brief Report of memory used by the Universe.
+ */
+
+#include "MemoryReport.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    // MemoryReport implementation.
+    void MemoryReport::print(std::ostream &out) const
+    {
+        auto printUsage = [&] (const MemoryUsage &usage) {
+            out << ": " << usage.used << "/" << usage.reserved
+                << " B (fill " << usage.fillRatio()
+                << ", fragmentation " << usage.fragmentation() << ")\n";
+        };
+
+        out << "Universe memory (used/reserved):\n";
+        out << "\tMetadata columns"; printUsage(metadataColumns);
+        out << "\tGenerations"; printUsage(generations);
+        out << "\tFree lists"; printUsage(freeList);
+        for (const ComponentMemoryUsage &comp : components)
+        {
+            out << "\tComponent " << static_cast<u64>(comp.id)
+                << " [" << comp.count << "]";
+            printUsage(comp.holder);
+        }
+        out << "\tGroups: " << numGroups << "\n";
+        out << "\tGroup lists"; printUsage(groupLists);
+        out << "\tChangeSets (pending/pooled): " << pendingChangeSets
+            << "/" << pooledChangeSets << "\n";
+        out << "\tChangeSets"; printUsage(changeSets);
+        out << "\tChanged lists"; printUsage(changedLists);
+        out << "\tFrame arena"; printUsage(frameArena);
+        out << "\tTotal"; printUsage(total());
+        out.flush();
+    }
+
+    MemoryUsage MemoryReport::total() const
+    {
+        MemoryUsage result;
+
+        result += metadataColumns;
+        result += generations;
+        result += freeList;
+        for (const ComponentMemoryUsage &comp : components)
+        {
+            result += comp.holder;
+        }
+        result += groupLists;
+        result += changeSets;
+        result += changedLists;
+        result += frameArena;
+
+        return result;
+    }
+    // MemoryReport implementation end.
+} // namespace ent
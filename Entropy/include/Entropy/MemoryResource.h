@@ -0,0 +1,493 @@
+/**
+ * @file Entropy/MemoryResource.h
+ * @author Tomas Polasek
+ * @brief Memory resources and allocator used by all internal containers.
+ */
+
+#ifndef ECS_FIT_MEMORYRESOURCE_H
+#define ECS_FIT_MEMORYRESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "Types.h"
+#include "Util.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Source of memory for containers using ResourceAllocator.
+     * Each container remembers the resource, which was active
+     * on its thread when the container has been created, and
+     * uses it for all of its allocations.
+     * Resources, which are used by the Universe, have to be
+     * thread-safe and have to outlive the Universe.
+     */
+    class MemoryResource : NonCopyable
+    {
+    public:
+        virtual ~MemoryResource() = default;
+
+        /**
+         * Allocate memory block.
+         * @param bytes Size of the block in bytes.
+         * @param alignment Required alignment, power of 2.
+         * @return Returns ptr to the block.
+         * @throws std::bad_alloc when the memory cannot be allocated.
+         */
+        virtual void *allocate(u64 bytes, u64 alignment) = 0;
+
+        /**
+         * Deallocate memory block allocated by this resource.
+         * @param ptr Ptr to the block.
+         * @param bytes Size of the block, as passed to allocate.
+         * @param alignment Alignment, as passed to allocate.
+         */
+        virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept = 0;
+
+        /**
+         * Resource used by containers created on the current thread.
+         * @return Returns the innermost MemoryScope resource, or the
+         *   default resource, if there is no scope.
+         */
+        static MemoryResource *current()
+        {
+            MemoryResource *resource{threadCurrent()};
+            return resource ? resource : defaultResource();
+        }
+
+        /// Resource using the global operator new.
+        static inline MemoryResource *defaultResource();
+    private:
+        friend class MemoryScope;
+
+        /// Resource set by MemoryScope on the current thread.
+        static MemoryResource *&threadCurrent()
+        {
+            static thread_local MemoryResource *resource{nullptr};
+            return resource;
+        }
+    protected:
+    }; // class MemoryResource
+
+    /**
+     * Sets the resource used by containers created on the
+     * current thread, until the scope is destroyed.
+     * @code
+     * ent::PoolMemoryResource pool;
+     * {
+     *     ent::MemoryScope scope(&pool);
+     *     // Allocated from the pool.
+     *     ent::List<u64> list;
+     *     list.pushBack(42u);
+     * }
+     * @endcode
+     */
+    class MemoryScope : NonCopyable
+    {
+    public:
+        /**
+         * Activate given resource.
+         * @param resource The resource, nullptr for the
+         *   default resource.
+         */
+        explicit MemoryScope(MemoryResource *resource) :
+            mPrevious{MemoryResource::threadCurrent()}, mActive{true}
+        { MemoryResource::threadCurrent() = resource; }
+
+        /// Restore the previous resource.
+        ~MemoryScope()
+        { release(); }
+
+        /// Restore the previous resource before the scope ends.
+        void release()
+        {
+            if (mActive)
+            {
+                MemoryResource::threadCurrent() = mPrevious;
+                mActive = false;
+            }
+        }
+    private:
+        /// Resource active before this scope.
+        MemoryResource *mPrevious;
+        /// Is this scope still active?
+        bool mActive;
+    protected:
+    }; // class MemoryScope
+
+    /**
+     * Allocator using a MemoryResource.
+     * Default constructed allocator uses the current resource,
+     * see MemoryResource::current(). Allocators are not
+     * propagated on assignment, so containers keep their
+     * resource for their whole lifetime.
+     * @tparam T Type of the allocated elements.
+     */
+    template <typename T>
+    class ResourceAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = ResourceAllocator<U>;
+        }; // struct rebind
+
+        /// Use the current resource.
+        ResourceAllocator() noexcept :
+            mResource{MemoryResource::current()}
+        { }
+
+        /**
+         * Use given resource.
+         * @param resource The resource, nullptr for the
+         *   current resource.
+         */
+        ResourceAllocator(MemoryResource *resource) noexcept :
+            mResource{resource ? resource : MemoryResource::current()}
+        { }
+
+        template <typename U>
+        ResourceAllocator(const ResourceAllocator<U> &other) noexcept :
+            mResource{other.resource()}
+        { }
+
+        /// Allocate memory for given number of elements.
+        T *allocate(std::size_t n)
+        { return static_cast<T*>(mResource->allocate(n * sizeof(T), alignof(T))); }
+
+        /// Deallocate memory allocated by allocate(n).
+        void deallocate(T *ptr, std::size_t n) noexcept
+        { mResource->deallocate(ptr, n * sizeof(T), alignof(T)); }
+
+        /// Copied containers use the current resource.
+        ResourceAllocator select_on_container_copy_construction() const noexcept
+        { return ResourceAllocator(); }
+
+        /// Get the resource used by this allocator.
+        MemoryResource *resource() const noexcept
+        { return mResource; }
+    private:
+        /// Resource used for all allocations.
+        MemoryResource *mResource;
+    protected:
+    }; // class ResourceAllocator
+
+    template <typename T, typename U>
+    bool operator==(const ResourceAllocator<T> &lhs, const ResourceAllocator<U> &rhs) noexcept
+    { return lhs.resource() == rhs.resource(); }
+
+    template <typename T, typename U>
+    bool operator!=(const ResourceAllocator<T> &lhs, const ResourceAllocator<U> &rhs) noexcept
+    { return !(lhs == rhs); }
+
+    /// Resource using the global operator new.
+    class DefaultMemoryResource final : public MemoryResource
+    {
+    public:
+        inline virtual void *allocate(u64 bytes, u64 alignment) override final;
+        inline virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept override final;
+    private:
+    protected:
+    }; // class DefaultMemoryResource
+
+    /**
+     * Monotonic resource, memory is taken from large blocks
+     * and it is returned only when the whole arena is released.
+     * Deallocation does nothing, so the arena should be used
+     * for Universes with bounded lifetime, e.g. a single shard
+     * of a simulation.
+     * @remarks Is thread-safe.
+     */
+    class ArenaMemoryResource final : public MemoryResource
+    {
+    public:
+        /**
+         * Create empty arena.
+         * @param blockSize Minimal size of the blocks.
+         * @param upstream Resource used for the blocks.
+         */
+        inline explicit ArenaMemoryResource(u64 blockSize = ENT_ARENA_BLOCK_SIZE,
+                                            MemoryResource *upstream = defaultResource());
+
+        /// Release all of the blocks.
+        inline ~ArenaMemoryResource();
+
+        inline virtual void *allocate(u64 bytes, u64 alignment) override final;
+        inline virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept override final;
+
+        /**
+         * Return all of the blocks to the upstream resource.
+         * @warning No memory allocated from the arena can
+         *   be used after the release!
+         */
+        inline void release();
+
+        /**
+         * Make all of the memory available again. Blocks are
+         * merged into a single block, so the same amount of
+         * allocations fits into it next time.
+         * @warning No memory allocated from the arena can
+         *   be used after the rewind!
+         */
+        inline void rewind();
+
+        /// Number of bytes taken from the upstream resource.
+        inline u64 reserved() const;
+
+        /// Number of bytes allocated from the arena.
+        inline u64 used() const;
+    private:
+        /// Memory block taken from the upstream.
+        struct Block
+        {
+            /// Beginning of the block.
+            u8 *data;
+            /// Size of the block in bytes.
+            u64 size;
+        }; // struct Block
+
+        /// Lock for the arena state.
+        mutable std::mutex mMutex;
+        /// Minimal size of the blocks.
+        u64 mBlockSize;
+        /// Resource used for the blocks.
+        MemoryResource *mUpstream;
+        /// All of the blocks, the last one is being used.
+        std::vector<Block> mBlocks;
+        /// First free byte in the last block.
+        u64 mOffset;
+        /// Number of bytes allocated from the arena.
+        u64 mUsed;
+    protected:
+    }; // class ArenaMemoryResource
+
+    /**
+     * Double-buffered arena for transient data of the refresh.
+     * Each frame allocates from one of two arenas, starting a new
+     * frame rewinds the other arena. Memory allocated during a frame
+     * stays valid until the end of the following frame, so data
+     * created by one refresh can be used until the next refresh
+     * replaces it.
+     * Containers using the frame arena have to be re-created
+     * from resource() on each frame, otherwise they would keep
+     * using the rewound memory.
+     * @remarks Allocation is thread-safe, nextFrame is not.
+     */
+    class FrameArena : NonCopyable
+    {
+    public:
+        /**
+         * Create frame arena without any memory.
+         * @param upstream Resource used for the blocks.
+         * @param blockSize Minimal size of the blocks.
+         */
+        inline explicit FrameArena(MemoryResource *upstream = MemoryResource::defaultResource(),
+                                   u64 blockSize = ENT_ARENA_BLOCK_SIZE);
+
+        /// Resource of the current frame.
+        MemoryResource *resource()
+        { return mCurrent; }
+
+        /**
+         * Start the next frame. Memory allocated during the
+         * previous frame stays valid, memory of the frame
+         * before it is reused.
+         */
+        inline void nextFrame();
+
+        /// Number of bytes taken from the upstream resource.
+        u64 reserved() const
+        { return mFirst.reserved() + mSecond.reserved(); }
+
+        /// Number of bytes allocated during the current frame.
+        u64 used() const
+        { return mCurrent->used(); }
+    private:
+        /// Arena of even frames.
+        ArenaMemoryResource mFirst;
+        /// Arena of odd frames.
+        ArenaMemoryResource mSecond;
+        /// Arena of the current frame.
+        ArenaMemoryResource *mCurrent;
+    protected:
+    }; // class FrameArena
+
+    /**
+     * Resource keeping free lists for power of 2 size classes
+     * up to ENT_POOL_MAX_SIZE bytes. Freed blocks are reused
+     * by allocations of the same size class, larger allocations
+     * are passed to the upstream resource.
+     * @remarks Is thread-safe.
+     */
+    class PoolMemoryResource final : public MemoryResource
+    {
+    public:
+        /**
+         * Create empty pool.
+         * @param upstream Resource used for the chunks and
+         *   large allocations.
+         */
+        inline explicit PoolMemoryResource(MemoryResource *upstream = defaultResource());
+
+        /// Return all of the chunks to the upstream resource.
+        inline ~PoolMemoryResource();
+
+        inline virtual void *allocate(u64 bytes, u64 alignment) override final;
+        inline virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept override final;
+
+        /// Number of bytes in chunks taken from the upstream resource.
+        inline u64 reserved() const;
+    private:
+        /// Smallest size class.
+        static constexpr u64 MIN_SIZE{16u};
+        /// Alignment of the chunks.
+        static constexpr u64 CHUNK_ALIGNMENT{64u};
+        /// Maximal number of size classes.
+        static constexpr u64 NUM_CLASSES{32u};
+
+        /// Free block, linked in the free list.
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        }; // struct FreeBlock
+
+        /**
+         * Get size class for given allocation.
+         * @return Returns index of the size class, or NUM_CLASSES,
+         *   if the allocation should use the upstream resource.
+         */
+        static inline u64 sizeClass(u64 bytes, u64 alignment);
+
+        /// Lock for the free lists.
+        mutable std::mutex mMutex;
+        /// Resource used for the chunks.
+        MemoryResource *mUpstream;
+        /// Free lists for each of the size classes.
+        FreeBlock *mFree[NUM_CLASSES];
+        /// Chunks taken from the upstream resource.
+        std::vector<std::pair<void*, u64>> mChunks;
+        /// Number of bytes in the chunks.
+        u64 mReserved;
+    protected:
+    }; // class PoolMemoryResource
+
+    /**
+     * Resource using huge pages for large allocations, e.g.
+     * large Component holders. Allocations of at least the
+     * threshold size are mapped directly, using explicit huge
+     * pages when they are available, otherwise transparent huge
+     * pages are requested. Smaller allocations, and all of the
+     * allocations on platforms without mmap, are passed to
+     * the upstream resource.
+     * @remarks Is thread-safe.
+     */
+    class HugePageMemoryResource final : public MemoryResource
+    {
+    public:
+        /**
+         * @param threshold Minimal size of allocations
+         *   using the huge pages.
+         * @param upstream Resource used for smaller allocations.
+         */
+        inline explicit HugePageMemoryResource(u64 threshold = ENT_HUGE_PAGE_SIZE,
+                                               MemoryResource *upstream = defaultResource());
+
+        inline virtual void *allocate(u64 bytes, u64 alignment) override final;
+        inline virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept override final;
+
+        /// Number of allocations currently mapped by this resource.
+        u64 mapped() const
+        { return mMapped.load(std::memory_order_relaxed); }
+
+        /// Number of allocations, which got explicit huge pages.
+        u64 hugePages() const
+        { return mHugePages.load(std::memory_order_relaxed); }
+    private:
+        /// Is given allocation mapped directly?
+        bool isMapped(u64 bytes, u64 alignment) const
+        { return bytes >= mThreshold && alignment <= PAGE_ALIGNMENT; }
+
+        /// Largest alignment of mapped allocations.
+        static constexpr u64 PAGE_ALIGNMENT{4096u};
+
+        /// Minimal size of allocations using the huge pages.
+        u64 mThreshold;
+        /// Resource used for smaller allocations.
+        MemoryResource *mUpstream;
+        /// Number of allocations currently mapped.
+        std::atomic<u64> mMapped;
+        /// Number of allocations, which got explicit huge pages.
+        std::atomic<u64> mHugePages;
+    protected:
+    }; // class HugePageMemoryResource
+
+    /**
+     * Resource counting allocations passed to the upstream
+     * resource, used for measuring memory usage of a single
+     * Universe, or a part of it.
+     * @remarks Is thread-safe.
+     */
+    class TrackingMemoryResource final : public MemoryResource
+    {
+    public:
+        /// @param upstream Resource used for the allocations.
+        inline explicit TrackingMemoryResource(MemoryResource *upstream = defaultResource());
+
+        inline virtual void *allocate(u64 bytes, u64 alignment) override final;
+        inline virtual void deallocate(void *ptr, u64 bytes, u64 alignment) noexcept override final;
+
+        /// Number of allocations.
+        u64 allocations() const
+        { return mAllocations.load(std::memory_order_relaxed); }
+
+        /// Number of deallocations.
+        u64 deallocations() const
+        { return mDeallocations.load(std::memory_order_relaxed); }
+
+        /// Number of bytes currently allocated.
+        u64 bytesInUse() const
+        { return mBytesInUse.load(std::memory_order_relaxed); }
+
+        /// Highest number of bytes allocated at once.
+        u64 peakBytes() const
+        { return mPeakBytes.load(std::memory_order_relaxed); }
+
+        /// Number of bytes allocated in total.
+        u64 totalBytes() const
+        { return mTotalBytes.load(std::memory_order_relaxed); }
+
+        /// Reset the counters, except for bytes in use.
+        inline void resetCounters();
+    private:
+        /// Resource used for the allocations.
+        MemoryResource *mUpstream;
+        /// Number of allocations.
+        std::atomic<u64> mAllocations;
+        /// Number of deallocations.
+        std::atomic<u64> mDeallocations;
+        /// Number of bytes currently allocated.
+        std::atomic<u64> mBytesInUse;
+        /// Highest number of bytes allocated at once.
+        std::atomic<u64> mPeakBytes;
+        /// Number of bytes allocated in total.
+        std::atomic<u64> mTotalBytes;
+    protected:
+    }; // class TrackingMemoryResource
+} // namespace ent
+
+#include "MemoryResource.inl"
+
+#endif //ECS_FIT_MEMORYRESOURCE_H
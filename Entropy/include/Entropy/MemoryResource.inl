@@ -0,0 +1,343 @@
+/**
+ * @file Entropy/MemoryResource.inl
+ * @author Tomas Polasek
+ * @brief Memory resources and allocator used by all internal containers.
+ */
+
+#include "MemoryResource.h"
+
+#ifndef _WIN32
+#   include <sys/mman.h>
+#endif
+
+/// Main Entropy namespace
+namespace ent
+{
+    // MemoryResource implementation.
+    MemoryResource *MemoryResource::defaultResource()
+    {
+        // Never destroyed, containers with static storage may outlive it.
+        static MemoryResource *resource{new DefaultMemoryResource};
+        return resource;
+    }
+    // MemoryResource implementation end.
+
+    // DefaultMemoryResource implementation.
+    void *DefaultMemoryResource::allocate(u64 bytes, u64 alignment)
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            return ::operator new(bytes);
+        }
+
+        // Over-allocate and keep the original ptr in front of the block.
+        u8 *raw{static_cast<u8*>(::operator new(bytes + alignment))};
+        u8 *result{raw + alignment - reinterpret_cast<std::uintptr_t>(raw) % alignment};
+        reinterpret_cast<void**>(result)[-1] = raw;
+
+        return result;
+    }
+
+    void DefaultMemoryResource::deallocate(void *ptr, u64 /*bytes*/, u64 alignment) noexcept
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            ::operator delete(ptr);
+        }
+        else if (ptr)
+        {
+            ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+        }
+    }
+    // DefaultMemoryResource implementation end.
+
+    // ArenaMemoryResource implementation.
+    ArenaMemoryResource::ArenaMemoryResource(u64 blockSize, MemoryResource *upstream) :
+        mBlockSize{blockSize}, mUpstream{upstream}, mOffset{0u}, mUsed{0u}
+    { }
+
+    ArenaMemoryResource::~ArenaMemoryResource()
+    {
+        release();
+    }
+
+    void *ArenaMemoryResource::allocate(u64 bytes, u64 alignment)
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+
+        if (!mBlocks.empty())
+        {
+            Block &block(mBlocks.back());
+            const u64 misalignment{reinterpret_cast<std::uintptr_t>(block.data + mOffset) % alignment};
+            const u64 begin{mOffset + (misalignment ? alignment - misalignment : 0u)};
+            if (begin + bytes <= block.size)
+            {
+                mOffset = begin + bytes;
+                mUsed += bytes;
+                return block.data + begin;
+            }
+        }
+
+        // Start a new block, large allocations get a block of their own.
+        const u64 blockSize{bytes + alignment > mBlockSize ? bytes + alignment : mBlockSize};
+        mBlocks.reserve(mBlocks.size() + 1u);
+        u8 *data{static_cast<u8*>(mUpstream->allocate(blockSize, alignof(std::max_align_t)))};
+        mBlocks.push_back({data, blockSize});
+
+        const u64 misalignment{reinterpret_cast<std::uintptr_t>(data) % alignment};
+        const u64 begin{misalignment ? alignment - misalignment : 0u};
+        mOffset = begin + bytes;
+        mUsed += bytes;
+
+        return data + begin;
+    }
+
+    void ArenaMemoryResource::deallocate(void*, u64, u64) noexcept
+    { }
+
+    void ArenaMemoryResource::release()
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+
+        for (Block &block : mBlocks)
+        {
+            mUpstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+        }
+        mBlocks.clear();
+        mOffset = 0u;
+        mUsed = 0u;
+    }
+
+    void ArenaMemoryResource::rewind()
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+
+        if (mBlocks.size() > 1u)
+        { // Merge the blocks.
+            u64 total{0u};
+            for (Block &block : mBlocks)
+            {
+                total += block.size;
+                mUpstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+            }
+            mBlocks.clear();
+
+            mBlocks.push_back({static_cast<u8*>(mUpstream->allocate(total, alignof(std::max_align_t))), total});
+        }
+
+        mOffset = 0u;
+        mUsed = 0u;
+    }
+
+    u64 ArenaMemoryResource::reserved() const
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+
+        u64 result{0u};
+        for (const Block &block : mBlocks)
+        {
+            result += block.size;
+        }
+
+        return result;
+    }
+
+    u64 ArenaMemoryResource::used() const
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+        return mUsed;
+    }
+    // ArenaMemoryResource implementation end.
+
+    // FrameArena implementation.
+    FrameArena::FrameArena(MemoryResource *upstream, u64 blockSize) :
+        mFirst(blockSize, upstream), mSecond(blockSize, upstream), mCurrent{&mFirst}
+    { }
+
+    void FrameArena::nextFrame()
+    {
+        mCurrent = mCurrent == &mFirst ? &mSecond : &mFirst;
+        mCurrent->rewind();
+    }
+    // FrameArena implementation end.
+
+    // PoolMemoryResource implementation.
+    PoolMemoryResource::PoolMemoryResource(MemoryResource *upstream) :
+        mUpstream{upstream}, mFree{}, mReserved{0u}
+    { }
+
+    PoolMemoryResource::~PoolMemoryResource()
+    {
+        for (auto &chunk : mChunks)
+        {
+            mUpstream->deallocate(chunk.first, chunk.second, CHUNK_ALIGNMENT);
+        }
+    }
+
+    u64 PoolMemoryResource::sizeClass(u64 bytes, u64 alignment)
+    {
+        u64 size{bytes > alignment ? bytes : alignment};
+        if (size > ENT_POOL_MAX_SIZE || alignment > CHUNK_ALIGNMENT)
+        {
+            return NUM_CLASSES;
+        }
+
+        u64 result{0u};
+        for (u64 classSize = MIN_SIZE; classSize < size; classSize <<= 1u)
+        {
+            result++;
+        }
+
+        return result;
+    }
+
+    void *PoolMemoryResource::allocate(u64 bytes, u64 alignment)
+    {
+        const u64 sClass{sizeClass(bytes, alignment)};
+        if (sClass >= NUM_CLASSES)
+        {
+            return mUpstream->allocate(bytes, alignment);
+        }
+
+        std::lock_guard<std::mutex> g(mMutex);
+
+        if (!mFree[sClass])
+        { // Split a new chunk into blocks of this size class.
+            const u64 blockSize{MIN_SIZE << sClass};
+            const u64 chunkSize{ENT_POOL_CHUNK_SIZE > blockSize ? ENT_POOL_CHUNK_SIZE : blockSize};
+            mChunks.reserve(mChunks.size() + 1u);
+            u8 *chunk{static_cast<u8*>(mUpstream->allocate(chunkSize, CHUNK_ALIGNMENT))};
+            mChunks.emplace_back(chunk, chunkSize);
+            mReserved += chunkSize;
+
+            for (u64 offset = chunkSize; offset >= blockSize; offset -= blockSize)
+            {
+                FreeBlock *block{reinterpret_cast<FreeBlock*>(chunk + offset - blockSize)};
+                block->next = mFree[sClass];
+                mFree[sClass] = block;
+            }
+        }
+
+        FreeBlock *result{mFree[sClass]};
+        mFree[sClass] = result->next;
+
+        return result;
+    }
+
+    void PoolMemoryResource::deallocate(void *ptr, u64 bytes, u64 alignment) noexcept
+    {
+        const u64 sClass{sizeClass(bytes, alignment)};
+        if (sClass >= NUM_CLASSES)
+        {
+            mUpstream->deallocate(ptr, bytes, alignment);
+            return;
+        }
+
+        std::lock_guard<std::mutex> g(mMutex);
+
+        FreeBlock *block{static_cast<FreeBlock*>(ptr)};
+        block->next = mFree[sClass];
+        mFree[sClass] = block;
+    }
+
+    u64 PoolMemoryResource::reserved() const
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+        return mReserved;
+    }
+    // PoolMemoryResource implementation end.
+
+    // HugePageMemoryResource implementation.
+    HugePageMemoryResource::HugePageMemoryResource(u64 threshold, MemoryResource *upstream) :
+        mThreshold{threshold}, mUpstream{upstream}, mMapped{0u}, mHugePages{0u}
+    { }
+
+    void *HugePageMemoryResource::allocate(u64 bytes, u64 alignment)
+    {
+#ifndef _WIN32
+        if (isMapped(bytes, alignment))
+        {
+            const u64 size{(bytes + ENT_HUGE_PAGE_SIZE - 1u) / ENT_HUGE_PAGE_SIZE * ENT_HUGE_PAGE_SIZE};
+            void *result{MAP_FAILED};
+#   ifdef MAP_HUGETLB
+            result = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (result != MAP_FAILED)
+            {
+                mHugePages.fetch_add(1u, std::memory_order_relaxed);
+            }
+#   endif
+            if (result == MAP_FAILED)
+            { // Explicit huge pages are not available.
+                result = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (result == MAP_FAILED)
+                {
+                    throw std::bad_alloc();
+                }
+#   ifdef MADV_HUGEPAGE
+                madvise(result, size, MADV_HUGEPAGE);
+#   endif
+            }
+
+            mMapped.fetch_add(1u, std::memory_order_relaxed);
+            return result;
+        }
+#endif
+
+        return mUpstream->allocate(bytes, alignment);
+    }
+
+    void HugePageMemoryResource::deallocate(void *ptr, u64 bytes, u64 alignment) noexcept
+    {
+#ifndef _WIN32
+        if (isMapped(bytes, alignment))
+        {
+            const u64 size{(bytes + ENT_HUGE_PAGE_SIZE - 1u) / ENT_HUGE_PAGE_SIZE * ENT_HUGE_PAGE_SIZE};
+            munmap(ptr, size);
+            mMapped.fetch_sub(1u, std::memory_order_relaxed);
+            return;
+        }
+#endif
+
+        mUpstream->deallocate(ptr, bytes, alignment);
+    }
+    // HugePageMemoryResource implementation end.
+
+    // TrackingMemoryResource implementation.
+    TrackingMemoryResource::TrackingMemoryResource(MemoryResource *upstream) :
+        mUpstream{upstream}, mAllocations{0u}, mDeallocations{0u},
+        mBytesInUse{0u}, mPeakBytes{0u}, mTotalBytes{0u}
+    { }
+
+    void *TrackingMemoryResource::allocate(u64 bytes, u64 alignment)
+    {
+        void *result{mUpstream->allocate(bytes, alignment)};
+
+        mAllocations.fetch_add(1u, std::memory_order_relaxed);
+        mTotalBytes.fetch_add(bytes, std::memory_order_relaxed);
+        const u64 inUse{mBytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+        u64 peak{mPeakBytes.load(std::memory_order_relaxed)};
+        while (peak < inUse && !mPeakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+        { }
+
+        return result;
+    }
+
+    void TrackingMemoryResource::deallocate(void *ptr, u64 bytes, u64 alignment) noexcept
+    {
+        mUpstream->deallocate(ptr, bytes, alignment);
+
+        mDeallocations.fetch_add(1u, std::memory_order_relaxed);
+        mBytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void TrackingMemoryResource::resetCounters()
+    {
+        mAllocations.store(0u, std::memory_order_relaxed);
+        mDeallocations.store(0u, std::memory_order_relaxed);
+        mPeakBytes.store(mBytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        mTotalBytes.store(0u, std::memory_order_relaxed);
+    }
+    // TrackingMemoryResource implementation end.
+} // namespace ent
@@ -0,0 +1,160 @@
+/**
+ * @file Entropy/RefreshMetrics.h
+ * @author Tomas Polasek
+ * @brief Timings and counters of the last Universe refreshes.
+ */
+
+#ifndef ECS_FIT_REFRESHMETRICS_H
+#define ECS_FIT_REFRESHMETRICS_H
+
+#include <vector>
+
+#ifdef _WIN32
+#   include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#else
+#   include <chrono>
+#endif
+
+#include "Types.h"
+#include "Util.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Read the time stamp counter.
+     * Platforms without rdtsc use the steady clock instead.
+     * @return Returns the number of ticks.
+     */
+    inline u64 readTimestamp()
+    {
+#if defined(_WIN32) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * Metrics of a single Universe refresh.
+     */
+    struct FrameMetrics
+    {
+        /// Phases of the refresh, in order of execution.
+        enum Phase
+        {
+            /// EntityManager refresh.
+            PHASE_ENTITIES = 0u,
+            /// Applying of the committed ChangeSets.
+            PHASE_CHANGE_SETS,
+            /// ComponentManager refresh.
+            PHASE_COMPONENTS,
+            /// Merging of changed Entities of the threads.
+            PHASE_CHANGED,
+            /// Checking of Groups and changed Entities.
+            PHASE_GROUP_CHECK,
+            /// Finalization of the Groups.
+            PHASE_GROUP_FINALIZE,
+            /// Recording of deltas and publishing of views.
+            PHASE_PUBLISH,
+
+            NUM_PHASES
+        }; // enum Phase
+
+        /// Number of ticks taken by all of the phases.
+        inline u64 totalTicks() const;
+
+        /// Number of the refresh, starting at 1.
+        u64 frame{0u};
+        /// Time stamp of the start of the refresh.
+        u64 start{0u};
+        /// Number of ticks taken by each phase.
+        u64 ticks[NUM_PHASES]{};
+        /// Number of changed Entities.
+        u64 changedEntities{0u};
+        /// Number of applied ChangeSets.
+        u64 changeSetsApplied{0u};
+        /// Number of Entities added to all of the Groups.
+        u64 groupAdded{0u};
+        /// Number of Entities removed from all of the Groups.
+        u64 groupRemoved{0u};
+    }; // struct FrameMetrics
+
+    /**
+     * Ring buffer of metrics of the last refreshes.
+     * Memory is allocated only on construction, recording
+     * of a phase costs a single time stamp read.
+     */
+    class RefreshMetrics : NonCopyable
+    {
+    public:
+        /**
+         * Create empty buffer.
+         * @param capacity Number of kept frames.
+         */
+        inline explicit RefreshMetrics(u64 capacity = ENT_REFRESH_METRICS_FRAMES);
+
+        /**
+         * Start recording of the next frame, the oldest
+         * frame is overwritten, when the buffer is full.
+         * @return Returns metrics of the new frame.
+         */
+        inline FrameMetrics &beginFrame();
+
+        /**
+         * Mark the end of given phase of the current frame.
+         * Phase takes all ticks since the end of the last
+         * phase, or since the start of the frame.
+         * @param phase The phase which has ended.
+         */
+        inline void endPhase(FrameMetrics::Phase phase);
+
+        /// Metrics of the frame being recorded.
+        FrameMetrics &current()
+        { return mFrames[mCurrent]; }
+
+        /**
+         * Get metrics of a recorded frame.
+         * @param age Age of the frame, 0 is the newest.
+         * @return Returns metrics of the frame.
+         */
+        inline const FrameMetrics &frame(u64 age) const;
+
+        /**
+         * Find the frame which took the most ticks.
+         * @return Returns ptr to the frame, or nullptr,
+         *   if there are no frames.
+         */
+        inline const FrameMetrics *slowest() const;
+
+        /// Number of recorded frames.
+        u64 size() const
+        { return mSize; }
+
+        /// Maximal number of kept frames.
+        u64 capacity() const
+        { return mFrames.size(); }
+
+        /// Remove all recorded frames.
+        inline void clear();
+    private:
+        /// Recorded frames.
+        std::vector<FrameMetrics> mFrames;
+        /// Index of the frame being recorded.
+        u64 mCurrent;
+        /// Number of recorded frames.
+        u64 mSize;
+        /// Number of frames since the construction.
+        u64 mFrameCounter;
+        /// Time stamp of the end of the last phase.
+        u64 mLastStamp;
+    protected:
+    }; // class RefreshMetrics
+} // namespace ent
+
+#include "RefreshMetrics.inl"
+
+#endif //ECS_FIT_REFRESHMETRICS_H
@@ -0,0 +1,88 @@
+/**
+ * @file Entropy/RefreshMetrics.inl
+ * @author Tomas Polasek
+ * @brief Timings and counters of the last Universe refreshes.
+ */
+
+#include "RefreshMetrics.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    // FrameMetrics implementation.
+    u64 FrameMetrics::totalTicks() const
+    {
+        u64 result{0u};
+
+        for (u64 tick : ticks)
+        {
+            result += tick;
+        }
+
+        return result;
+    }
+    // FrameMetrics implementation end.
+
+    // RefreshMetrics implementation.
+    RefreshMetrics::RefreshMetrics(u64 capacity) :
+        mFrames(capacity ? capacity : 1u), mCurrent{0u}, mSize{0u},
+        mFrameCounter{0u}, mLastStamp{0u}
+    { }
+
+    FrameMetrics &RefreshMetrics::beginFrame()
+    {
+        if (mFrameCounter)
+        {
+            mCurrent = (mCurrent + 1u) % mFrames.size();
+        }
+        if (mSize < mFrames.size())
+        {
+            mSize++;
+        }
+
+        FrameMetrics &result(mFrames[mCurrent]);
+        result = FrameMetrics{};
+        result.frame = ++mFrameCounter;
+        result.start = readTimestamp();
+        mLastStamp = result.start;
+
+        return result;
+    }
+
+    void RefreshMetrics::endPhase(FrameMetrics::Phase phase)
+    {
+        const u64 now{readTimestamp()};
+        mFrames[mCurrent].ticks[phase] = now - mLastStamp;
+        mLastStamp = now;
+    }
+
+    const FrameMetrics &RefreshMetrics::frame(u64 age) const
+    {
+        ENT_ASSERT_FAST(age < mSize);
+        return mFrames[(mCurrent + mFrames.size() - age) % mFrames.size()];
+    }
+
+    const FrameMetrics *RefreshMetrics::slowest() const
+    {
+        const FrameMetrics *result{nullptr};
+
+        for (u64 age = 0u; age < mSize; ++age)
+        {
+            const FrameMetrics &f(frame(age));
+            if (!result || result->totalTicks() < f.totalTicks())
+            {
+                result = &f;
+            }
+        }
+
+        return result;
+    }
+
+    void RefreshMetrics::clear()
+    {
+        mCurrent = 0u;
+        mSize = 0u;
+        mFrameCounter = 0u;
+    }
+    // RefreshMetrics implementation end.
+} // namespace ent
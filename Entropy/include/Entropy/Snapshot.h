@@ -0,0 +1,234 @@
+/**
+ * @file Entropy/Snapshot.h
+ * @author Tomas Polasek
+ * @brief Binary snapshot files, used for saving and loading the Universe.
+ */
+
+#ifndef ECS_FIT_SNAPSHOT_H
+#define ECS_FIT_SNAPSHOT_H
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "Util.h"
+#include "List.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /// Header at the beginning of each snapshot file.
+    struct SnapshotHeader
+    {
+        /// Identifier of snapshot files, "ENTSNAP\0".
+        static constexpr u64 MAGIC{0x0050414e53544e45ull};
+        /// Version of the format, incremented on incompatible changes.
+        static constexpr u64 VERSION{1u};
+
+        /// Should be equal to MAGIC.
+        u64 magic;
+        /// Should be equal to VERSION.
+        u64 version;
+        /// Alignment of the memory blocks.
+        u64 alignment;
+    }; // struct SnapshotHeader
+
+    /**
+     * Writer of binary snapshot files. File starts with a header,
+     * followed by values and blocks of raw memory. Blocks are aligned
+     * to ENT_SNAPSHOT_ALIGNMENT bytes from the beginning of the file,
+     * so they can be used directly from a memory mapped file.
+     * Values are written in the native byte order, snapshots are
+     * not portable between platforms.
+     */
+    class SnapshotWriter final : NonCopyable
+    {
+    public:
+        /**
+         * Create the snapshot file and write the header.
+         * @param path Path to the file, existing file is overwritten.
+         */
+        inline SnapshotWriter(const std::string &path);
+
+        /// Has everything been written successfully?
+        bool good() const
+        { return mGood; }
+
+        /**
+         * Write a single value.
+         * @tparam T Type of the value, has to be trivially copyable.
+         * @param val The value.
+         */
+        template <typename T>
+        inline void write(const T &val);
+
+        /**
+         * Start a memory block of given size. Block data
+         * are written using writeData.
+         * @param size Size of the block in bytes.
+         */
+        inline void beginBlock(u64 size);
+
+        /**
+         * Write data of the current memory block.
+         * @param data Pointer to the data.
+         * @param size Size of the data in bytes.
+         */
+        void writeData(const void *data, u64 size)
+        { writeRaw(data, size); }
+
+        /**
+         * Write a memory block.
+         * @param data Pointer to the data.
+         * @param size Size of the block in bytes.
+         */
+        void writeBlock(const void *data, u64 size)
+        { beginBlock(size); writeData(data, size); }
+
+        /**
+         * Write content of given List as a memory block.
+         * @param list The List.
+         */
+        template <typename T, typename A>
+        void writeList(const List<T, A> &list)
+        { writeBlock(list.data(), list.size() * sizeof(T)); }
+
+        /**
+         * Flush written data to the file.
+         * @return Returns true, if everything has been
+         *   written successfully.
+         */
+        inline bool flush();
+
+        /**
+         * Flush and close the file.
+         * @return Returns true, if everything has been
+         *   written successfully.
+         */
+        inline bool finish();
+    private:
+        /**
+         * Write raw bytes to the file.
+         * @param data Pointer to the data.
+         * @param size Number of bytes.
+         */
+        inline void writeRaw(const void *data, u64 size);
+
+        /// Output file.
+        std::ofstream mFile;
+        /// Number of bytes written.
+        u64 mOffset;
+        /// Has everything been written successfully?
+        bool mGood;
+    protected:
+    }; // class SnapshotWriter
+
+    /**
+     * Reader of binary snapshot files. Whole file is memory
+     * mapped, where supported, otherwise it is read into memory.
+     * Memory blocks are accessed in place, without copying.
+     * After any read fails, all following reads fail as well.
+     */
+    class SnapshotReader final : NonCopyable
+    {
+    public:
+        /**
+         * Open given snapshot file and check the header.
+         * @param path Path to the file.
+         */
+        inline SnapshotReader(const std::string &path);
+
+        /// Unmap the file.
+        inline ~SnapshotReader();
+
+        /// Have all reads been successful so far?
+        bool good() const
+        { return mGood; }
+
+        /// Is the file memory mapped?
+        bool mapped() const
+        { return mMapped; }
+
+        /// Has the whole file been read?
+        bool finished() const
+        { return mOffset == mSize; }
+
+        /**
+         * Should the data only be validated? Loaders then read
+         * and check the data, without changing any state.
+         */
+        bool validating() const
+        { return mValidating; }
+
+        /**
+         * Continue reading from the first value after the header.
+         * Used for loading the snapshot in two passes, the first
+         * one only validates the data.
+         * @param validating Should the next pass only validate
+         *   the data?
+         */
+        inline void rewind(bool validating);
+
+        /**
+         * Read a single value.
+         * @tparam T Type of the value, has to be trivially copyable.
+         * @param val Value is read into this variable.
+         * @return Returns true, if the read has been successful.
+         */
+        template <typename T>
+        inline bool read(T &val);
+
+        /**
+         * Read a memory block.
+         * @param size Size of the block in bytes is returned here.
+         * @return Returns pointer to the block data, which is valid
+         *   for the lifetime of this reader, or nullptr, if the
+         *   read failed.
+         */
+        inline const void *readBlock(u64 &size);
+
+        /**
+         * Read memory block into given List, List is resized
+         * to fit the data.
+         * @param list The List.
+         * @return Returns true, if the read has been successful.
+         */
+        template <typename T, typename A>
+        inline bool readList(List<T, A> &list);
+    private:
+        /**
+         * Take given number of bytes from the file.
+         * @param size Number of bytes.
+         * @return Returns pointer to the bytes, or nullptr
+         *   if there is not enough data.
+         */
+        inline const u8 *take(u64 size);
+
+        /// Map or read the file.
+        inline bool open(const std::string &path);
+
+        /// Beginning of the file data.
+        const u8 *mData;
+        /// Size of the file in bytes.
+        u64 mSize;
+        /// Current position within the file.
+        u64 mOffset;
+        /// Position of the first value after the header.
+        u64 mBegin;
+        /// Have all reads been successful so far?
+        bool mGood;
+        /// Is the file memory mapped?
+        bool mMapped;
+        /// Should the data only be validated?
+        bool mValidating;
+        /// File content, when memory mapping is not available.
+        std::vector<u8> mBuffer;
+    protected:
+    }; // class SnapshotReader
+} // namespace ent
+
+#include "Snapshot.inl"
+
+#endif //ECS_FIT_SNAPSHOT_H
@@ -0,0 +1,215 @@
+/**
+ * @file Entropy/Snapshot.inl
+ * @author Tomas Polasek
+ * @brief Binary snapshot files, used for saving and loading the Universe.
+ */
+
+#include "Snapshot.h"
+
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+/// Main Entropy namespace
+namespace ent
+{
+    // SnapshotWriter implementation.
+    SnapshotWriter::SnapshotWriter(const std::string &path) :
+        mFile(path, std::ios::binary | std::ios::trunc), mOffset{0u}, mGood{mFile.good()}
+    {
+        write(SnapshotHeader{SnapshotHeader::MAGIC, SnapshotHeader::VERSION, ENT_SNAPSHOT_ALIGNMENT});
+    }
+
+    template <typename T>
+    void SnapshotWriter::write(const T &val)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable values can be written to the snapshot!");
+        writeRaw(&val, sizeof(T));
+    }
+
+    void SnapshotWriter::beginBlock(u64 size)
+    {
+        write(size);
+
+        static constexpr u8 padding[ENT_SNAPSHOT_ALIGNMENT]{};
+        const u64 misalignment{mOffset % ENT_SNAPSHOT_ALIGNMENT};
+        if (misalignment)
+        {
+            writeRaw(padding, ENT_SNAPSHOT_ALIGNMENT - misalignment);
+        }
+    }
+
+    bool SnapshotWriter::flush()
+    {
+        mFile.flush();
+        mGood = mGood && mFile.good();
+        return mGood;
+    }
+
+    bool SnapshotWriter::finish()
+    {
+        mFile.close();
+        mGood = mGood && !mFile.fail();
+        return mGood;
+    }
+
+    void SnapshotWriter::writeRaw(const void *data, u64 size)
+    {
+        if (!mGood || !size)
+        {
+            return;
+        }
+
+        mFile.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        mOffset += size;
+        mGood = mFile.good();
+    }
+    // SnapshotWriter implementation end.
+
+    // SnapshotReader implementation.
+    SnapshotReader::SnapshotReader(const std::string &path) :
+        mData{nullptr}, mSize{0u}, mOffset{0u}, mBegin{0u}, mGood{false}, mMapped{false},
+        mValidating{false}
+    {
+        mGood = open(path);
+
+        SnapshotHeader header{};
+        mGood = read(header) &&
+                header.magic == SnapshotHeader::MAGIC &&
+                header.version == SnapshotHeader::VERSION &&
+                header.alignment == ENT_SNAPSHOT_ALIGNMENT;
+        mBegin = mOffset;
+    }
+
+    SnapshotReader::~SnapshotReader()
+    {
+#ifndef _WIN32
+        if (mMapped)
+        {
+            munmap(const_cast<u8*>(mData), mSize);
+        }
+#endif
+    }
+
+    void SnapshotReader::rewind(bool validating)
+    {
+        mOffset = mBegin;
+        mValidating = validating;
+    }
+
+    template <typename T>
+    bool SnapshotReader::read(T &val)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable values can be read from the snapshot!");
+        const u8 *data{take(sizeof(T))};
+        if (data)
+        {
+            std::memcpy(&val, data, sizeof(T));
+        }
+        return data != nullptr;
+    }
+
+    const void *SnapshotReader::readBlock(u64 &size)
+    {
+        size = 0u;
+        if (!read(size))
+        {
+            return nullptr;
+        }
+
+        const u64 misalignment{mOffset % ENT_SNAPSHOT_ALIGNMENT};
+        if (misalignment && !take(ENT_SNAPSHOT_ALIGNMENT - misalignment))
+        {
+            return nullptr;
+        }
+
+        const u8 *data{take(size)};
+        // Empty blocks are valid as well.
+        return data ? data : (mGood ? mData + mOffset : nullptr);
+    }
+
+    template <typename T, typename A>
+    bool SnapshotReader::readList(List<T, A> &list)
+    {
+        u64 size{0u};
+        const void *data{readBlock(size)};
+        if (!data || size % sizeof(T))
+        {
+            mGood = false;
+            return false;
+        }
+
+        list.clear();
+        list.resize(size / sizeof(T));
+        if (size)
+        { // Lists hold only bitwise copyable types, e.g. InfoBitset.
+            std::memcpy(static_cast<void*>(list.data()), data, size);
+        }
+
+        return true;
+    }
+
+    const u8 *SnapshotReader::take(u64 size)
+    {
+        if (!mGood || !size || mSize - mOffset < size)
+        {
+            mGood = mGood && !size;
+            return nullptr;
+        }
+
+        const u8 *result{mData + mOffset};
+        mOffset += size;
+        return result;
+    }
+
+    bool SnapshotReader::open(const std::string &path)
+    {
+#ifndef _WIN32
+        const int fd{::open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *mapping{mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                               PROT_READ, MAP_PRIVATE, fd, 0)};
+            if (mapping != MAP_FAILED)
+            {
+                mData = static_cast<const u8*>(mapping);
+                mSize = static_cast<u64>(info.st_size);
+                mMapped = true;
+            }
+        }
+        close(fd);
+
+        if (mMapped)
+        {
+            return true;
+        }
+#endif
+
+        // Fall back to reading the whole file.
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            return false;
+        }
+
+        mBuffer.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(mBuffer.data()), static_cast<std::streamsize>(mBuffer.size()));
+
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+        return !file.fail();
+    }
+    // SnapshotReader implementation end.
+} // namespace ent
@@ -21,7 +21,7 @@ namespace ent
      */
     template <typename T,
               typename Compare = std::less<T>,
-              typename Allocator = std::allocator<T>>
+              typename Allocator = ResourceAllocator<T>>
     class SortedList
     {
     public:
@@ -82,7 +82,7 @@ namespace ent
          */
         template <typename SearchT,
                   typename... CArgTs>
-        inline iterator insertUnique(const SearchT &search, CArgTs... cArgs);
+        inline iterator insertUnique(const SearchT &search, CArgTs &&...cArgs);
         /**
          * Insert element into the sorted list, if the element is already
          * present, it will be overwritten.
@@ -95,7 +95,7 @@ namespace ent
          */
         template <typename SearchT,
                   typename... CArgTs>
-        inline iterator replaceUnique(const SearchT &search, CArgTs... cArgs);
+        inline iterator replaceUnique(const SearchT &search, CArgTs &&...cArgs);
 
         /**
          * Find element in the List.
@@ -47,7 +47,7 @@ namespace ent
 
     template <typename T, typename C, typename A>
     SortedList<T, C, A>::SortedList(ListT &&other, C cmp) :
-        mCmp{cmp}, mList(std::forward(other))
+        mCmp{cmp}, mList(std::move(other))
     {
         sort();
     }
@@ -73,6 +73,8 @@ namespace ent
         if (findIt == end())
         { // Not found.
             mList.pushBack(val);
+            // Push may have reallocated the memory.
+            findIt = end() - 1u;
         }
         else // TODO - <- Is this really worth it?
         {
@@ -87,6 +89,8 @@ namespace ent
         if (findIt == end())
         { // Not found.
             mList.pushBack(val);
+            // Push may have reallocated the memory.
+            findIt = end() - 1u;
         }
         else if (mCmp(val, *findIt)) // TODO - <- Is this really worth it?
         {
@@ -99,12 +103,14 @@ namespace ent
     template <typename T, typename C, typename A>
     template <typename SearchT,
               typename... CArgTs>
-    auto SortedList<T, C, A>::insertUnique(const SearchT &search, CArgTs... cArgs) -> iterator
+    auto SortedList<T, C, A>::insertUnique(const SearchT &search, CArgTs &&...cArgs) -> iterator
     {
         iterator findIt{std::lower_bound(begin(), end(), search, mCmp)};
         if (findIt == end())
         { // Not found.
             mList.emplaceBack(std::forward<CArgTs>(cArgs)...);
+            // Push may have reallocated the memory.
+            findIt = end() - 1u;
         }
         else if (mCmp(search, *findIt)) // TODO - <- Is this really worth it?
         {
@@ -117,12 +123,14 @@ namespace ent
     template <typename T, typename C, typename A>
     template <typename SearchT,
               typename... CArgTs>
-    auto SortedList<T, C, A>::replaceUnique(const SearchT &search, CArgTs... cArgs) -> iterator
+    auto SortedList<T, C, A>::replaceUnique(const SearchT &search, CArgTs &&...cArgs) -> iterator
     {
         iterator findIt{std::lower_bound(begin(), end(), search, mCmp)};
         if (findIt == end())
         { // Not found.
             mList.emplaceBack(std::forward<CArgTs>(cArgs)...);
+            // Push may have reallocated the memory.
+            findIt = end() - 1u;
         }
         else if (mCmp(search, *findIt)) // TODO - <- Is this really worth it?
         {
@@ -167,7 +175,7 @@ namespace ent
     void SortedList<T, C, A>::swap(SortedList &other)
     {
         std::swap(mCmp, other.mCmp);
-        std::swap(mList, other.mList);
+        mList.swap(other.mList);
     }
 
     template <typename T, typename C, typename A>
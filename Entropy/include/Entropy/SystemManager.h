@@ -10,10 +10,75 @@
 #include "Types.h"
 #include "Util.h"
 #include "GroupManager.h"
+#include "ActionsCache.h"
+#include "ThreadPool.h"
 
 /// Main Entropy namespace
 namespace ent
 {
+    /**
+     * Helper structure for specifying Component types, which
+     * are only read by a System.
+     * Used by the System scheduler in Universe::runSystems.
+     * @tparam ReadComponentTs List of read Component types.
+     */
+    template<typename... ReadComponentTs>
+    struct Reads {
+    };
+
+    /**
+     * Helper structure for specifying Component types, which
+     * are written (and possibly read) by a System.
+     * Used by the System scheduler in Universe::runSystems.
+     * @tparam WriteComponentTs List of written Component types.
+     */
+    template<typename... WriteComponentTs>
+    struct Writes {
+    };
+
+    /**
+     * Extract Reads and Writes type lists from given System type.
+     * Default value (if either list is not present) is empty type list.
+     * @tparam SystemT Type of the System.
+     */
+    template<typename SystemT>
+    struct ReadsWritesExtractor {
+        struct ReadsGetter {
+            template<typename ST>
+            static typename ST::Reads getReads(void *unused);
+
+            template<typename ST>
+            static void getReads(...);
+
+            using ReadsT = decltype(getReads<SystemT>(nullptr));
+        };
+
+        struct WritesGetter {
+            template<typename ST>
+            static typename ST::Writes getWrites(void *unused);
+
+            template<typename ST>
+            static void getWrites(...);
+
+            using WritesT = decltype(getWrites<SystemT>(nullptr));
+        };
+
+        /// Has the System declared at least one of the lists?
+        static constexpr bool declared{
+            !std::is_void<typename ReadsGetter::ReadsT>::value ||
+            !std::is_void<typename WritesGetter::WritesT>::value};
+
+        using ReadsT = std::conditional_t<
+            std::is_void<typename ReadsGetter::ReadsT>::value,
+            Reads<>, typename ReadsGetter::ReadsT>;
+        using WritesT = std::conditional_t<
+            std::is_void<typename WritesGetter::WritesT>::value,
+            Writes<>, typename WritesGetter::WritesT>;
+    }; // struct ReadsWritesExtractor
+
+    template <typename UniverseT>
+    class System;
+
     /**
      * SystemManager is a part of Entropy ECS Universe.
      * Its main purpose is to manage Systems within a one Universe.
@@ -87,20 +152,107 @@ namespace ent
          */
         template <typename SystemT>
         bool removeSystem();
+
+        /**
+         * Run all Systems, by calling their run method. Systems
+         * which do not access the same Components (declared by
+         * Reads and Writes lists) are executed in parallel,
+         * using the thread pool of the Universe.
+         * Conflicting Systems are executed in the order they
+         * were added. Systems without Reads and Writes lists
+         * are not run in parallel with any other System.
+         * ChangeSets of the worker threads are committed before
+         * returning. When the deterministic merge is enabled,
+         * actions of each System are applied in the order the
+         * Systems were added, after actions recorded by the calling
+         * thread with the same key.
+         * @param uni Universe ptr.
+         */
+        void runSystems(UniverseT *uni);
     private:
+        /// Information about added System, used for scheduling.
+        struct SystemRecord
+        {
+            /// The System.
+            System<UniverseT> *system;
+            /// Sorted IDs of Components read by the System.
+            std::vector<CIdType> reads;
+            /// Sorted IDs of Components written by the System.
+            std::vector<CIdType> writes;
+            /// Can the System run in parallel with other Systems?
+            bool exclusive;
+        }; // struct SystemRecord
+
+        /**
+         * Collect Component IDs using template type list.
+         * process() returns false, if any of the types is
+         * not registered.
+         * @tparam ContainerT Container for the Component types.
+         */
+        template <typename ContainerT>
+        struct AccessBuilder;
+
+        /**
+         * Remember the System for scheduling.
+         * @tparam SystemT Type of the System.
+         * @param cm Used for resolving Component IDs.
+         */
+        template <typename SystemT>
+        void recordSystem(const ComponentManager<UniverseT> &cm);
+
         /**
-         * Container for the System.
+         * Forget System, which is being removed.
+         * @param sys The System.
+         */
+        void forgetSystem(System<UniverseT> *sys);
+
+        /**
+         * Can given Systems run at the same time?
+         * @param first The first System.
+         * @param second The second System.
+         * @return Returns true, if the Systems access the
+         *   same Component and at least one of them writes it.
+         */
+        static bool conflicting(const SystemRecord &first, const SystemRecord &second);
+
+        /**
+         * Build the dependency graph of added Systems and
+         * split them into waves. Systems within a single wave
+         * do not conflict with each other.
+         */
+        void buildSchedule();
+
+        /// Generator of indices for System types.
+        class SystemIdGenerator : public StaticClassIdGenerator<SystemIdGenerator>
+        { };
+
+        /**
+         * Get index of given System type, shared by all
+         * managers of the same Universe type.
+         * @tparam SystemT Type of the System.
+         * @return Returns the index.
+         */
+        template <typename SystemT>
+        static u64 systemIndex()
+        { return SystemIdGenerator::template getId<SystemT>(); }
+
+        /**
+         * Get System of given type.
          * @tparam SystemT Type of the System.
+         * @return Returns ptr to the System, or nullptr, if
+         *   it has not been added.
          */
         template <typename SystemT>
-		static ConstructionHandler<SystemT> &system()
-		{
-			static ConstructionHandler<SystemT> sys;
-			return sys;
-		}
-
-        /// List of things to destruct, when system reset occurs.
-        std::vector<std::function<void()>> mDestructOnReset;
+        inline SystemT *system() const;
+
+        /// Instances of the added Systems, indexed by systemIndex.
+        std::vector<std::unique_ptr<System<UniverseT>>> mInstances;
+        /// Added Systems, in order of addition.
+        std::vector<SystemRecord> mSystems;
+        /// Waves of Systems, which can run in parallel.
+        std::vector<std::vector<System<UniverseT>*>> mSchedule;
+        /// Has the list of Systems changed since building the schedule?
+        bool mScheduleDirty;
     protected:
     }; // SystemManager
 
@@ -123,6 +275,15 @@ namespace ent
         /// Check, if the System is ready for use.
         bool isInitialized() const;
 
+        /**
+         * Called by Universe::runSystems, does nothing by default.
+         * May be called from a worker thread, at the same time
+         * as run of other Systems, which do not conflict with
+         * this System.
+         */
+        virtual void run()
+        { }
+
         /**
          * Iterator for iterating trough Entities within the group.
          * @return Returns iterator for iterating through Entities withing the group.
@@ -137,6 +298,69 @@ namespace ent
          */
         EntityListParallel<UniverseT, EntityGroup::EntityListT, false> foreachP(u64 numThreads);
 
+        /**
+         * Iterator for iterating trough contiguous chunks of Entities
+         * within the group. Entities in each chunk have consecutive
+         * indices, Components can be accessed using Universe::chunkComponents.
+         * @return Returns iterator for iterating through the chunks.
+         */
+        EntityChunkList chunks();
+
+        /**
+         * Call given function for each Entity within the group,
+         * using the thread pool of the Universe. The Entities are
+         * split into ranges of at most grainSize Entities, idle
+         * threads steal the ranges from busy ones.
+         * ChangeSets of the worker threads are committed before
+         * returning, ChangeSet of the calling thread is not.
+         * When the deterministic merge is enabled, deferred actions
+         * of each range are committed with their own key, so they
+         * are applied in the order of the Entities, after actions
+         * recorded by the calling thread with the same key.
+         * @code
+         * parallelForeach([&] (EntityT &e) {
+         *     e.get<Position>()->x += 1.0f;
+         * }, 256u);
+         * @endcode
+         * @tparam FunT Type of the function, called as fun(EntityT&).
+         * @param fun The function, should not throw.
+         * @param grainSize Maximal number of Entities processed
+         *   as a single task.
+         * @remarks Same rules as for other parallel iteration apply,
+         *   only thread-safe operations should be used.
+         */
+        template <typename FunT>
+        void parallelForeach(FunT fun, u64 grainSize = ENT_DEFAULT_GRAIN_SIZE);
+
+        /**
+         * Call given function for each Entity within the group,
+         * using the thread pool of the Universe. Each task gets a
+         * PartitionWriter for its range of Entities, which allows
+         * direct modification of existing Components, without
+         * deferring the changes through ChangeSets.
+         * ChangeSets of the worker threads are committed before
+         * returning, ChangeSet of the calling thread is not.
+         * When the deterministic merge is enabled, deferred actions
+         * of each range are committed with their own key, so they
+         * are applied in the order of the Entities, after actions
+         * recorded by the calling thread with the same key.
+         * @code
+         * partitionedForeach([&] (EntityT &e, PartitionWriter<UniverseT> &w) {
+         *     w.write<Position>(e.id())->x += 1.0f;
+         * }, 256u);
+         * @endcode
+         * @tparam FunT Type of the function, called as
+         *   fun(EntityT&, PartitionWriter<UniverseT>&).
+         * @param fun The function, should not throw.
+         * @param grainSize Maximal number of Entities processed
+         *   as a single task.
+         * @remarks Only Components of the Entity passed to the
+         *   function should be written, ownership is checked in
+         *   debug builds.
+         */
+        template <typename FunT>
+        void partitionedForeach(FunT fun, u64 grainSize = ENT_DEFAULT_GRAIN_SIZE);
+
         /**
          * Iterator for iterating trough Entities which were added since the last refresh.
          * @return Returns iterator for iterating through Entities which were added since the last refresh.
@@ -188,6 +412,15 @@ namespace ent
          */
         void setUniverse(UniverseT *uni);
 
+        /**
+         * Get order key for a range of Entities processed by
+         * the parallel iteration.
+         * @param base Base key of the parallel region.
+         * @param begin Index of the first Entity in the range.
+         * @return Returns the order key.
+         */
+        static u64 chunkKey(u64 base, u64 begin);
+
         /// Flag used for signifying, that this System is ready for use.
         bool mInitialized;
         /// Entity group containing Entities, which are of interest to this System.
@@ -11,7 +11,8 @@ namespace ent
 {
     // SystemManager implementation.
     template <typename UT>
-    SystemManager<UT>::SystemManager()
+    SystemManager<UT>::SystemManager() :
+        mScheduleDirty{true}
     { }
 
     template <typename UT>
@@ -21,11 +22,10 @@ namespace ent
     template <typename UT>
     void SystemManager<UT>::reset()
     {
-        for (auto &h : mDestructOnReset)
-        {
-            h();
-        }
-        mDestructOnReset.clear();
+        mSystems.clear();
+        mInstances.clear();
+        mSchedule.clear();
+        mScheduleDirty = true;
     }
 
     template <typename UT>
@@ -45,7 +45,13 @@ namespace ent
         }
 
         // Construct the System.
-        system<SystemT>().construct(std::forward<CArgTs>(cArgs)...);
+        SystemT *sys{new SystemT(std::forward<CArgTs>(cArgs)...)};
+        const u64 index{systemIndex<SystemT>()};
+        if (index >= mInstances.size())
+        {
+            mInstances.resize(index + 1u);
+        }
+        mInstances[index].reset(sys);
 
         // Get the Require and Reject lists.
         using Extract = RequireRejectExtractor<SystemT>;
@@ -55,30 +61,29 @@ namespace ent
          * Part of creating a Group is the creation of the
          * Component filter.
          */
-        system<SystemT>()().setGroup(
+        sys->setGroup(
             gm.template addGroup<
                 typename Extract::RequireT,
                 typename Extract::RejectT
             >(cm, em));
 
-        mDestructOnReset.emplace_back(system<SystemT>().destructLater());
-
-        system<SystemT>()().setUniverse(uni);
-        return system<SystemT>().ptr();
+        sys->setUniverse(uni);
+        recordSystem<SystemT>(cm);
+        return sys;
     }
 
     template <typename UT>
     template <typename SystemT>
     bool SystemManager<UT>::hasSystem() const
     {
-        return system<SystemT>().constructed();
+        return system<SystemT>() != nullptr;
     }
 
     template <typename UT>
     template <typename SystemT>
     SystemT *SystemManager<UT>::getSystem() const
     {
-        return system<SystemT>().ptr();
+        return system<SystemT>();
     }
 
     template <typename UT>
@@ -87,7 +92,8 @@ namespace ent
     {
         if (hasSystem<SystemT>())
         {
-            system<SystemT>().destruct();
+            forgetSystem(system<SystemT>());
+            mInstances[systemIndex<SystemT>()].reset();
 
             return true;
         }
@@ -96,6 +102,192 @@ namespace ent
         return false;
     }
 
+    template <typename UT>
+    void SystemManager<UT>::runSystems(UT *uni)
+    {
+        if (mScheduleDirty)
+        {
+            buildSchedule();
+        }
+
+        ThreadPool &pool(uni->threadPool());
+        ActionsCache<UT> &ac(uni->mAC);
+        const bool keyed{ac.deterministic()};
+        const u64 base{keyed ? ac.parallelKeyBase() : 0u};
+        ENT_ASSERT_SLOW(mSystems.size() < (1ull << (ActionsCache<UT>::KEY_REGION_SHIFT -
+                                                  ActionsCache<UT>::KEY_TASK_SHIFT)));
+
+        // Ordinal of the first System in the current wave.
+        u64 first{0u};
+        for (auto &wave : mSchedule)
+        {
+            pool.parallelFor(0u, wave.size(), 1u, [&] (u64 begin, u64 end) {
+                for (u64 index = begin; index < end; ++index)
+                {
+                    if (keyed)
+                    { // Actions of each System are applied in the order of the schedule.
+                        ac.runKeyed(base | ((first + index + 1u) << ActionsCache<UT>::KEY_TASK_SHIFT),
+                                    [&] () { wave[index]->run(); });
+                    }
+                    else
+                    {
+                        wave[index]->run();
+                    }
+                }
+            });
+            first += wave.size();
+        }
+
+        // Deferred actions from the worker threads.
+        pool.broadcast([uni] () {
+            uni->commitChangeSet();
+        });
+    }
+
+    template <typename UT>
+    template <template<typename...> typename ContainerT,
+                                    typename FirstT,
+                                    typename... RestTs>
+    struct SystemManager<UT>::AccessBuilder<ContainerT<FirstT, RestTs...>>
+    {
+        static bool process(const ComponentManager<UT> &cm, std::vector<CIdType> &ids)
+        {
+            bool result{true};
+
+            if (cm.template registered<FirstT>())
+            {
+                ids.push_back(cm.template id<FirstT>());
+            }
+            else
+            {
+                ENT_WARNING("Access to unregistered Component type, System will run exclusively!");
+                result = false;
+            }
+
+            return AccessBuilder<ContainerT<RestTs...>>::process(cm, ids) && result;
+        }
+    };
+
+    template <typename UT>
+    template <template<typename...> typename ContainerT>
+    struct SystemManager<UT>::AccessBuilder<ContainerT<>>
+    {
+        static bool process(const ComponentManager<UT> &cm, std::vector<CIdType> &ids)
+        {
+            ENT_UNUSED(cm);
+            ENT_UNUSED(ids);
+            return true;
+        }
+    };
+
+    template <typename UT>
+    template <typename SystemT>
+    void SystemManager<UT>::recordSystem(const ComponentManager<UT> &cm)
+    {
+        using Extract = ReadsWritesExtractor<SystemT>;
+
+        SystemRecord record;
+        record.system = system<SystemT>();
+        const bool readsKnown{AccessBuilder<typename Extract::ReadsT>::process(cm, record.reads)};
+        const bool writesKnown{AccessBuilder<typename Extract::WritesT>::process(cm, record.writes)};
+        // Unknown Component types conflict with everything.
+        record.exclusive = !Extract::declared || !readsKnown || !writesKnown;
+
+        for (auto *ids : {&record.reads, &record.writes})
+        {
+            std::sort(ids->begin(), ids->end());
+            ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+        }
+
+        mSystems.emplace_back(std::move(record));
+        mScheduleDirty = true;
+    }
+
+    template <typename UT>
+    template <typename SystemT>
+    SystemT *SystemManager<UT>::system() const
+    {
+        const u64 index{systemIndex<SystemT>()};
+        return index < mInstances.size() ?
+               static_cast<SystemT*>(mInstances[index].get()) : nullptr;
+    }
+
+    template <typename UT>
+    void SystemManager<UT>::forgetSystem(System<UT> *sys)
+    {
+        mSystems.erase(std::remove_if(mSystems.begin(), mSystems.end(),
+            [sys] (const SystemRecord &record) {
+                return record.system == sys;
+            }), mSystems.end());
+        mScheduleDirty = true;
+    }
+
+    template <typename UT>
+    bool SystemManager<UT>::conflicting(const SystemRecord &first, const SystemRecord &second)
+    {
+        if (first.exclusive || second.exclusive)
+        {
+            return true;
+        }
+
+        auto intersects = [] (const std::vector<CIdType> &a, const std::vector<CIdType> &b) {
+            auto aIt = a.begin();
+            auto bIt = b.begin();
+            while (aIt != a.end() && bIt != b.end())
+            {
+                if (*aIt < *bIt)
+                {
+                    ++aIt;
+                }
+                else if (*bIt < *aIt)
+                {
+                    ++bIt;
+                }
+                else
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        return intersects(first.writes, second.writes) ||
+               intersects(first.writes, second.reads) ||
+               intersects(first.reads, second.writes);
+    }
+
+    template <typename UT>
+    void SystemManager<UT>::buildSchedule()
+    {
+        /*
+         * Each System is placed into the first wave after
+         * all of the earlier Systems it conflicts with.
+         */
+        std::vector<u64> waveOf(mSystems.size(), 0u);
+        mSchedule.clear();
+
+        for (u64 current = 0; current < mSystems.size(); ++current)
+        {
+            u64 wave{0u};
+            for (u64 earlier = 0; earlier < current; ++earlier)
+            {
+                if (waveOf[earlier] >= wave && conflicting(mSystems[earlier], mSystems[current]))
+                {
+                    wave = waveOf[earlier] + 1u;
+                }
+            }
+
+            waveOf[current] = wave;
+            if (wave >= mSchedule.size())
+            {
+                mSchedule.resize(wave + 1u);
+            }
+            mSchedule[wave].push_back(mSystems[current].system);
+        }
+
+        mScheduleDirty = false;
+    }
+
     // SystemManager implementation end.
 
     // System implementation.
@@ -122,6 +314,90 @@ namespace ent
     EntityListParallel<UT, EntityGroup::EntityListT, false> System<UT>::foreachP(u64 numThreads)
     { return mGroup->foreachP(mUniverse, numThreads); }
 
+    template <typename UT>
+    template <typename FunT>
+    void System<UT>::parallelForeach(FunT fun, u64 grainSize)
+    {
+        auto list{mGroup->foreach(mUniverse)};
+        ThreadPool &pool(mUniverse->threadPool());
+
+        ActionsCache<UT> &ac(mUniverse->mAC);
+        const bool keyed{ac.deterministic()};
+        const u64 base{keyed ? ac.parallelKeyBase() : 0u};
+
+        pool.parallelFor(0u, list.size(), grainSize, [&] (u64 begin, u64 end) {
+            auto chunk = [&] () {
+                auto it{list.begin() + begin};
+                for (u64 index = begin; index < end; ++index, ++it)
+                {
+                    fun(*it);
+                }
+            };
+
+            if (keyed)
+            {
+                ac.runKeyed(chunkKey(base, begin), chunk);
+            }
+            else
+            {
+                chunk();
+            }
+        });
+
+        // Deferred actions from the worker threads.
+        pool.broadcast([this] () {
+            mUniverse->commitChangeSet();
+        });
+    }
+
+    template <typename UT>
+    template <typename FunT>
+    void System<UT>::partitionedForeach(FunT fun, u64 grainSize)
+    {
+        auto list{mGroup->foreach(mUniverse)};
+        ThreadPool &pool(mUniverse->threadPool());
+
+        ActionsCache<UT> &ac(mUniverse->mAC);
+        const bool keyed{ac.deterministic()};
+        const u64 base{keyed ? ac.parallelKeyBase() : 0u};
+
+        pool.parallelFor(0u, list.size(), grainSize, [&] (u64 begin, u64 end) {
+            auto chunk = [&] () {
+                PartitionWriter<UT> writer{mGroup->partition(mUniverse, begin, end)};
+                for (auto &e : writer)
+                {
+                    fun(e, writer);
+                }
+            };
+
+            if (keyed)
+            {
+                ac.runKeyed(chunkKey(base, begin), chunk);
+            }
+            else
+            {
+                chunk();
+            }
+        });
+
+        // Deferred actions from the worker threads.
+        pool.broadcast([this] () {
+            mUniverse->commitChangeSet();
+        });
+    }
+
+    template <typename UT>
+    u64 System<UT>::chunkKey(u64 base, u64 begin)
+    {
+        ENT_ASSERT_SLOW(begin + 1u < (1ull << ActionsCache<UT>::KEY_TASK_SHIFT));
+        ENT_ASSERT_SLOW((base & ((1ull << ActionsCache<UT>::KEY_TASK_SHIFT) - 1u)) == 0u);
+        return base | (begin + 1u);
+    }
+
+    template <typename UT>
+    EntityChunkList System<UT>::chunks()
+    { return mGroup->chunks(); }
+
     template <typename UT>
     EntityList<UT, EntityGroup::AddedListT> System<UT>::foreachAdded()
     { return mGroup->foreachAdded(mUniverse); }
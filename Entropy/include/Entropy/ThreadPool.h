@@ -0,0 +1,171 @@
+/**
+ * @file Entropy/ThreadPool.h
+ * @author Tomas Polasek
+ * @brief Work-stealing thread pool used for parallel iteration.
+ */
+
+#ifndef ECS_FIT_THREADPOOL_H
+#define ECS_FIT_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+#include "Util.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    /**
+     * Persistent pool of worker threads. Each worker has its own
+     * queue of tasks, idle workers steal tasks from the other
+     * queues. Ranges given to parallelFor are split recursively,
+     * so the work is balanced even when the cost per element
+     * differs.
+     * Thread which is waiting for work to finish helps with
+     * executing the tasks.
+     */
+    class ThreadPool final : NonCopyable
+    {
+    public:
+        /// Create the pool without any worker threads.
+        inline ThreadPool();
+
+        /// Stop and join all worker threads.
+        inline ~ThreadPool();
+
+        /**
+         * Start given number of worker threads. If the pool
+         * is already running, it is stopped first.
+         * @param numWorkers Number of worker threads, the
+         *   calling thread is not included.
+         */
+        inline void start(u64 numWorkers);
+
+        /**
+         * Stop and join all worker threads.
+         * Tasks which are still queued are not executed.
+         */
+        inline void stop();
+
+        /// Are there any worker threads running?
+        bool running() const
+        { return !mThreads.empty(); }
+
+        /// Number of worker threads.
+        u64 numWorkers() const
+        { return mThreads.size(); }
+
+        /**
+         * Call given function for sub-ranges of [begin, end).
+         * Sub-ranges are at most grainSize elements long,
+         * and are processed in parallel. Returns after the
+         * whole range has been processed.
+         * @code
+         * pool.parallelFor(0u, size, 64u, [&] (u64 b, u64 e) {
+         *     for (u64 iii = b; iii < e; ++iii) { ... }
+         * });
+         * @endcode
+         * @tparam FunT Type of the function, called as fun(u64, u64).
+         * @param begin First element of the range.
+         * @param end Element behind the last element of the range.
+         * @param grainSize Maximal size of the sub-ranges.
+         * @param fun The function, should not throw.
+         * @remarks Is thread-safe.
+         */
+        template <typename FunT>
+        void parallelFor(u64 begin, u64 end, u64 grainSize, FunT &&fun);
+
+        /**
+         * Execute given function once on each worker thread.
+         * Returns after all workers finished.
+         * @tparam FunT Type of the function, called as fun().
+         * @param fun The function, should not throw.
+         * @remarks Is thread-safe.
+         */
+        template <typename FunT>
+        void broadcast(FunT &&fun);
+    private:
+        /// Task queue of a single thread.
+        struct TaskQueue
+        {
+            /// Lock for the queue.
+            std::mutex mutex;
+            /// Tasks which can be stolen by other threads.
+            std::deque<std::function<void()>> tasks;
+            /// Tasks which have to be executed by the owning thread.
+            std::deque<std::function<void()>> pinned;
+            /// Number of queued pinned tasks.
+            std::atomic<u64> numPinned{0u};
+        }; // struct TaskQueue
+
+        /// Information about the current thread.
+        struct ThreadInfo
+        {
+            /// Pool the thread is working for.
+            const ThreadPool *pool;
+            /// Queue owned by the thread.
+            u64 queue;
+        }; // struct ThreadInfo
+
+        /// Get information about the current thread.
+        static ThreadInfo &threadInfo()
+        {
+            static thread_local ThreadInfo info{nullptr, 0u};
+            return info;
+        }
+
+        /**
+         * Get queue of the current thread. Threads which are not
+         * part of this pool use the shared external queue.
+         * @return Returns index of the queue.
+         */
+        inline u64 queueId() const;
+
+        /**
+         * Add task to the given queue.
+         * @param queue Index of the queue.
+         * @param task The task.
+         * @param pinned Can the task be executed only by
+         *   owner of the queue?
+         */
+        inline void push(u64 queue, std::function<void()> &&task, bool pinned = false);
+
+        /**
+         * Execute a single task. Tasks from the given queue are
+         * preferred, if there are none, task is stolen from
+         * another queue.
+         * @param queue Queue of the current thread.
+         * @return Returns true, if any task has been executed.
+         */
+        inline bool runOne(u64 queue);
+
+        /**
+         * Main loop of the worker threads.
+         * @param queue Queue owned by the worker.
+         */
+        inline void workerLoop(u64 queue);
+
+        /// Queue for each worker + external queue at the end.
+        std::vector<std::unique_ptr<TaskQueue>> mQueues;
+        /// Worker threads.
+        std::vector<std::thread> mThreads;
+        /// Number of queued tasks, which can be stolen.
+        std::atomic<u64> mPending;
+        /// Are the workers supposed to run?
+        std::atomic<bool> mRunning;
+        /// Lock used for sleeping workers.
+        std::mutex mSleepMutex;
+        /// Used for waking up sleeping workers.
+        std::condition_variable mWakeup;
+    protected:
+    }; // class ThreadPool
+} // namespace ent
+
+#include "ThreadPool.inl"
+
+#endif //ECS_FIT_THREADPOOL_H
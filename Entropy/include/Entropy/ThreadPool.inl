@@ -0,0 +1,248 @@
+/**
+ * @file Entropy/ThreadPool.inl
+ * @author Tomas Polasek
+ * @brief Work-stealing thread pool used for parallel iteration.
+ */
+
+#include "ThreadPool.h"
+
+/// Main Entropy namespace
+namespace ent
+{
+    // ThreadPool implementation.
+    ThreadPool::ThreadPool() :
+        mPending{0u}, mRunning{false}
+    {
+        // External queue.
+        mQueues.emplace_back(new TaskQueue);
+    }
+
+    ThreadPool::~ThreadPool()
+    { stop(); }
+
+    void ThreadPool::start(u64 numWorkers)
+    {
+        stop();
+
+        mQueues.clear();
+        for (u64 queue = 0; queue <= numWorkers; ++queue)
+        {
+            mQueues.emplace_back(new TaskQueue);
+        }
+
+        mRunning = true;
+        for (u64 queue = 0; queue < numWorkers; ++queue)
+        {
+            mThreads.emplace_back(&ThreadPool::workerLoop, this, queue);
+        }
+    }
+
+    void ThreadPool::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lg(mSleepMutex);
+            mRunning = false;
+        }
+        mWakeup.notify_all();
+
+        for (std::thread &thread : mThreads)
+        {
+            thread.join();
+        }
+        mThreads.clear();
+
+        for (auto &queue : mQueues)
+        {
+            queue->tasks.clear();
+            queue->pinned.clear();
+            queue->numPinned = 0u;
+        }
+        mPending = 0u;
+    }
+
+    template <typename FunT>
+    void ThreadPool::parallelFor(u64 begin, u64 end, u64 grainSize, FunT &&fun)
+    {
+        if (begin >= end)
+        { // Nothing to do.
+            return;
+        }
+
+        grainSize = grainSize ? grainSize : 1u;
+        if (!running() || end - begin <= grainSize)
+        { // No need to split the range.
+            fun(begin, end);
+            return;
+        }
+
+        // Number of elements, which have not been processed yet.
+        std::atomic<u64> remaining{end - begin};
+
+        std::function<void(u64, u64)> process;
+        process = [&] (u64 b, u64 e) {
+            const u64 queue{queueId()};
+            // Leave the second half for other threads to steal.
+            while (e - b > grainSize)
+            {
+                const u64 mid{b + (e - b) / 2u};
+                push(queue, [&process, mid, e] () { process(mid, e); });
+                e = mid;
+            }
+
+            fun(b, e);
+            remaining.fetch_sub(e - b, std::memory_order_acq_rel);
+        };
+
+        process(begin, end);
+
+        // Help with the rest of the work.
+        while (remaining.load(std::memory_order_acquire) != 0u)
+        {
+            if (!runOne(queueId()))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    template <typename FunT>
+    void ThreadPool::broadcast(FunT &&fun)
+    {
+        const u64 workers{numWorkers()};
+        std::atomic<u64> finished{0u};
+
+        for (u64 queue = 0; queue < workers; ++queue)
+        {
+            push(queue, [&fun, &finished] () {
+                fun();
+                finished.fetch_add(1u, std::memory_order_acq_rel);
+            }, true);
+        }
+
+        while (finished.load(std::memory_order_acquire) != workers)
+        {
+            if (!runOne(queueId()))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    u64 ThreadPool::queueId() const
+    {
+        const ThreadInfo &info(threadInfo());
+        return info.pool == this ? info.queue : mQueues.size() - 1u;
+    }
+
+    void ThreadPool::push(u64 queue, std::function<void()> &&task, bool pinned)
+    {
+        TaskQueue &q(*mQueues[queue]);
+
+        {
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (pinned)
+            {
+                q.pinned.emplace_back(std::move(task));
+            }
+            else
+            {
+                q.tasks.emplace_back(std::move(task));
+            }
+        }
+
+        {
+            // Prevents lost wake-ups, between predicate test and sleep.
+            std::lock_guard<std::mutex> lg(mSleepMutex);
+            if (pinned)
+            {
+                q.numPinned.fetch_add(1u, std::memory_order_release);
+            }
+            else
+            {
+                mPending.fetch_add(1u, std::memory_order_release);
+            }
+        }
+        if (pinned)
+        {
+            mWakeup.notify_all();
+        }
+        else
+        {
+            mWakeup.notify_one();
+        }
+    }
+
+    bool ThreadPool::runOne(u64 queue)
+    {
+        std::function<void()> task;
+        bool pinned{false};
+
+        { // Own queue, newest tasks first.
+            TaskQueue &q(*mQueues[queue]);
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.pinned.empty())
+            {
+                task = std::move(q.pinned.front());
+                q.pinned.pop_front();
+                pinned = true;
+            }
+            else if (!q.tasks.empty())
+            {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+        }
+
+        // Steal the oldest, probably largest, task from other queues.
+        for (u64 offset = 1u; !task && offset < mQueues.size(); ++offset)
+        {
+            TaskQueue &q(*mQueues[(queue + offset) % mQueues.size()]);
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.tasks.empty())
+            {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+        }
+
+        if (!task)
+        {
+            return false;
+        }
+
+        if (pinned)
+        {
+            mQueues[queue]->numPinned.fetch_sub(1u, std::memory_order_acq_rel);
+        }
+        else
+        {
+            mPending.fetch_sub(1u, std::memory_order_acq_rel);
+        }
+        task();
+
+        return true;
+    }
+
+    void ThreadPool::workerLoop(u64 queue)
+    {
+        threadInfo() = ThreadInfo{this, queue};
+        const TaskQueue &q(*mQueues[queue]);
+
+        while (mRunning)
+        {
+            if (!runOne(queue))
+            {
+                // Tasks pinned to other workers do not wake this one up.
+                std::unique_lock<std::mutex> lock(mSleepMutex);
+                mWakeup.wait(lock, [this, &q] () {
+                    return !mRunning ||
+                           mPending.load(std::memory_order_acquire) != 0u ||
+                           q.numPinned.load(std::memory_order_acquire) != 0u;
+                });
+            }
+        }
+
+        threadInfo() = ThreadInfo{nullptr, 0u};
+    }
+    // ThreadPool implementation end.
+} // namespace ent
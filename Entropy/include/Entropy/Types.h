@@ -101,6 +101,52 @@ namespace ent
     static constexpr std::size_t ENT_BITSET_GROUP_SIZE{64u};
     /// How much capacity should EntityHolder keep.
     static constexpr std::size_t ENT_PUSH_NUM{256u};
+    /**
+     * How many unused runtime EntityGroups are kept
+     * cached, before the least recently used ones are
+     * removed.
+     */
+    static constexpr std::size_t ENT_GROUP_CACHE_SIZE{16u};
+    /// Default number of Entities processed as a single parallel task.
+    static constexpr std::size_t ENT_DEFAULT_GRAIN_SIZE{256u};
+    /**
+     * Minimal number of deferred Component actions, before
+     * they are applied in parallel on refresh.
+     */
+    static constexpr std::size_t ENT_PARALLEL_APPLY_THRESHOLD{1024u};
+    /**
+     * Minimal number of changed Entities, before the per-thread
+     * change lists are merged in parallel on refresh.
+     */
+    static constexpr std::size_t ENT_PARALLEL_MERGE_THRESHOLD{4096u};
+    /**
+     * How many applied ChangeSets are kept for reuse. The pool
+     * is a lock-free stack, shared by all committing threads.
+     */
+    static constexpr std::size_t ENT_CHANGESET_POOL_SIZE{64u};
+    /**
+     * Alignment of memory blocks within snapshot files, in bytes,
+     * relative to the beginning of the file.
+     */
+    static constexpr std::size_t ENT_SNAPSHOT_ALIGNMENT{64u};
+    /// Number of Entities in a single page of ComponentView.
+    static constexpr std::size_t ENT_VIEW_PAGE_SIZE{256u};
+    /**
+     * Number of versions kept by each ComponentView. New version
+     * can be published only when there is a version, which is
+     * neither current, nor used by any reader.
+     */
+    static constexpr std::size_t ENT_VIEW_VERSIONS{3u};
+    /// Default size of memory blocks allocated by ArenaMemoryResource.
+    static constexpr std::size_t ENT_ARENA_BLOCK_SIZE{64u * 1024u};
+    /// Largest allocation served from PoolMemoryResource size classes.
+    static constexpr std::size_t ENT_POOL_MAX_SIZE{4096u};
+    /// Size of memory chunks, which are split into pool blocks.
+    static constexpr std::size_t ENT_POOL_CHUNK_SIZE{64u * 1024u};
+    /// Size of a huge page used by HugePageMemoryResource.
+    static constexpr std::size_t ENT_HUGE_PAGE_SIZE{2u * 1024u * 1024u};
+    /// Number of refreshes kept in the Universe refresh metrics.
+    static constexpr std::size_t ENT_REFRESH_METRICS_FRAMES{256u};
 } // namespace ent
 
 #endif //ECS_FIT_TYPES_H
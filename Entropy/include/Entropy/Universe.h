@@ -12,6 +12,8 @@
 #include "GroupManager.h"
 #include "SystemManager.h"
 #include "ActionsCache.h"
+#include "ThreadPool.h"
+#include "ComponentView.h"
 
 /// Main Entropy namespace
 namespace ent
@@ -31,8 +33,12 @@ namespace ent
         using EntityT = Entity<UniverseT>;
         using TempEntityT = TemporaryEntity<UniverseT>;
         using SystemT = System<UniverseT>;
+        using PartitionWriterT = PartitionWriter<UniverseT>;
 
         friend class Entity<UniverseT>;
+        friend class ActionsCache<UniverseT>;
+        friend class SystemManager<UniverseT>;
+        friend class System<UniverseT>;
 
 #ifdef ENT_STATS_ENABLED
         static constexpr bool LOG_STATS{true};
@@ -41,15 +47,39 @@ namespace ent
 #endif
 
         /**
-         * Default constructor for Universe.
+         * Create Universe, which uses given memory resource for all
+         * of its internal containers, including Component holders,
+         * Entity metadata, EntityGroups and ChangeSets.
+         * @code
+         * class MyUniverse : public ent::Universe<MyUniverse>
+         * {
+         * public:
+         *     MyUniverse(ent::MemoryResource *memory) :
+         *         Universe(memory) { }
+         * };
+         * ent::HugePageMemoryResource hugePages;
+         * ent::TrackingMemoryResource tracking(&hugePages);
+         * MyUniverse u(&tracking);
+         * @endcode
+         * @param memory The resource, which has to outlive the
+         *   Universe. When nullptr is used, the current resource
+         *   is used instead, see MemoryResource::current().
          */
-        Universe();
+        Universe(MemoryResource *memory = nullptr);
 
         /**
          * Universe destructs itself and all inner managers.
          */
         ~Universe();
 
+        /// Resource used by the internal containers.
+        MemoryResource *memoryResource() const
+        { return mMemory; }
+
+        /// Arena used for lists living until the next refresh.
+        const FrameArena &frameArena() const
+        { return mFrameArena; }
+
         /**
          * Initialize all required structures AFTER adding all the
          * required Components.
@@ -94,6 +124,24 @@ namespace ent
         const UniverseStats &statistics() const
         { return mStats; }
 #endif
+
+        /**
+         * Report memory used by the Entity metadata, Component
+         * holders, Groups, ChangeSets and lists of changed
+         * Entities. Available in all builds.
+         * @return Returns the report.
+         * @remarks Not thread-safe, should not be called while
+         *   other threads are changing the Universe.
+         */
+        inline MemoryReport memoryReport() const;
+
+        /**
+         * Get timings and counters of the last refreshes.
+         * Metrics are recorded in all builds.
+         */
+        const RefreshMetrics &refreshMetrics() const
+        { return mMetrics; }
+
         /**
          * Register given System for this universe.
          * Operation is finished on refresh.
@@ -126,6 +174,28 @@ namespace ent
         template <typename ASystemT>
         bool removeSystem();
 
+        /**
+         * Run all added Systems, by calling their run method.
+         * Systems declare the accessed Components using
+         * Reads and Writes type lists:
+         * @code
+         * class MoveS : public Universe::SystemT
+         * {
+         * public:
+         *     using Require = ent::Require<Position, Velocity>;
+         *     using Reads = ent::Reads<Velocity>;
+         *     using Writes = ent::Writes<Position>;
+         *     virtual void run() override { ... }
+         * };
+         * @endcode
+         * Systems which do not conflict are executed in parallel
+         * on the thread pool, conflicting Systems are executed
+         * in the order they were added. Systems without the
+         * lists are never executed in parallel with other Systems.
+         * @remarks Not thread-safe!
+         */
+        inline void runSystems();
+
         /**
          * Add or get already created Entity group.
          * Operation is finished on refresh.
@@ -178,6 +248,54 @@ namespace ent
             typename RejectT>
         bool abandonGroup();
 
+        /**
+         * Build filter for runtime Entity group from lists
+         * of Component IDs.
+         * Order of the IDs does not matter.
+         * If both lists contain the same ID, the require list
+         * has higher priority.
+         * @code
+         * ent::EntityFilter f{u.buildFilter({posId, velId}, {})};
+         * EntityGroup *myGroup = u.addGetGroup(f);
+         * @endcode
+         * @param require List of required Component IDs.
+         * @param reject List of rejected Component IDs.
+         * @return Returns filter, which can be used in
+         *   addGetGroup.
+         */
+        inline EntityFilter buildFilter(const std::vector<CIdType> &require,
+                                        const std::vector<CIdType> &reject) const;
+
+        /**
+         * Add or get already created runtime Entity group.
+         * Runtime Groups are kept in a registry keyed by the
+         * filter, repeated requests with the same filter
+         * return the same Group.
+         * Operation is finished on refresh.
+         * Groups which are no longer in use are kept in cache
+         * and refreshed, until there are more than ENT_GROUP_CACHE_SIZE
+         * of them - in that case the least recently used
+         * Groups are removed.
+         * @param filter Filter specifying the Group.
+         * @return Returns ptr to the requested Entity Group.
+         * @remarks Not thread-safe!
+         * @remarks Each time this method is called the corresponding
+         *   Group usage counter is incremented, after the Group is
+         *   no longer needed "abandonGroup" should be called.
+         * @remarks The pointer is valid only until the Group is
+         *   abandoned and removed from the cache.
+         */
+        inline EntityGroup *addGetGroup(const EntityFilter &filter);
+
+        /**
+         * Decrease the usage counter for given runtime EntityGroup.
+         * @param grp Group returned by the runtime addGetGroup.
+         * @return Returns true, if the group reached zero on
+         *   the usage counter.
+         * @remarks Not thread-safe!
+         */
+        inline bool abandonGroup(EntityGroup *grp);
+
         /**
          * Register given Component and its ComponentHolder.
          * @tparam ComponentT Type of the Component.
@@ -240,7 +358,7 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addComponent(EntityId id, CArgTs... cArgs);
+        inline ComponentT *addComponent(EntityId id, CArgTs &&...cArgs);
 
         /**
          * Add or replace a Component for given Entity.
@@ -263,6 +381,22 @@ namespace ent
         template <typename ComponentT>
         inline ComponentT *replaceComponent(EntityId id, const ComponentT &comp);
 
+        /**
+         * Add or replace a Component for given Entity.
+         * Given Component is moved into the holder, instead
+         * of being copied.
+         * @tparam ComponentT Type of the Component
+         * @param id Id of the Entity.
+         * @param comp Component data.
+         * @return Returns pointer to the Component.
+         * @remarks Not thread-safe! If thread-safety is required, use addComponentD.
+         * @remarks Changes Entity metadata!
+         * @remarks All pointers to Components of the same type may be invalidated!
+         */
+        template <typename ComponentT,
+                  typename = typename std::enable_if<!std::is_reference<ComponentT>::value>::type>
+        inline ComponentT *replaceComponent(EntityId id, ComponentT &&comp);
+
         /**
          * Add Component to the given Entity.
          * Deferred version, temporary Component is
@@ -294,10 +428,10 @@ namespace ent
          */
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addComponentD(EntityId id, CArgTs... cArgs);
+        inline ComponentT *addComponentD(EntityId id, CArgTs &&...cArgs);
         template <typename ComponentT,
                   typename... CArgTs>
-        inline ComponentT *addComponentT(EntityId id, CArgTs... cArgs);
+        inline ComponentT *addComponentT(EntityId id, CArgTs &&...cArgs);
 
         /**
          * Get Component associated with the given Entity.
@@ -335,6 +469,36 @@ namespace ent
         template <typename ComponentT>
         inline const ComponentT *getComponent(EntityId id) const;
 
+        /**
+         * Get Components for all Entities within given chunk.
+         * Only Components stored in index-addressed holders
+         * (e.g. ComponentHolderList) can be accessed this way.
+         * @code
+         * for (const ent::EntityChunk &chunk : group->chunks())
+         * {
+         *     Position *pos{u.chunkComponents<Position>(chunk)};
+         *     for (u64 iii = 0; iii < chunk.size(); ++iii)
+         *     {
+         *         pos[iii].x += 1.0f;
+         *     }
+         * }
+         * @endcode
+         * @tparam ComponentT Type of the Component.
+         * @param chunk Chunk of Entities, all of them have to
+         *   have the Component.
+         * @return Returns pointer to Component of the first Entity
+         *   in the chunk, Components for the rest of the chunk
+         *   follow. Returns nullptr, if the holder is not index-addressed.
+         * @remarks Is thread-safe with other reads of the same
+         *   Component type and with writes into other chunks. Must
+         *   not run concurrently with adding Components of the same
+         *   type, which may reallocate the holder.
+         * @remarks Pointer is valid only until a Component of the
+         *   same type is added.
+         */
+        template <typename ComponentT>
+        inline ComponentT *chunkComponents(const EntityChunk &chunk);
+
         /**
          * Get temporary Component, which can be safely
          * used for write access. The operation will be
@@ -569,7 +733,10 @@ namespace ent
 
         /**
          * Destroy given Entity.
-         * Action is performed immediately.
+         * Action is performed immediately, Components of
+         * the Entity are removed from their holders on the
+         * next refresh, or before its index is used by
+         * a new Entity.
          * @param id ID of the Entity.
          * @return Returns false, if the Entity could not
          *   be destroyed.
@@ -611,9 +778,183 @@ namespace ent
         /**
          * Commit actions stored in the ChangeSet of the
          * current thread.
-         * @remarks Is thread-safe, using a mutex.
+         * @remarks Is thread-safe and lock-free.
          */
         inline void commitChangeSet();
+
+        /**
+         * Set order key of the ChangeSet of the current thread.
+         * Used by the deterministic merge, ChangeSets are then
+         * applied in the order of their keys - e.g. index of
+         * the job - instead of the order of commits. The key
+         * is reset to 0, when the ChangeSet is committed.
+         * @param key The order key, should be unique within
+         *   a single refresh.
+         * @remarks Is thread-safe.
+         */
+        inline void setChangeSetKey(u64 key);
+
+        /**
+         * Enable or disable the deterministic merge of
+         * ChangeSets. When enabled, ChangeSets are applied
+         * in the order of their keys, ChangeSets with the same
+         * key are applied in the order of commits. Writes to
+         * the same Component are then resolved by the merge
+         * policy of the Component (see ent::MergeLastWriter,
+         * ent::MergeFirstWriter and ent::MergeCombine).
+         * Disabled by default.
+         * @param enabled Should the merge be deterministic?
+         * @remarks Not thread-safe!
+         */
+        inline void setDeterministicMerge(bool enabled);
+
+        /**
+         * Save the current state of this Universe into a binary
+         * snapshot file. Snapshot contains the Entity metadata,
+         * members of the active EntityGroups and Components of
+         * all registered types. Only trivially copyable Components
+         * are supported, their storage is written as raw blocks.
+         * Changes, which have not been applied by refresh, are
+         * not saved.
+         * @param path Path to the file, existing file is overwritten.
+         * @return Returns true, if the snapshot has been saved.
+         * @remarks Not thread-safe!
+         */
+        inline bool saveSnapshot(const std::string &path) const;
+
+        /**
+         * Replace the state of this Universe with state loaded
+         * from a binary snapshot file. The file is memory mapped,
+         * where supported. The same Component types, in the same
+         * order, have to be registered as in the saved Universe.
+         * EntityGroups, which were active in the saved Universe,
+         * get their members directly, other EntityGroups are
+         * populated from the loaded Entities.
+         * @param path Path to the file.
+         * @return Returns true, if the snapshot has been loaded. The
+         *   whole snapshot is validated before any state is replaced,
+         *   so a damaged file, or a snapshot of a different Universe,
+         *   leaves this Universe unchanged.
+         * @remarks Should be called after refresh. Not thread-safe!
+         */
+        inline bool loadSnapshot(const std::string &path);
+
+        /**
+         * Replace the state of this Universe with a copy of the
+         * state of another Universe of the same type, used for
+         * rollback and speculative simulation. Both Universes
+         * have to have the same Component types registered,
+         * in the same order. Entity metadata and List based
+         * holders are copied as whole blocks of memory, reusing
+         * memory already allocated by this Universe, so cloning
+         * into the same Universe repeatedly does not allocate.
+         * EntityGroups, which are active in both Universes, get
+         * their members directly, other EntityGroups are populated
+         * from the copied Entities. Systems and changes, which
+         * have not been applied by refresh, are not copied.
+         * @code
+         * RealUniverse speculative;
+         * // Register the same Components, init...
+         * speculative.cloneFrom(universe);
+         * // Simulate a few frames...
+         * speculative.cloneFrom(universe); // Rollback.
+         * @endcode
+         * @param source Universe, whose state should be copied.
+         * @return Returns true, if the state has been copied. On
+         *   failure, the Universe should be reset.
+         * @remarks Both Universes should be refreshed. Source
+         *   should not be modified during the copy. Not thread-safe!
+         */
+        inline bool cloneFrom(const Universe &source);
+
+        /**
+         * Start recording changes of this Universe into an
+         * append-only delta file. Each refresh appends one frame,
+         * containing the Entities changed by the refresh: their
+         * generation, flags and all of their Components. Recording
+         * is usually started right after saving a full snapshot,
+         * deltas are then replayed on top of the loaded snapshot.
+         * Only trivially copyable Components are supported.
+         * @param path Path to the file, existing file is overwritten.
+         * @return Returns true, if the file has been created.
+         * @remarks Should be called after refresh. Not thread-safe!
+         */
+        inline bool startDeltaRecording(const std::string &path);
+
+        /**
+         * Stop recording deltas and close the delta file.
+         * @return Returns true, if all of the frames have
+         *   been written successfully.
+         * @remarks Not thread-safe!
+         */
+        inline bool stopDeltaRecording();
+
+        /// Are changes being recorded into a delta file?
+        bool recordingDeltas() const
+        { return mDeltaWriter != nullptr; }
+
+        /**
+         * Mark Entity as written, so its Components are
+         * recorded in the next delta frame. Components written
+         * through addComponent, replaceComponent, ChangeSets
+         * and PartitionWriter are marked automatically, other
+         * in-place writes have to be marked using this method.
+         * Does nothing, when deltas are not being recorded
+         * and there are no ComponentViews.
+         * @param id ID of the Entity.
+         * @remarks Thread-safe with other calls to markWritten.
+         */
+        inline void markWritten(EntityId id);
+
+        /**
+         * Replay frames from given delta file. Each frame
+         * is applied and followed by a refresh. Replay stops
+         * at the first incomplete or malformed frame, which
+         * may be applied partially.
+         * @param path Path to the delta file.
+         * @return Returns number of replayed frames.
+         * @remarks The same Component types, in the same order,
+         *   have to be registered. Should be called after refresh.
+         *   Not thread-safe!
+         */
+        inline u64 replayDeltas(const std::string &path);
+
+        /**
+         * Get read-only view of Components of given type. View
+         * is created on the first call and a new version is
+         * published at the end of each refresh, which changes
+         * any of the viewed Components. Versions can be read
+         * from other threads, without blocking the refresh.
+         * Changed Components are detected using the same change
+         * tracking as the delta recording, in-place writes have
+         * to be marked using markWritten.
+         * @tparam ComponentT Type of the Component, has to
+         *   be trivially copyable.
+         * @return Returns the view, which is valid until
+         *   this Universe is reset or destroyed.
+         * @remarks Not thread-safe, returned view is thread-safe.
+         */
+        template <typename ComponentT>
+        inline ComponentView<ComponentT> &componentView();
+
+        /**
+         * Get the thread pool owned by this Universe. If the
+         * pool is not running yet, it is started with one worker
+         * less than the number of hardware threads - the calling
+         * thread also helps with the work.
+         * @return Returns reference to the thread pool.
+         * @remarks Not thread-safe, when called for the first time!
+         */
+        inline ThreadPool &threadPool();
+
+        /**
+         * Set the number of worker threads used by the
+         * thread pool of this Universe.
+         * @param numWorkers Number of worker threads, 0 means
+         *   all of the work will be done by the calling thread.
+         * @remarks Not thread-safe!
+         */
+        inline void setNumWorkers(u64 numWorkers);
     private:
         /**
          * Reset parts of this Universe.
@@ -629,8 +970,117 @@ namespace ent
          */
         void entityChanged(EntityId id);
 
+        /**
+         * Called, when an Entity has been destroyed and it
+         * should be removed from its groups.
+         * @param id ID of the Entity, before it has been destroyed.
+         * @remarks Not thread-safe!
+         */
+        void entityDestroyed(EntityId id);
+
+        /**
+         * Remove Components and Group memberships of Entities
+         * destroyed since the last refresh, so their indexes
+         * can be used by new Entities.
+         * @remarks Not thread-safe!
+         */
+        inline void removeDestroyed();
+
+        /**
+         * Add or replace Component, without marking the
+         * Entity as changed. Used when applying ChangeSets,
+         * may be called in parallel for different Component types.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity.
+         * @param comp Component, which is moved into the holder.
+         * @return Returns true, if the Component has not
+         *   been present before.
+         */
+        template <typename ComponentT>
+        inline bool replaceComponentImpl(EntityId id, ComponentT &&comp);
+
+        /**
+         * Remove Component, without marking the Entity
+         * as changed. Used when applying ChangeSets,
+         * may be called in parallel for different Component types.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity.
+         * @return Returns true, if the Component has been removed.
+         */
+        template <typename ComponentT>
+        inline bool removeComponentImpl(EntityId id);
+
+        /**
+         * Get Component, only if the Entity metadata say
+         * it is present. Used when applying ChangeSets,
+         * may be called in parallel for different Component types.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity.
+         * @return Returns ptr to the Component, or nullptr
+         *   if it is not present.
+         */
+        template <typename ComponentT>
+        inline ComponentT *presentComponentImpl(EntityId id);
+
+        /// Delta flag of existing Entities.
+        static constexpr u8 DELTA_CREATED{1u << 0};
+        /// Delta flag of active Entities.
+        static constexpr u8 DELTA_ACTIVE{1u << 1};
+
+        /**
+         * Append one delta frame to the delta file, if
+         * deltas are being recorded.
+         * @tparam FunT Type of the iteration function, called
+         *   as forEach(fun), where fun is called with index of
+         *   each changed Entity.
+         * @param forEach The iteration function.
+         */
+        template <typename FunT>
+        inline void recordDelta(FunT forEach);
+
+        /**
+         * Apply one delta frame, without refreshing.
+         * @param reader Reader of the delta file.
+         * @return Returns true, if the frame has been applied.
+         */
+        inline bool applyDelta(SnapshotReader &reader);
+
+        /// Are written Components tracked, for deltas or views?
+        bool trackingWrites() const
+        { return recordingDeltas() || !mViews.empty(); }
+
+        /**
+         * Update ComponentViews with the changed Entities
+         * and publish new versions.
+         * @tparam FunT Type of the iteration function, called
+         *   as forEach(fun), where fun is called with index of
+         *   each changed Entity.
+         * @param forEach The iteration function.
+         */
+        template <typename FunT>
+        inline void publishViews(FunT forEach);
+
+        /**
+         * Get Component for ComponentView.
+         * @tparam ComponentT Type of the Component.
+         * @param id ID of the Entity.
+         * @return Returns ptr to the Component.
+         */
+        template <typename ComponentT>
+        const void *viewComponent(EntityId id) const
+        { return mCM.template get<ComponentT>(id); }
+
+        /// Resource used by the internal containers.
+        MemoryResource *mMemory;
+        /// Active while the members are being constructed.
+        MemoryScope mConstructionScope;
+        /// Transient lists created during the refresh.
+        FrameArena mFrameArena;
+
         /// Statistics for this Universe.
         UniverseStats mStats;
+        /// Timings and counters of the last refreshes.
+        RefreshMetrics mMetrics;
 
         /// Used for managing Entities and metadata.
         EntityManager mEM;
@@ -643,12 +1093,38 @@ namespace ent
         /// Actions cache for storing actions to be performed at a later time.
         ActionsCache<UniverseT> mAC;
 
-        /// List of changed Entities since the last refresh.
+        /// Was the number of worker threads chosen?
+        bool mPoolInitialized;
+        /// Thread pool used for parallel iteration.
+        ThreadPool mPool;
+
+        /// Changed Entities since the last refresh.
 #ifdef ENT_THREADED_CHANGES
-        static thread_local ChangedEntitiesHolder<UniverseT> tChanges;
+        ChangedEntitiesHolder<UniverseT> mChanges;
 #else
-        SortedList<EntityId> mChanged;
+        ChangedEntities mChanged;
+        /// Used by markWritten, which may be called from multiple threads.
+        std::mutex mWrittenMutex;
 #endif
+
+        /// Writer of the delta file, if deltas are being recorded.
+        std::unique_ptr<SnapshotWriter> mDeltaWriter;
+
+        /// Information about a single ComponentView.
+        struct ViewRecord
+        {
+            /// ID of the viewed Component type.
+            CIdType cId;
+            /// Get the viewed Component of given Entity.
+            const void *(UniverseT::*get)(EntityId) const;
+            /// Should all of the Entities be copied into the view?
+            bool rebuild;
+            /// The view.
+            std::unique_ptr<BaseComponentView> view;
+        }; // struct ViewRecord
+
+        /// Views of Components, published on refresh.
+        std::vector<ViewRecord> mViews;
     protected:
     }; // Universe
 } // namespace ent
@@ -10,22 +10,18 @@
 namespace ent
 {
     // Universe implementation.
-#ifdef ENT_THREADED_CHANGES
     template <typename T>
-    thread_local ChangedEntitiesHolder<Universe<T>> Universe<T>::tChanges;
-#endif
-
-    template <typename T>
-    Universe<T>::Universe() :
-        mEM(), mCM(), mGM(), mSM(), mAC()
-    { }
+    Universe<T>::Universe(MemoryResource *memory) :
+        mMemory{memory ? memory : MemoryResource::current()}, mConstructionScope(mMemory),
+        mFrameArena(mMemory), mEM(), mCM(), mGM(), mSM(), mAC(), mPoolInitialized{false}
+    {
+        // Only the members are created in the construction scope.
+        mConstructionScope.release();
+    }
 
     template <typename T>
     Universe<T>::~Universe()
     {
-#ifdef ENT_THREADED_CHANGES
-        tChanges.reset();
-#endif
 #ifdef ENT_STATS_ENABLED
         mStats.reset();
 #endif
@@ -34,6 +30,8 @@ namespace ent
     template <typename T>
     void Universe<T>::init()
     {
+        MemoryScope scope(mMemory);
+
         if (LOG_STATS)
         {
             mStats.univInits++;
@@ -49,6 +47,12 @@ namespace ent
     template <typename T>
     void Universe<T>::refresh()
     {
+        // Containers created during the refresh belong to this Universe.
+        MemoryScope scope(mMemory);
+        FrameMetrics &metrics(mMetrics.beginFrame());
+        // Transient lists of the previous frame are still in use.
+        mFrameArena.nextFrame();
+
         /*
          * 1) Refresh EntityManager.
          * 2) Refresh ActionCache:
@@ -64,21 +68,48 @@ namespace ent
          *   c) Check change Entities, add/remove
          *     from Groups, change Entity metadata.
          *   d) Finalize Groups.
+         * 5) Forget the destroyed Entities.
          */
 
         mEM.refresh();
+        mMetrics.endPhase(FrameMetrics::PHASE_ENTITIES);
 
-        mAC.applyChangeSets(this);
+        metrics.changeSetsApplied = mAC.applyChangeSets(this);
+        mMetrics.endPhase(FrameMetrics::PHASE_CHANGE_SETS);
 
         mCM.refresh();
+        mMetrics.endPhase(FrameMetrics::PHASE_COMPONENTS);
 
 #ifdef ENT_THREADED_CHANGES
-        mGM.refresh(tChanges.createResultList(), mEM);
+        const ent::SortedList<EntityId> &changed(mChanges.createResultList(mPool, mFrameArena.resource()));
+        metrics.changedEntities = changed.size();
+        mMetrics.endPhase(FrameMetrics::PHASE_CHANGED);
+        mGM.refresh(changed, mEM, mFrameArena.resource(), mMetrics);
 
-        tChanges.refresh();
+        auto forEachChanged = [&] (auto fun) {
+            for (EntityId id : changed)
+            {
+                fun(id.index());
+            }
+        };
 #else
-        mGM.refresh(mChanged, mEM);
+        metrics.changedEntities = mChanged.size();
+        mMetrics.endPhase(FrameMetrics::PHASE_CHANGED);
+        mGM.refresh(mChanged, mEM, mFrameArena.resource(), mMetrics);
+
+        auto forEachChanged = [&] (auto fun) {
+            mChanged.forEach(fun);
+        };
+#endif
+
+        // Holders and Groups no longer contain the destroyed Entities.
+        mEM.clearDestroyed();
 
+        recordDelta(forEachChanged);
+        publishViews(forEachChanged);
+        mMetrics.endPhase(FrameMetrics::PHASE_PUBLISH);
+
+#ifndef ENT_THREADED_CHANGES
         mChanged.clear();
 #endif
     }
@@ -86,17 +117,51 @@ namespace ent
     template <typename T>
     void Universe<T>::reset()
     {
+        MemoryScope scope(mMemory);
+
+        stopDeltaRecording();
+        mViews.clear();
         mAC.reset();
         mSM.reset();
         mGM.reset();
         mEM.reset();
         mCM.reset();
 #ifdef ENT_THREADED_CHANGES
-        tChanges.refresh();
+        mChanges.reset();
 #endif
+        mMetrics.clear();
         resetSelf();
     }
 
+    template <typename T>
+    MemoryReport Universe<T>::memoryReport() const
+    {
+        MemoryReport result;
+
+        mEM.memoryUsage(result);
+
+        for (CIdType cId = 0u; cId < mCM.numRegistered(); ++cId)
+        {
+            ComponentMemoryUsage comp;
+            comp.id = cId;
+            comp.count = mEM.numComponents(cId);
+            comp.holder = mCM.memoryUsage(cId, comp.count);
+            result.components.push_back(comp);
+        }
+
+        mGM.memoryUsage(result);
+
+        mAC.memoryUsage(result);
+#ifndef ENT_THREADED_CHANGES
+        result.changedLists += mChanged.memoryUsage();
+#endif
+
+        // Changed Entities of the threads and Group changes are in the arena.
+        result.frameArena = MemoryUsage{mFrameArena.reserved(), mFrameArena.used(), mFrameArena.used()};
+
+        return result;
+    }
+
     template <typename T>
     void Universe<T>::printStatus(std::ostream &out)
     {
@@ -136,6 +201,7 @@ namespace ent
         static_assert(std::is_constructible<ASystemT, CArgTs...>::value,
                       "Unable to construct System with given constructor parameters!");
 
+        MemoryScope scope(mMemory);
         ASystemT *system{mSM.template addSystem<ASystemT>(this, mCM, mEM, mGM, std::forward<CArgTs>(args)...)};
 
         if (LOG_STATS)
@@ -173,11 +239,19 @@ namespace ent
         return removed;
     }
 
+    template <typename T>
+    void Universe<T>::runSystems()
+    {
+        mSM.runSystems(this);
+    }
+
     template <typename T>
     template <typename RequireT,
         typename RejectT>
     EntityGroup *Universe<T>::addGetGroup()
     {
+        MemoryScope scope(mMemory);
+
         if (!mGM.template hasGroup<RequireT, RejectT>())
         {
             mGM.template addGroup<RequireT, RejectT>(mCM, mEM);
@@ -209,6 +283,49 @@ namespace ent
         return result;
     }
 
+    template <typename T>
+    EntityFilter Universe<T>::buildFilter(const std::vector<CIdType> &require,
+                                          const std::vector<CIdType> &reject) const
+    {
+        return mGM.buildFilter(require, reject);
+    }
+
+    template <typename T>
+    EntityGroup *Universe<T>::addGetGroup(const EntityFilter &filter)
+    {
+        MemoryScope scope(mMemory);
+        EntityGroup *result{mGM.addGroup(filter, mEM)};
+
+        if (LOG_STATS && result->usage() == 1u)
+        {
+            mStats.grpActive++;
+            mStats.grpAdded++;
+            ENT_CHECK_STATS(mStats);
+        }
+
+        return result;
+    }
+
+    template <typename T>
+    bool Universe<T>::abandonGroup(EntityGroup *grp)
+    {
+        if (!grp->inUse())
+        { // Already abandoned.
+            return false;
+        }
+
+        bool result{grp->abandon() == 0u};
+
+        if (LOG_STATS && result)
+        {
+            mStats.grpActive--;
+            mStats.grpRemoved++;
+            ENT_CHECK_STATS(mStats);
+        }
+
+        return result;
+    }
+
     template <typename T>
     template <typename ComponentT,
         typename... CArgTs>
@@ -221,6 +338,7 @@ namespace ent
             return mCM.template id<ComponentT>();
         }
 
+        MemoryScope scope(mMemory);
         u64 cId{mCM.template registerComponent<ComponentT>(std::forward<CArgTs>(args)...)};
 
         if (LOG_STATS)
@@ -259,6 +377,10 @@ namespace ent
                 entityChanged(id);
                 mEM.addComponent(id, mCM.template id<ComponentT>());
             }
+            else
+            { // Written Components are part of the recorded delta.
+                markWritten(id);
+            }
         }
 
         return result;
@@ -267,7 +389,7 @@ namespace ent
     template <typename T>
     template <typename ComponentT,
         typename... CArgTs>
-    ComponentT *Universe<T>::addComponent(EntityId id, CArgTs... cArgs)
+    ComponentT *Universe<T>::addComponent(EntityId id, CArgTs &&...cArgs)
     {
 #ifdef ENT_ENTITY_VALID
         if (!mEM.valid(id))
@@ -286,6 +408,10 @@ namespace ent
                 entityChanged(id);
                 mEM.addComponent(id, mCM.template id<ComponentT>());
             }
+            else
+            { // Written Components are part of the recorded delta.
+                markWritten(id);
+            }
         }
 
         return result;
@@ -312,6 +438,41 @@ namespace ent
                 entityChanged(id);
                 mEM.addComponent(id, mCM.template id<ComponentT>());
             }
+            else
+            { // Written Components are part of the recorded delta.
+                markWritten(id);
+            }
+        }
+
+        return result;
+    }
+
+    template <typename T>
+    template <typename ComponentT,
+              typename>
+    ComponentT *Universe<T>::replaceComponent(EntityId id, ComponentT &&comp)
+    {
+#ifdef ENT_ENTITY_VALID
+        if (!mEM.valid(id))
+        {
+            throw std::runtime_error("Unable to add/replace Component to invalid Entity!");
+        }
+#endif
+
+        ComponentT *result{mCM.template replace<ComponentT>(id, std::move(comp))};
+
+        if (result)
+        { // Check, if the add operation returned success.
+            bool alreadyPresent{mEM.hasComponent(id, mCM.template id<ComponentT>())};
+            if (!alreadyPresent)
+            { // Check, if the Component has been added previously.
+                entityChanged(id);
+                mEM.addComponent(id, mCM.template id<ComponentT>());
+            }
+            else
+            { // Written Components are part of the recorded delta.
+                markWritten(id);
+            }
         }
 
         return result;
@@ -336,7 +497,7 @@ namespace ent
     template <typename T>
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *Universe<T>::addComponentD(EntityId id, CArgTs... cArgs)
+    ComponentT *Universe<T>::addComponentD(EntityId id, CArgTs &&...cArgs)
     {
         // TODO - check existence of the Entity?
         return mAC.changeSet().template addComponent<ComponentT>(mCM.template id<ComponentT>(), id, std::forward<CArgTs>(cArgs)...);
@@ -345,7 +506,7 @@ namespace ent
     template <typename T>
     template <typename ComponentT,
               typename... CArgTs>
-    ComponentT *Universe<T>::addComponentT(EntityId id, CArgTs... cArgs)
+    ComponentT *Universe<T>::addComponentT(EntityId id, CArgTs &&...cArgs)
     {
         // TODO - check existence of the Entity?
         return mAC.changeSet().template addComponentT<ComponentT>(mCM.template id<ComponentT>(), id, std::forward<CArgTs>(cArgs)...);
@@ -383,6 +544,14 @@ namespace ent
 #endif
     }
 
+    template <typename T>
+    template <typename ComponentT>
+    ComponentT *Universe<T>::chunkComponents(const EntityChunk &chunk)
+    {
+        ComponentT *data{mCM.template indexedData<ComponentT>()};
+        return data ? data + chunk.firstIndex() : nullptr;
+    }
+
     template <typename T>
     template <typename ComponentT>
     ComponentT *Universe<T>::getComponentD(EntityId id)
@@ -440,12 +609,11 @@ namespace ent
             throw std::runtime_error("Unable to add Component to invalid Entity!");
         }
 #endif
-        bool result{mCM.template remove<ComponentT>(id)};
+        bool result{removeComponentImpl<ComponentT>(id)};
 
         if (result)
         {
             entityChanged(id);
-            mEM.removeComponent(id, mCM.template id<ComponentT>());
         }
 
         return result;
@@ -481,6 +649,11 @@ namespace ent
     template <typename T>
     EntityId Universe<T>::createEntityId()
     {
+        if (mEM.createReusesDestroyed())
+        { // Reused index must not keep anything of the destroyed Entity.
+            removeDestroyed();
+        }
+
         EntityId newId{mEM.create()};
 
 #ifdef ENT_ENTITY_EXCEPT
@@ -581,14 +754,20 @@ namespace ent
     template <typename T>
     bool Universe<T>::destroyEntity(EntityId id)
     {
-        bool result{mEM.destroy(id)};
-
-        if (result)
+        if (!mEM.valid(id))
         {
-            entityChanged(id);
+            return false;
         }
 
-        return result;
+        // Components are removed from the holders on refresh.
+        mEM.removeComponents(id, [&] (CIdType cId) {
+            mCM.entityDestroyed(id, cId);
+        });
+
+        mEM.destroy(id);
+        entityDestroyed(id);
+
+        return true;
     }
 
     template <typename T>
@@ -617,6 +796,210 @@ namespace ent
         mAC.commitChangeSet();
     }
 
+    template <typename T>
+    void Universe<T>::setChangeSetKey(u64 key)
+    {
+        mAC.changeSet().setKey(key);
+    }
+
+    template <typename T>
+    void Universe<T>::setDeterministicMerge(bool enabled)
+    {
+        mAC.setDeterministic(enabled);
+    }
+
+    template <typename T>
+    bool Universe<T>::saveSnapshot(const std::string &path) const
+    {
+        SnapshotWriter writer(path);
+
+        mEM.saveSnapshot(writer);
+        mGM.saveSnapshot(writer);
+        if (!mCM.saveSnapshot(writer))
+        {
+            ENT_WARNING("Snapshots support only trivially copyable Components!");
+            writer.finish();
+            std::remove(path.c_str());
+            return false;
+        }
+
+        return writer.finish();
+    }
+
+    template <typename T>
+    bool Universe<T>::loadSnapshot(const std::string &path)
+    {
+        MemoryScope scope(mMemory);
+        SnapshotReader reader(path);
+        if (!reader.good())
+        {
+            return false;
+        }
+
+        auto load = [&] () {
+            return mEM.loadSnapshot(reader) &&
+                   mGM.loadSnapshot(reader, mEM) &&
+                   mCM.loadSnapshot(reader) &&
+                   reader.finished();
+        };
+
+        // Whole snapshot is validated first, failed load leaves this Universe untouched.
+        reader.rewind(true);
+        if (!load())
+        {
+            return false;
+        }
+
+        reader.rewind(false);
+        if (!load())
+        {
+            return false;
+        }
+
+        // Changes of the previous state are no longer relevant.
+#ifdef ENT_THREADED_CHANGES
+        mChanges.reset();
+#else
+        mChanged.clear();
+#endif
+
+        for (ViewRecord &record : mViews)
+        { // Views are filled on the next refresh.
+            record.rebuild = true;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool Universe<T>::cloneFrom(const Universe &source)
+    {
+        if (&source == this)
+        {
+            return true;
+        }
+
+        MemoryScope scope(mMemory);
+        if (!mEM.copyFrom(source.mEM) ||
+            !mCM.copyFrom(source.mCM))
+        {
+            ENT_WARNING("Only Universes with the same copyable Components can be cloned!");
+            return false;
+        }
+        mGM.copyFrom(source.mGM, mEM);
+
+        // Changes of the previous state are no longer relevant.
+#ifdef ENT_THREADED_CHANGES
+        mChanges.reset();
+#else
+        mChanged.clear();
+#endif
+
+        for (ViewRecord &record : mViews)
+        { // Views are filled on the next refresh.
+            record.rebuild = true;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool Universe<T>::startDeltaRecording(const std::string &path)
+    {
+        stopDeltaRecording();
+
+        mDeltaWriter.reset(new SnapshotWriter(path));
+        if (!mDeltaWriter->flush())
+        {
+            mDeltaWriter.reset();
+            return false;
+        }
+
+        // Frames start from the current state.
+        mEM.resetDelta();
+
+        return true;
+    }
+
+    template <typename T>
+    bool Universe<T>::stopDeltaRecording()
+    {
+        if (!mDeltaWriter)
+        {
+            return false;
+        }
+
+        const bool result{mDeltaWriter->finish()};
+        mDeltaWriter.reset();
+
+        return result;
+    }
+
+    template <typename T>
+    void Universe<T>::markWritten(EntityId id)
+    {
+        if (trackingWrites())
+        {
+#ifndef ENT_THREADED_CHANGES
+            std::lock_guard<std::mutex> g(mWrittenMutex);
+#endif
+            entityChanged(id);
+        }
+    }
+
+    template <typename T>
+    u64 Universe<T>::replayDeltas(const std::string &path)
+    {
+        MemoryScope scope(mMemory);
+        SnapshotReader reader(path);
+
+        u64 numFrames{0u};
+        while (reader.good() && !reader.finished() && applyDelta(reader))
+        {
+            refresh();
+            numFrames++;
+        }
+
+        return numFrames;
+    }
+
+    template <typename T>
+    template <typename ComponentT>
+    ComponentView<ComponentT> &Universe<T>::componentView()
+    {
+        const CIdType cId{mCM.template id<ComponentT>()};
+        for (ViewRecord &record : mViews)
+        {
+            if (record.cId == cId)
+            {
+                return static_cast<ComponentView<ComponentT>&>(*record.view);
+            }
+        }
+
+        mViews.push_back(ViewRecord{cId, &UniverseT::template viewComponent<ComponentT>, true,
+                                    std::unique_ptr<BaseComponentView>(new ComponentView<ComponentT>())});
+        return static_cast<ComponentView<ComponentT>&>(*mViews.back().view);
+    }
+
+    template <typename T>
+    ThreadPool &Universe<T>::threadPool()
+    {
+        if (!mPoolInitialized)
+        {
+            u64 hwThreads{std::thread::hardware_concurrency()};
+            setNumWorkers(hwThreads > 1u ? hwThreads - 1u : 0u);
+        }
+
+        return mPool;
+    }
+
+    template <typename T>
+    void Universe<T>::setNumWorkers(u64 numWorkers)
+    {
+        mPool.start(numWorkers);
+        mPoolInitialized = true;
+    }
+
     template <typename T>
     void Universe<T>::resetSelf()
     {
@@ -631,12 +1014,227 @@ namespace ent
     template <typename T>
     void Universe<T>::entityChanged(EntityId id)
     {
-        // TODO - Performance, sorted insert without moving immediately?
 #ifdef ENT_THREADED_CHANGES
-        tChanges.entityChanged(id);
+        mChanges.entityChanged(id);
 #else
-        mChanged.insertUnique(id);
+        mChanged.entityChanged(id);
 #endif
     }
+
+    template <typename T>
+    void Universe<T>::entityDestroyed(EntityId id)
+    {
+#ifdef ENT_THREADED_CHANGES
+        mChanges.entityChanged(id);
+#else
+        mChanged.entityDestroyed(id);
+#endif
+    }
+
+    template <typename T>
+    void Universe<T>::removeDestroyed()
+    {
+        mCM.removeDestroyed();
+        mGM.removeDestroyed(mEM);
+        mEM.clearDestroyed();
+    }
+
+    template <typename T>
+    template <typename FunT>
+    void Universe<T>::recordDelta(FunT forEach)
+    {
+        if (!mDeltaWriter)
+        {
+            return;
+        }
+
+        SnapshotWriter &writer(*mDeltaWriter);
+        const CIdType numComponents{mCM.numRegistered()};
+
+        mEM.saveDelta(writer);
+
+        u64 numChanged{0u};
+        forEach([&] (EIdType) { numChanged++; });
+        writer.write(numChanged);
+
+        bool result{true};
+        forEach([&] (EIdType index) {
+            const EntityId id(index, mEM.currentGen(index));
+            const bool created{mEM.valid(id)};
+
+            u64 numPresent{0u};
+            for (CIdType cId = 0; created && cId < numComponents; ++cId)
+            {
+                numPresent += mEM.hasComponent(id, cId) ? 1u : 0u;
+            }
+
+            writer.write(id);
+            writer.write<u8>((created ? DELTA_CREATED : 0u) |
+                             (created && mEM.active(id) ? DELTA_ACTIVE : 0u));
+            writer.write(numPresent);
+
+            for (CIdType cId = 0; numPresent && cId < numComponents; ++cId)
+            {
+                if (mEM.hasComponent(id, cId))
+                {
+                    writer.write(cId);
+                    result = mCM.saveComponent(writer, id, cId) && result;
+                }
+            }
+        });
+
+        // Frames should survive a crash of the application.
+        if (!result || !writer.flush())
+        {
+            ENT_WARNING("Unable to record delta, recording has been stopped!");
+            stopDeltaRecording();
+        }
+    }
+
+    template <typename T>
+    template <typename FunT>
+    void Universe<T>::publishViews(FunT forEach)
+    {
+        if (mViews.empty())
+        {
+            return;
+        }
+
+        auto update = [&] (ViewRecord &record, EIdType index) {
+            const EntityId id(index, mEM.currentGen(index));
+            const bool present{mEM.valid(id) && mEM.hasComponent(id, record.cId)};
+            record.view->update(id, present ? (this->*record.get)(id) : nullptr);
+        };
+
+        for (ViewRecord &record : mViews)
+        {
+            if (record.rebuild)
+            { // Copy all of the Entities.
+                record.view->clear();
+                for (EIdType index = 0; index < mEM.endIndex(); ++index)
+                {
+                    update(record, index);
+                }
+                record.rebuild = false;
+            }
+        }
+
+        forEach([&] (EIdType index) {
+            for (ViewRecord &record : mViews)
+            {
+                update(record, index);
+            }
+        });
+
+        for (ViewRecord &record : mViews)
+        {
+            record.view->publish();
+        }
+    }
+
+    template <typename T>
+    bool Universe<T>::applyDelta(SnapshotReader &reader)
+    {
+        const CIdType numComponents{mCM.numRegistered()};
+
+        u64 numChanged{0u};
+        if (!mEM.loadDelta(reader) || !reader.read(numChanged))
+        {
+            return false;
+        }
+
+        std::vector<CIdType> present;
+        for (u64 iii = 0; iii < numChanged; ++iii)
+        {
+            EntityId id;
+            u8 flags{0u};
+            u64 numPresent{0u};
+            EntityId previous;
+            if (!reader.read(id) || !reader.read(flags) || !reader.read(numPresent) ||
+                numPresent > numComponents || (numPresent && !(flags & DELTA_CREATED)) ||
+                !mEM.setState(id, flags & DELTA_CREATED, flags & DELTA_ACTIVE, previous))
+            {
+                return false;
+            }
+
+            present.clear();
+            for (u64 comp = 0; comp < numPresent; ++comp)
+            {
+                CIdType cId{0u};
+                if (!reader.read(cId) || !mCM.loadComponent(reader, id, cId))
+                {
+                    return false;
+                }
+                present.push_back(cId);
+            }
+
+            // Synchronize the Component bits with the loaded Components.
+            mEM.removeComponents(id, [&] (CIdType cId) {
+                if (std::find(present.begin(), present.end(), cId) == present.end())
+                {
+                    mCM.removeComponent(id, cId);
+                }
+            });
+            for (CIdType cId : present)
+            {
+                mEM.addComponent(id, cId);
+            }
+
+            if (previous.index() && (!(flags & DELTA_CREATED) || previous.generation() != id.generation()))
+            { // The previous Entity has been destroyed.
+                entityDestroyed(previous);
+            }
+            if (flags & DELTA_CREATED)
+            {
+                entityChanged(id);
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    template <typename ComponentT>
+    bool Universe<T>::replaceComponentImpl(EntityId id, ComponentT &&comp)
+    {
+        if (!mCM.template replace<ComponentT>(id, std::move(comp)))
+        {
+            return false;
+        }
+
+        const CIdType cId{mCM.template id<ComponentT>()};
+        if (mEM.hasComponent(id, cId))
+        { // Component has been present before.
+            return false;
+        }
+
+        mEM.addComponent(id, cId);
+        return true;
+    }
+
+    template <typename T>
+    template <typename ComponentT>
+    bool Universe<T>::removeComponentImpl(EntityId id)
+    {
+        if (!mCM.template remove<ComponentT>(id))
+        {
+            return false;
+        }
+
+        mEM.removeComponent(id, mCM.template id<ComponentT>());
+        return true;
+    }
+
+    template <typename T>
+    template <typename ComponentT>
+    ComponentT *Universe<T>::presentComponentImpl(EntityId id)
+    {
+        if (!mEM.hasComponent(id, mCM.template id<ComponentT>()))
+        {
+            return nullptr;
+        }
+
+        return mCM.template get<ComponentT>(id);
+    }
     // Universe implementation end.
 } // namespace ent
@@ -7,6 +7,7 @@
 #ifndef ECS_FIT_UTIL_H
 #define ECS_FIT_UTIL_H
 
+#include <atomic>
 #include <limits>
 #include <utility>
 #include <memory>
@@ -184,6 +185,7 @@ namespace ent
         /**
          * Get unique id for given ClassT.
          * IDs begin at 0 and are incremented for each new type.
+         * Is thread-safe.
          * @tparam ClassT Type to generate id for.
          * @return Unique id for given type.
          */
@@ -195,13 +197,13 @@ namespace ent
         }
     private:
         /// Counter for unique IDs.
-        static u64 mCounter;
+        static std::atomic<u64> mCounter;
     protected:
     };
 
     // Start the IDs at 0.
     template <typename T>
-    u64 StaticClassIdGenerator<T>::mCounter = 0;
+    std::atomic<u64> StaticClassIdGenerator<T>::mCounter{0u};
 
 #ifdef NOT_USED
     /**
@@ -695,6 +697,15 @@ namespace ent
         bool testAndSet(std::size_t pos, bool val)
         { return testAndSetImpl(pos, val); }
 
+        /**
+         * Find the first bit set to true, starting at given position.
+         * Whole blocks of zero bits are skipped.
+         * @param pos Position of the first tested bit.
+         * @return Returns position of the bit, or size(), if
+         *   there is no such bit.
+         */
+        inline u64 findNext(u64 pos) const;
+
         /**
          * Copy bits from other bitset.
          * @param other The other bitset.
@@ -249,5 +249,25 @@ namespace ent
 
         return old;
     }
+
+    template <u64 N>
+    u64 InfoBitset<N>::findNext(u64 pos) const
+    {
+        for (u64 block = memBlock(pos); pos < NUM_BITS; ++block)
+        {
+            // Mask out the bits before the starting position.
+            const BMBType masked{getBlock(block) & (BLOCK_ONE << memBit(pos))};
+            if (masked != BLOCK_ZERO)
+            { // Number of trailing zeroes is the position within the block.
+                const u64 found{block * BITS_IN_BLOCK +
+                                static_cast<u64>(popcount64((masked & (~masked + 1u)) - 1u))};
+                return found < NUM_BITS ? found : NUM_BITS;
+            }
+
+            pos = (block + 1u) * BITS_IN_BLOCK;
+        }
+
+        return NUM_BITS;
+    }
     // InfoBitset implementation end.
 } // namespace ent
@@ -8,7 +8,9 @@
 #define TESTING_PROFILER_H
 
 #include <atomic>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 #include "math/Math.h"
 #include "util/Threading.h"
@@ -34,6 +36,10 @@
         prof::ProfilingManager::instance().useCrawler(CRAWLER)
 #   define PROF_THREAD(NAME) \
         prof::ThreadProfiler PROF_NAME(_tp, __LINE__)(NAME)
+#   define PROF_RECORD_START() \
+        prof::ProfilingManager::instance().startRecording()
+#   define PROF_RECORD_STOP() \
+        prof::ProfilingManager::instance().stopRecording()
 #else
 #   define PROF_CONCAT(F, S)
 #   define PROF_NAME(F, S)
@@ -42,6 +48,8 @@
 #   define PROF_SCOPE(_)
 #   define PROF_DUMP(_)
 #   define PROF_THREAD(_)
+#   define PROF_RECORD_START()
+#   define PROF_RECORD_STOP()
 #endif
 
 namespace prof
@@ -360,6 +368,19 @@ namespace prof
 
     using CallNode = util::HashNode<CallData>;
 
+    /**
+     * Single recorded run of a scope.
+     */
+    struct TraceEvent
+    {
+        /// Node of the scope, contains its name.
+        CallNode *node;
+        /// Ticks at the start of the scope.
+        u64 begin;
+        /// Ticks at the end of the scope, 0 for unfinished scopes.
+        u64 end;
+    };
+
     /**
      * Data for each thread name.
      */
@@ -414,6 +435,45 @@ namespace prof
         {
             return mRoot;
         }
+
+        /**
+         * Record the start of given scope.
+         * @param node Node of the scope.
+         * @param ticks Ticks at the start of the scope.
+         */
+        void beginEvent(CallNode *node, u64 ticks)
+        {
+            mOpenEvents.push_back(mEvents.size());
+            mEvents.push_back({node, ticks, 0});
+        }
+
+        /**
+         * Record the end of given scope. Scopes entered
+         * before the start of recording are skipped.
+         * @param node Node of the scope.
+         * @param ticks Ticks at the end of the scope.
+         */
+        void endEvent(CallNode *node, u64 ticks)
+        {
+            if (!mOpenEvents.empty() && mEvents[mOpenEvents.back()].node == node)
+            {
+                mEvents[mOpenEvents.back()].end = ticks;
+                mOpenEvents.pop_back();
+            }
+        }
+
+        /// Remove all recorded events.
+        void clearEvents()
+        {
+            mEvents.clear();
+            mOpenEvents.clear();
+        }
+
+        /// Get the recorded events, in order of their start.
+        const std::vector<TraceEvent> &events()
+        {
+            return mEvents;
+        }
     private:
     protected:
 #ifdef PROFILE_LOCK
@@ -421,6 +481,11 @@ namespace prof
         thr::SpinLock mLock;
 #endif
 
+        /// Events recorded by this thread.
+        std::vector<TraceEvent> mEvents;
+        /// Indices of events, which have not ended yet.
+        std::vector<u64> mOpenEvents;
+
         /// Root node of the call stack.
         CallNode *mRoot;
 
@@ -590,6 +655,40 @@ namespace prof
             return mNumThreadExit;
         }
 
+        /**
+         * Start recording begin and end of each scope,
+         * events recorded before are removed.
+         * Should be called, when no other thread is
+         * inside a profiled scope.
+         */
+        void startRecording();
+
+        /**
+         * Stop recording of scopes, recorded events
+         * are kept until the next startRecording.
+         */
+        void stopRecording();
+
+        /// Are the scopes being recorded?
+        bool recording()
+        {
+            return mRecording.load(std::memory_order_relaxed);
+        }
+
+        /// Ticks at the start of recording.
+        u64 recordingStart()
+        {
+            return mRecordStartTicks;
+        }
+
+        /**
+         * Get number of ticks per microsecond, measured
+         * over the duration of the recording.
+         * @return Returns the number of ticks, or 0.0,
+         *   if no time has passed.
+         */
+        f64 ticksPerMicrosecond();
+
         /**
          * Get instance of the profiling manager.
          * @return Singleton instance of the profiling manager.
@@ -614,6 +713,14 @@ namespace prof
         u64 mNumThreadExit{0};
         /// Overhead per enter/exit scope.
         f64 mScopeOverhead{0.0};
+        /// Are the scopes being recorded?
+        std::atomic<bool> mRecording{false};
+        /// Ticks and time at the start of recording.
+        u64 mRecordStartTicks{0};
+        std::chrono::steady_clock::time_point mRecordStartTime;
+        /// Ticks and time at the end of recording.
+        u64 mRecordStopTicks{0};
+        std::chrono::steady_clock::time_point mRecordStopTime;
 
 		/// Used for checking, that only one construction occurred.
 		static u64 sConstructions;
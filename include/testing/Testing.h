@@ -9,6 +9,7 @@
 
 #include "Profiler.h"
 #include "PrintCrawler.h"
+#include "TraceCrawler.h"
 #include "TestBench.h"
 
 #endif //ECS_FIT_TESTING_H
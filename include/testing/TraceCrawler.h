@@ -0,0 +1,162 @@
+/**
+ * @file testing/TraceCrawler.h
+ * @author Tomas Polasek
+ * @brief Chrome trace writer for the profiler.
+ */
+
+#ifndef TESTING_TRACECRAWLER_H
+#define TESTING_TRACECRAWLER_H
+
+#include <iomanip>
+#include <ostream>
+
+#include "testing/Profiler.h"
+
+namespace prof
+{
+    /**
+     * Writes events recorded by the profiler in the
+     * Chrome trace JSON format, which can be opened in
+     * chrome://tracing or in the Perfetto UI.
+     * Each profiled thread gets its own track.
+     */
+    class TraceCrawler : public prof::CallStackCrawler
+    {
+    public:
+        /**
+         * Create crawler writing into given stream.
+         * @param out Output stream for the trace.
+         */
+        TraceCrawler(std::ostream &out) :
+            mOut(out)
+        { }
+
+        /**
+         * Function is called by the ProfilingManager.
+         * @param root The root node of the profiling manager.
+         */
+        virtual void crawl(prof::ThreadNode *root)
+        {
+            prof::ProfilingManager &mgr = prof::ProfilingManager::instance();
+
+            ForeachWriteThread threadWriter(mOut,
+                mgr.recordingStart(), mgr.ticksPerMicrosecond());
+
+            // Timestamps are in microseconds, keep nanosecond resolution.
+            std::ios_base::fmtflags flags{mOut.flags()};
+            std::streamsize precision{mOut.precision()};
+            mOut << std::fixed << std::setprecision(3);
+
+            mOut << "{\"traceEvents\":[";
+            root->foreachnn(threadWriter);
+            mOut << "\n],\"displayTimeUnit\":\"ns\"}\n";
+            mOut.flush();
+
+            mOut.flags(flags);
+            mOut.precision(precision);
+        }
+    private:
+        /**
+         * Write given string as a JSON string.
+         * @param out Output stream.
+         * @param str The string.
+         */
+        static void writeString(std::ostream &out, const char *str)
+        {
+            out << '"';
+            for (; *str; ++str)
+            {
+                switch (*str)
+                {
+                    case '"': out << "\\\""; break;
+                    case '\\': out << "\\\\"; break;
+                    case '\n': out << "\\n"; break;
+                    case '\t': out << "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(*str) >= 0x20)
+                        {
+                            out << *str;
+                        }
+                }
+            }
+            out << '"';
+        }
+
+        class ForeachWriteThread
+        {
+        public:
+            ForeachWriteThread(std::ostream &out, u64 start, f64 ticksPerUs) :
+                mOut(out), mStart(start),
+                mUsPerTick(ticksPerUs > 0.0 ? 1.0 / ticksPerUs : 0.0)
+            { }
+
+            void operator()(prof::ThreadNode *node)
+            {
+                // Thread name is written even for threads without events.
+                separator();
+                mOut << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                     << mTid << ",\"args\":{\"name\":";
+                writeString(mOut, node->name());
+                mOut << "}}";
+
+#ifdef PROFILE_LOCK
+                node->data().lock();
+                {
+#endif
+                    for (const prof::TraceEvent &event : node->data().events())
+                    {
+                        // Unfinished scopes are left out.
+                        if (!event.end || event.begin < mStart)
+                        {
+                            continue;
+                        }
+
+                        separator();
+                        mOut << "\n{\"name\":";
+                        writeString(mOut, event.node->name());
+                        mOut << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << mTid
+                             << ",\"ts\":" << (event.begin - mStart) * mUsPerTick
+                             << ",\"dur\":" << (event.end - event.begin) * mUsPerTick
+                             << "}";
+                    }
+#ifdef PROFILE_LOCK
+                }
+                node->data().unlock();
+#endif
+
+                mTid++;
+            }
+        private:
+            /// Write separator before all events but the first.
+            void separator()
+            {
+                if (mFirst)
+                {
+                    mFirst = false;
+                }
+                else
+                {
+                    mOut << ",";
+                }
+            }
+
+            /// Output stream for the trace.
+            std::ostream &mOut;
+            /// Ticks at the start of recording.
+            u64 mStart;
+            /// Microseconds per single tick.
+            f64 mUsPerTick;
+            /// Identifier of the current thread.
+            u32 mTid{1};
+            /// Has no event been written yet?
+            bool mFirst{true};
+        protected:
+        };
+
+        /// Output stream for the trace.
+        std::ostream &mOut;
+    protected:
+    };
+}
+
+#endif //TESTING_TRACECRAWLER_H
@@ -146,6 +146,12 @@ namespace prof
 
             mNumScopeEnter++;
 
+            if (recording())
+            {
+                mThreadStatus.mThreadNode->data().beginEvent(
+                    mThreadStatus.mCurNode, Timer::getTicks());
+            }
+
             mThreadStatus.mCurNode->data().startTimer();
         }
 #ifdef PROFILE_LOCK
@@ -166,6 +172,13 @@ namespace prof
         {
             ASSERT_SLOW(mThreadStatus.mCurNode);
             mThreadStatus.mCurNode->data().stopTimer();
+
+            if (recording())
+            {
+                mThreadStatus.mThreadNode->data().endEvent(
+                    mThreadStatus.mCurNode, Timer::getTicks());
+            }
+
             mThreadStatus.mCurNode = mThreadStatus.mCurNode->parent();
             ASSERT_SLOW(mThreadStatus.mCurNode);
             retValue = mThreadStatus.mCurNode;
@@ -231,6 +244,59 @@ namespace prof
         return mThreadStatus.mCurNode;
     }
 
+    void ProfilingManager::startRecording()
+    {
+        class ForeachClear
+        {
+        public:
+            void operator()(ThreadNode *node)
+            {
+                node->data().clearEvents();
+            }
+        };
+
+        mGlobalLock.lock();
+        {
+            ForeachClear clearer;
+            mRoot->foreachnn(clearer);
+
+            mRecordStartTime = std::chrono::steady_clock::now();
+            mRecordStartTicks = Timer::getTicks();
+            mRecordStopTicks = 0;
+
+            mRecording.store(true, std::memory_order_relaxed);
+        }
+        mGlobalLock.unlock();
+    }
+
+    void ProfilingManager::stopRecording()
+    {
+        mGlobalLock.lock();
+        {
+            mRecording.store(false, std::memory_order_relaxed);
+
+            mRecordStopTime = std::chrono::steady_clock::now();
+            mRecordStopTicks = Timer::getTicks();
+        }
+        mGlobalLock.unlock();
+    }
+
+    f64 ProfilingManager::ticksPerMicrosecond()
+    {
+        u64 stopTicks{mRecordStopTicks};
+        std::chrono::steady_clock::time_point stopTime{mRecordStopTime};
+
+        if (recording() || !stopTicks)
+        {
+            stopTime = std::chrono::steady_clock::now();
+            stopTicks = Timer::getTicks();
+        }
+
+        f64 us{std::chrono::duration<f64, std::micro>(stopTime - mRecordStartTime).count()};
+
+        return us > 0.0 ? (stopTicks - mRecordStartTicks) / us : 0.0;
+    }
+
     void ProfilingManager::useCrawler(CallStackCrawler &crawler)
     {
         mGlobalLock.lock();
@@ -20,22 +20,18 @@ inline void computation(Universe::EntityT &e)
     }
 }
 
-inline void computationPar(Universe::EntityT &e)
+inline void computationPar(Universe::EntityT &e, Universe::PartitionWriterT &writer)
 {
-    PositionC *pos{e.get<PositionC>()};
+    PositionC *pos{writer.write<PositionC>(e.id())};
     MovementC *mov{e.get<MovementC>()};
 
-    PositionC tmp;
-
-    tmp.x = pos->x + mov->dX;
-    tmp.y = pos->y + mov->dY;
+    pos->x += mov->dX;
+    pos->y += mov->dY;
     for (u64 iii = 0; iii < TASK_HARDNESS; ++iii)
     {
-        tmp.x += cos(tmp.x + mov->dX);
-        tmp.y += sin(tmp.y + mov->dY);
+        pos->x += cos(pos->x + mov->dX);
+        pos->y += sin(pos->y + mov->dY);
     }
-
-    e.addD<PositionC>(tmp);
 }
 
 void createEntities(int argc, char *argv[])
@@ -573,31 +569,29 @@ void parallelChangeset(int argc, char *argv[])
                 for (u64 iii = 1; iii < threads; ++iii)
                 {
 #ifdef USE_THREAD_POOL
-                    tp.addJob(new ThreadPool::Job([iii, &parForeach, &u] () {
-                        auto foreach = parForeach.forThread(iii);
-                        for (auto &e : foreach)
+                    tp.addJob(new ThreadPool::Job([iii, &parForeach] () {
+                        auto writer = parForeach.writerForThread(iii);
+                        for (auto &e : writer)
                         {
-                            computationPar(e);
+                            computationPar(e, writer);
                         }
-                        u.commitChangeSet();
                     }));
 #else
-                    threadList.emplace_back([iii, &parForeach, &u] () {
-                        auto foreach = parForeach.forThread(iii);
-                        for (auto &e : foreach)
+                    threadList.emplace_back([iii, &parForeach] () {
+                        auto writer = parForeach.writerForThread(iii);
+                        for (auto &e : writer)
                         {
-                            computationPar(e);
+                            computationPar(e, writer);
                         }
-                        u.commitChangeSet();
                     });
 #endif
                 }
 
-                for (auto &e : parForeach.forThread(0))
+                auto writer = parForeach.writerForThread(0);
+                for (auto &e : writer)
                 {
-                    computationPar(e);
+                    computationPar(e, writer);
                 }
-                u.commitChangeSet();
 
 #ifdef USE_THREAD_POOL
                 tp.waitUntilAllFinished();
@@ -612,11 +606,11 @@ void parallelChangeset(int argc, char *argv[])
             }
             else
             {
-                for (auto &e : ms->foreach())
+                auto writer = ms->foreachP(1u).writerForThread(0);
+                for (auto &e : writer)
                 {
-                    computationPar(e);
+                    computationPar(e, writer);
                 }
-                u.commitChangeSet();
             }
         }
 
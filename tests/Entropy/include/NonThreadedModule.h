@@ -0,0 +1,24 @@
+/**
+ * @file test/NonThreadedModule.h
+ * @author Tomas Polasek
+ * @brief Testing Universe without threaded changes.
+ */
+
+#ifndef Tests_NONTHREADEDMODULE_H
+#define Tests_NONTHREADEDMODULE_H
+
+#include <iostream>
+
+#include "testing/Testing.h"
+
+// Entropy.h is not used, it enables ENT_THREADED_CHANGES.
+#ifdef ENT_THREADED_CHANGES
+#   error "NonThreadedModule has to be compiled without ENT_THREADED_CHANGES!"
+#endif
+#include "Entropy/Universe.h"
+
+class NonThreadedUniverse : public ent::Universe<NonThreadedUniverse>
+{
+};
+
+#endif //Tests_NONTHREADEDMODULE_H
@@ -32,4 +32,32 @@ class RealUniverse3 : public ent::Universe<RealUniverse3>
 {
 };
 
+class RealUniverse4 : public ent::Universe<RealUniverse4>
+{
+public:
+    using Universe::Universe;
+};
+
+/**
+ * Register given Components, initialize the Universe and add
+ * given System to it.
+ * @tparam SystemT Type of the System.
+ * @tparam ComponentTs Types of the Components.
+ * @tparam UniverseT Type of the Universe.
+ * @param uni The Universe, before its initialization.
+ * @return Returns ptr to the added System.
+ */
+template <typename SystemT,
+    typename... ComponentTs,
+    typename UniverseT>
+SystemT *initUniverse(UniverseT &uni)
+{
+    using Expander = int[];
+    (void)Expander{0, (uni.template registerComponent<ComponentTs>(), 0)...};
+
+    uni.init();
+
+    return uni.template addSystem<SystemT>();
+}
+
 #endif //ECS_FIT_TESTUNIVERSE_H
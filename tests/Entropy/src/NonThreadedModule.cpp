@@ -0,0 +1,123 @@
+/**
+ * @file test/NonThreadedModule.cpp
+ * @author Tomas Polasek
+ * @brief Testing Universe without threaded changes.
+ */
+
+#include "NonThreadedModule.h"
+
+struct NonThreadedPosition
+{
+    float x;
+    float y;
+};
+
+struct NonThreadedVelocity
+{
+    float x;
+    float y;
+};
+
+struct NonThreadedMoveSystem : public NonThreadedUniverse::SystemT
+{
+    using Require = ent::Require<NonThreadedPosition, NonThreadedVelocity>;
+};
+
+TU_Begin(EntropyEntityNonThreaded)
+
+    TU_Setup
+    {
+
+    }
+
+    TU_Teardown
+    {
+
+    }
+
+    TU_Case(NonThreadedRefresh0, "Testing Group changes without threaded changes")
+    {
+        static constexpr u64 NUM_ENTITIES{1000u};
+        using Entity = NonThreadedUniverse::EntityT;
+        NonThreadedUniverse u;
+
+        u.registerComponent<NonThreadedPosition>();
+        u.registerComponent<NonThreadedVelocity>();
+
+        u.init();
+
+        NonThreadedMoveSystem *sys{u.addSystem<NonThreadedMoveSystem>()};
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<NonThreadedPosition>()->x = static_cast<float>(iii);
+            if (iii % 2u == 0u)
+            {
+                e.add<NonThreadedVelocity>()->x = 1.0f;
+            }
+            entities.push_back(e);
+        }
+        u.refresh();
+
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES / 2u);
+        TC_RequireEqual(sys->foreachAdded().size(), NUM_ENTITIES / 2u);
+        TC_RequireEqual(sys->foreachRemoved().size(), 0u);
+
+        // Nothing changed.
+        u.refresh();
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES / 2u);
+        TC_RequireEqual(sys->foreachAdded().size(), 0u);
+        TC_RequireEqual(sys->foreachRemoved().size(), 0u);
+
+        u64 removed{0u};
+        for (u64 iii = 0; iii < NUM_ENTITIES; iii += 2u)
+        {
+            Entity &e(entities[iii]);
+            switch ((iii / 2u) % 4u)
+            {
+                case 0u:
+                    e.remove<NonThreadedVelocity>();
+                    removed++;
+                    break;
+                case 1u:
+                    e.deactivate();
+                    removed++;
+                    break;
+                case 2u:
+                    e.destroy();
+                    removed++;
+                    break;
+                default:
+                    break;
+            }
+        }
+        for (u64 iii = 1u; iii < NUM_ENTITIES; iii += 4u)
+        {
+            entities[iii].add<NonThreadedVelocity>()->x = 2.0f;
+        }
+        u.refresh();
+
+        const u64 added{NUM_ENTITIES / 4u};
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES / 2u - removed + added);
+        TC_RequireEqual(sys->foreachAdded().size(), added);
+        TC_RequireEqual(sys->foreachRemoved().size(), removed);
+
+        for (auto &e : sys->foreach())
+        {
+            const u64 index{static_cast<u64>(e.get<NonThreadedPosition>()->x)};
+            TC_Require((index % 2u == 0u && (index / 2u) % 4u == 3u) || index % 4u == 1u);
+        }
+
+        // Deactivated Entities come back.
+        for (u64 iii = 2u; iii < NUM_ENTITIES; iii += 8u)
+        {
+            entities[iii].activate();
+        }
+        u.refresh();
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES / 2u - removed + added + NUM_ENTITIES / 8u);
+        TC_RequireEqual(sys->foreachAdded().size(), NUM_ENTITIES / 8u);
+        TC_RequireEqual(sys->foreachRemoved().size(), 0u);
+    }
+TU_End(EntropyEntityNonThreaded)
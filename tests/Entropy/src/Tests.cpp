@@ -297,6 +297,178 @@ struct DestructionSystem : public RealUniverse3::SystemT
 u64 DestructionSystem::sConstructed{0};
 u64 DestructionSystem::sDestructed{0};
 
+struct ListedC
+{
+    using HolderT = ent::ComponentHolderList<ListedC>;
+
+    u64 v;
+};
+
+struct ParallelSystem : public RealUniverse4::SystemT
+{
+    using Require = ent::Require<Position>;
+};
+
+struct ScheduledMoveSystem : public RealUniverse4::SystemT
+{
+    using Require = ent::Require<Position, Velocity>;
+    using Reads = ent::Reads<Velocity>;
+    using Writes = ent::Writes<Position>;
+
+    virtual void run() override
+    {
+        for (auto &e : foreach())
+        {
+            e.get<Position>()->x += e.get<Velocity>()->x;
+        }
+    }
+};
+
+struct ScheduledAccelSystem : public RealUniverse4::SystemT
+{
+    using Require = ent::Require<Velocity>;
+    using Writes = ent::Writes<Velocity>;
+
+    virtual void run() override
+    {
+        for (auto &e : foreach())
+        {
+            e.get<Velocity>()->x *= 2.0f;
+        }
+    }
+};
+
+struct ScheduledListedSystem : public RealUniverse4::SystemT
+{
+    using Require = ent::Require<ListedC>;
+    using Writes = ent::Writes<ListedC>;
+
+    virtual void run() override
+    {
+        for (auto &e : foreach())
+        {
+            e.get<ListedC>()->v++;
+        }
+    }
+};
+
+struct CopyCountedC
+{
+    CopyCountedC() = default;
+    CopyCountedC(std::vector<u64> &&d) :
+        data(std::move(d))
+    { }
+    CopyCountedC(const CopyCountedC &other) :
+        data(other.data)
+    { sCopies++; }
+    CopyCountedC(CopyCountedC &&other) = default;
+    CopyCountedC &operator=(const CopyCountedC &other)
+    { data = other.data; sCopies++; return *this; }
+    CopyCountedC &operator=(CopyCountedC &&other) = default;
+
+    std::vector<u64> data;
+
+    static u64 sCopies;
+};
+
+u64 CopyCountedC::sCopies{0};
+
+struct ForceC
+{
+    struct Add
+    {
+        void operator()(ForceC &acc, ForceC &&f) const
+        { acc.x += f.x; }
+    };
+    using MergePolicyT = ent::MergeCombine<Add>;
+
+    float x{0.0f};
+};
+
+struct OwnerC
+{
+    using MergePolicyT = ent::MergeFirstWriter;
+
+    u64 job{0u};
+};
+
+template <typename T>
+struct BatchRemovalHolder : public ent::BaseComponentHolder<T>
+{
+    virtual T* add(ent::EntityId id) noexcept override
+    { return &mMap[id]; }
+
+    virtual T* replace(ent::EntityId id, const T &comp) noexcept override
+    { return &(mMap[id] = comp); }
+
+    virtual T* get(ent::EntityId id) noexcept override
+    {
+        auto findIt = mMap.find(id);
+        return findIt == mMap.end() ? nullptr : &findIt->second;
+    }
+
+    virtual const T* get(ent::EntityId id) const noexcept override
+    { return const_cast<BatchRemovalHolder<T>*>(this)->get(id); }
+
+    virtual bool remove(ent::EntityId id) noexcept override
+    {
+        sRemoved++;
+        mMap.erase(id);
+        sSize = mMap.size();
+        return true;
+    }
+
+    virtual void removeBatch(const ent::EntityId *begin, const ent::EntityId *end) noexcept override
+    {
+        sBatches++;
+        for (const ent::EntityId *it = begin; it != end; ++it)
+        {
+            sSorted = sSorted && (it == begin || *(it - 1) < *it);
+            sRemoved += mMap.erase(*it);
+        }
+        sSize = mMap.size();
+    }
+
+    virtual void refresh() noexcept override
+    { sSize = mMap.size(); }
+
+    std::map<ent::EntityId, T> mMap;
+
+    static u64 sBatches;
+    static u64 sRemoved;
+    static u64 sSize;
+    static bool sSorted;
+};
+
+template <typename T>
+u64 BatchRemovalHolder<T>::sBatches{0u};
+template <typename T>
+u64 BatchRemovalHolder<T>::sRemoved{0u};
+template <typename T>
+u64 BatchRemovalHolder<T>::sSize{0u};
+template <typename T>
+bool BatchRemovalHolder<T>::sSorted{true};
+
+struct BatchC
+{
+    using HolderT = BatchRemovalHolder<BatchC>;
+
+    u64 v{0u};
+};
+
+struct ExclusiveSystem : public RealUniverse4::SystemT
+{
+    using Require = ent::Require<Position>;
+
+    virtual void run() override
+    {
+        for (auto &e : foreach())
+        {
+            e.get<Position>()->y = e.get<Position>()->x;
+        }
+    }
+};
+
 TU_Begin(EntropyEntity)
 
     TU_Setup
@@ -864,7 +1036,6 @@ TU_Begin(EntropyEntity)
             TC_RequireEqual(DestructionSystem::sDestructed, 1u);
 
             TC_Require(sys2->isInitialized());
-            TC_RequireEqual(sys1, sys2);
             TC_RequireEqual(sys2->foreach().size(), 0u);
 
             Entity e = u.createEntity();
@@ -888,15 +1059,2012 @@ TU_Begin(EntropyEntity)
             RealUniverse3 u;
             TC_RequireEqual(u.registerComponent<DestructionC>(), 0u);
             u.init();
-            TC_RequireEqual(u.addSystem<DestructionSystem>(), sys1);
+            TC_Require(u.addSystem<DestructionSystem>()->isInitialized());
             u.reset();
+            TC_RequireEqual(DestructionSystem::sDestructed, 3u);
             TC_RequireEqual(u.registerComponent<DestructionC>(), 0u);
             u.init();
-            TC_RequireEqual(u.addSystem<DestructionSystem>(), sys1);
+            TC_Require(u.addSystem<DestructionSystem>()->isInitialized());
             u.reset();
+            TC_RequireEqual(DestructionSystem::sDestructed, 4u);
             TC_RequireEqual(u.registerComponent<DestructionC>(), 0u);
             u.init();
-            TC_RequireEqual(u.addSystem<DestructionSystem>(), sys1);
+            TC_Require(u.addSystem<DestructionSystem>()->isInitialized());
+        }
+
+        TC_RequireEqual(DestructionSystem::sConstructed, 5u);
+        TC_RequireEqual(DestructionSystem::sDestructed, 5u);
+    }
+
+    TU_Case(RuntimeGroup0, "Testing runtime EntityGroups")
+    {
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+        ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+        std::vector<ent::CIdType> ids{posId, velId,
+            static_cast<ent::CIdType>(u.registerComponent<TestComponent<0>>()),
+            static_cast<ent::CIdType>(u.registerComponent<TestComponent<1>>()),
+            static_cast<ent::CIdType>(u.registerComponent<TestComponent<2>>())};
+
+        u.init();
+
+        for (u64 iii = 0; iii < 10u; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>();
+            if (iii % 2u)
+            {
+                e.add<Velocity>();
+            }
+        }
+
+        ent::EntityFilter f1{u.buildFilter({posId, velId}, {})};
+        ent::EntityFilter f2{u.buildFilter({velId, posId, velId}, {posId})};
+        TC_Require(f1 == f2);
+        TC_RequireEqual(f1.hash(), f2.hash());
+        TC_Require(!(f1 == u.buildFilter({posId}, {velId})));
+
+        ent::EntityGroup *grp{u.addGetGroup(f1)};
+        TC_RequireEqual(grp->foreach(&u).size(), 0u);
+
+        u.refresh();
+
+        TC_RequireEqual(grp->foreach(&u).size(), 5u);
+        TC_RequireEqual(u.addGetGroup(f2), grp);
+        TC_RequireEqual(grp->usage(), 2u);
+
+        TC_Require(!u.abandonGroup(grp));
+        TC_Require(u.abandonGroup(grp));
+        TC_Require(!u.abandonGroup(grp));
+
+        // Unused Groups are still kept up to date.
+        Entity e = u.createEntity();
+        e.add<Position>();
+        e.add<Velocity>();
+
+        u.refresh();
+
+        TC_RequireEqual(grp->foreach(&u).size(), 6u);
+        TC_RequireEqual(u.addGetGroup(f1), grp);
+        TC_RequireEqual(grp->foreachAdded(&u).size(), 1u);
+        TC_Require(u.abandonGroup(grp));
+
+        // Fill the cache, the first Group should be evicted.
+        u64 evictedId{grp->id()};
+        for (u64 mask = 1u; mask <= ent::ENT_GROUP_CACHE_SIZE; ++mask)
+        {
+            std::vector<ent::CIdType> require;
+            for (u64 bit = 0; bit < ids.size(); ++bit)
+            {
+                if (mask & (1u << bit))
+                {
+                    require.push_back(ids[bit]);
+                }
+            }
+
+            if (require.size() == 2u && require[0] == posId && require[1] == velId)
+            { // Skip the already cached filter.
+                require.push_back(ids[4]);
+            }
+
+            TC_Require(u.abandonGroup(u.addGetGroup(u.buildFilter(require, {velId}))));
+        }
+
+        u.refresh();
+
+        ent::EntityGroup *newGrp{u.addGetGroup(u.buildFilter({}, {posId}))};
+        TC_RequireEqual(newGrp->id(), evictedId);
+
+        u.refresh();
+
+        TC_RequireEqual(newGrp->foreach(&u).size(), 0u);
+    }
+
+    TU_Case(GroupHierarchy0, "Testing EntityGroups refined from parent Groups")
+    {
+        using Entity = RealUniverse4::EntityT;
+        using Mass = TestComponent<0>;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<Mass>();
+
+        u.init();
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < 30u; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>();
+            if (iii % 2u)
+            {
+                e.add<Velocity>();
+            }
+            if (iii % 3u == 0u)
+            {
+                e.add<Mass>();
+            }
+            entities.push_back(e);
+        }
+
+        ent::EntityGroup *parent{u.addGetGroup<ent::Require<Position, Velocity>, ent::Reject<>>()};
+        ent::EntityGroup *child{u.addGetGroup<ent::Require<Velocity, Mass, Position>, ent::Reject<>>()};
+        ent::EntityGroup *other{u.addGetGroup<ent::Require<Mass>, ent::Reject<Velocity>>()};
+
+        TC_RequireEqual(parent->parent(), nullptr);
+        TC_RequireEqual(child->parent(), parent);
+        TC_RequireEqual(other->parent(), nullptr);
+
+        u.refresh();
+
+        TC_RequireEqual(parent->foreach(&u).size(), 15u);
+        TC_RequireEqual(child->foreach(&u).size(), 5u);
+        TC_RequireEqual(other->foreach(&u).size(), 5u);
+
+        // Entity stays in the parent, but enters the child.
+        entities[1].add<Mass>();
+        // Entity leaves both the parent and the child.
+        entities[3].remove<Velocity>();
+        // Entity enters both the parent and the child.
+        entities[0].add<Velocity>();
+
+        u.refresh();
+
+        TC_RequireEqual(parent->foreach(&u).size(), 15u);
+        TC_RequireEqual(child->foreach(&u).size(), 6u);
+        TC_RequireEqual(child->foreachAdded(&u).size(), 2u);
+        TC_RequireEqual(child->foreachRemoved(&u).size(), 1u);
+        for (auto &e : child->foreach(&u))
+        {
+            TC_Require(e.has<Position>() && e.has<Velocity>() && e.has<Mass>());
+        }
+
+        // New child of an already populated Group.
+        ent::EntityGroup *child2{u.addGetGroup<ent::Require<Position, Velocity>, ent::Reject<Mass>>()};
+        TC_RequireEqual(child2->parent(), parent);
+
+        u.refresh();
+
+        TC_RequireEqual(child2->foreach(&u).size(), 9u);
+
+        // Removing the parent moves the children up.
+        TC_Require((u.abandonGroup<ent::Require<Position, Velocity>, ent::Reject<>>()));
+
+        u.refresh();
+
+        TC_RequireEqual(child->parent(), nullptr);
+        TC_RequireEqual(child2->parent(), nullptr);
+
+        entities[5].add<Mass>();
+        entities[9].destroy();
+
+        u.refresh();
+
+        TC_RequireEqual(child->foreach(&u).size(), 6u);
+        TC_RequireEqual(child2->foreach(&u).size(), 8u);
+    }
+
+    TU_Case(EntityChunk0, "Testing chunked iteration over EntityGroups")
+    {
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<ListedC>();
+
+        u.init();
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < 200u; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>();
+            if (iii % 50u != 7u)
+            {
+                e.add<ListedC>()->v = e.id().index();
+            }
+            entities.push_back(e);
+        }
+
+        ent::EntityGroup *grp{u.addGetGroup<ent::Require<ListedC>, ent::Reject<>>()};
+
+        u.refresh();
+
+        u64 numChunks{0u};
+        u64 numEntities{0u};
+        for (const ent::EntityChunk &chunk : grp->chunks())
+        {
+            numChunks++;
+            numEntities += chunk.size();
+
+            ListedC *comps{u.chunkComponents<ListedC>(chunk)};
+            TC_Require(comps != nullptr);
+            TC_RequireEqual(u.chunkComponents<Position>(chunk), nullptr);
+            for (u64 iii = 0; iii < chunk.size(); ++iii)
+            {
+                TC_RequireEqual(chunk[iii].index(), chunk.firstIndex() + iii);
+                TC_RequireEqual(&comps[iii], u.getComponent<ListedC>(chunk[iii]));
+                TC_RequireEqual(comps[iii].v, chunk[iii].index());
+            }
+        }
+        TC_RequireEqual(numChunks, 5u);
+        TC_RequireEqual(numEntities, 196u);
+
+        numEntities = 0u;
+        auto par{grp->foreachP(&u, 3u)};
+        for (u64 threadId = 0; threadId < 4u; ++threadId)
+        {
+            for (const ent::EntityChunk &chunk : par.chunksForThread(threadId))
+            {
+                numEntities += chunk.size();
+            }
+        }
+        TC_RequireEqual(numEntities, 196u);
+    }
+
+    TU_Case(ParallelForeach0, "Testing parallel iteration using the thread pool")
+    {
+        static constexpr u64 NUM_ENTITIES{5000u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+        u.setNumWorkers(3u);
+        TC_RequireEqual(u.threadPool().numWorkers(), 3u);
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>()->x = static_cast<float>(iii);
+        }
+
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+
+        u.refresh();
+
+        std::atomic<u64> processed{0u};
+        sys->parallelForeach([&] (Entity &e) {
+            Position *pos{e.get<Position>()};
+            pos->y = pos->x * 2.0f;
+            if (e.id().index() % 2u)
+            {
+                e.addD<Velocity>();
+            }
+            processed++;
+        }, 64u);
+
+        TC_RequireEqual(processed.load(), NUM_ENTITIES);
+
+        u.commitChangeSet();
+        u.refresh();
+
+        u64 withVelocity{0u};
+        for (auto &e : sys->foreach())
+        {
+            TC_Require(e.get<Position>()->y == e.get<Position>()->x * 2.0f);
+            if (e.has<Velocity>())
+            {
+                withVelocity++;
+            }
+        }
+        TC_RequireEqual(withVelocity, NUM_ENTITIES / 2u);
+
+        std::atomic<u64> sum{0u};
+        u.threadPool().parallelFor(0u, 1000u, 7u, [&] (u64 begin, u64 end) {
+            for (u64 iii = begin; iii < end; ++iii)
+            {
+                sum += iii;
+            }
+        });
+        TC_RequireEqual(sum.load(), 499500u);
+    }
+
+    TU_Case(SystemScheduler0, "Testing parallel execution of Systems with declared access")
+    {
+        static constexpr u64 NUM_ENTITIES{2000u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<ListedC>();
+
+        u.init();
+        u.setNumWorkers(3u);
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>()->x = 0.0f;
+            e.add<Velocity>()->x = 1.0f;
+            e.add<ListedC>()->v = 0u;
+        }
+
+        u.addSystem<ScheduledMoveSystem>();
+        u.addSystem<ScheduledAccelSystem>();
+        u.addSystem<ScheduledListedSystem>();
+        ExclusiveSystem *exclusive{u.addSystem<ExclusiveSystem>()};
+
+        u.refresh();
+
+        // Movement has to see the Velocity before acceleration.
+        u.runSystems();
+        u.runSystems();
+        u.runSystems();
+
+        u64 checked{0u};
+        for (auto &e : exclusive->foreach())
+        {
+            TC_RequireEqual(e.get<Position>()->x, 7.0f);
+            TC_RequireEqual(e.get<Position>()->y, 7.0f);
+            TC_RequireEqual(e.get<Velocity>()->x, 8.0f);
+            TC_RequireEqual(e.get<ListedC>()->v, 3u);
+            checked++;
+        }
+        TC_RequireEqual(checked, NUM_ENTITIES);
+
+        TC_Require(u.removeSystem<ScheduledAccelSystem>());
+        u.runSystems();
+
+        for (auto &e : exclusive->foreach())
+        {
+            TC_RequireEqual(e.get<Position>()->x, 15.0f);
+            TC_RequireEqual(e.get<Velocity>()->x, 8.0f);
+        }
+    }
+
+    TU_Case(ParallelApply0, "Testing parallel application of ChangeSets")
+    {
+        static constexpr u64 NUM_ENTITIES{3000u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<ListedC>();
+
+        u.init();
+        u.setNumWorkers(3u);
+
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+            entities.back().add<ListedC>()->v = iii;
+        }
+        u.refresh();
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity &e(entities[iii]);
+            e.addD<Position>()->x = static_cast<float>(iii);
+            e.addD<Velocity>()->x = 1.0f;
+            if (iii % 2u)
+            {
+                e.removeD<ListedC>();
+            }
+        }
+        u.commitChangeSet();
+        u.refresh();
+
+        u64 inGroup{0u};
+        for (auto &e : sys->foreach())
+        {
+            const u64 original{static_cast<u64>(e.get<Position>()->x)};
+            TC_RequireEqual(e.get<Velocity>()->x, 1.0f);
+            TC_Require(e.has<ListedC>() == !(original % 2u));
+            inGroup++;
+        }
+        TC_RequireEqual(inGroup, NUM_ENTITIES);
+    }
+
+    TU_Case(ChangeSetLog0, "Testing last write wins resolution of deferred actions")
+    {
+        static constexpr u64 NUM_ENTITIES{500u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+        }
+        u.refresh();
+
+        // Entities in reverse order, so the log is not sorted.
+        for (u64 iii = NUM_ENTITIES; iii > 0u; --iii)
+        {
+            Entity &e(entities[iii - 1u]);
+            e.addD<Position>()->x = 1.0f;
+            e.addD<Velocity>()->x = 1.0f;
+            e.deactivateD();
+        }
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity &e(entities[iii]);
+            // Searching through the log.
+            TC_RequireEqual(e.getD<Position>()->x, 1.0f);
+            e.addD<Position>()->x = static_cast<float>(iii);
+            if (iii % 2u)
+            {
+                e.removeD<Velocity>();
+                e.activateD();
+            }
+            if (iii % 3u == 0u)
+            {
+                u.removeTempComponent<Velocity>(e.id());
+            }
+        }
+        u.commitChangeSet();
+        u.refresh();
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity &e(entities[iii]);
+            TC_RequireEqual(e.get<Position>()->x, static_cast<float>(iii));
+            TC_RequireEqual(e.has<Velocity>(), iii % 2u == 0u && iii % 3u != 0u);
+            TC_RequireEqual(e.active(), iii % 2u == 1u);
+        }
+    }
+
+    TU_Case(ChangeSetLog1, "Testing stability of deferred Component pointers")
+    {
+        static constexpr u64 NUM_ENTITIES{300u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+
+        u.init();
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+        }
+        u.refresh();
+
+        // Pointers from the first adds are kept until the commit.
+        std::vector<Position*> kept;
+        for (u64 iii = 0; iii < 4u; ++iii)
+        {
+            kept.push_back(entities[iii].addD<Position>());
+            kept.back()->x = -1.0f;
+        }
+
+        // Many actions in reverse order, followed by searches.
+        for (u64 iii = NUM_ENTITIES; iii > 4u; --iii)
+        {
+            entities[iii - 1u].addD<Position>()->x = static_cast<float>(iii - 1u);
+        }
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            TC_Require(entities[iii].getD<Position>() != nullptr);
+        }
+        TC_Require(entities[1].getD<Position>() == kept[1]);
+
+        for (u64 iii = 0; iii < kept.size(); ++iii)
+        {
+            TC_RequireEqual(kept[iii]->x, -1.0f);
+            kept[iii]->x = static_cast<float>(iii);
+        }
+        u.commitChangeSet();
+        u.refresh();
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            TC_RequireEqual(entities[iii].get<Position>()->x, static_cast<float>(iii));
+        }
+    }
+
+    TU_Case(ChangeSetReuse0, "Testing reuse of applied ChangeSets over multiple refreshes")
+    {
+        static constexpr u64 NUM_ENTITIES{200u};
+        static constexpr u64 NUM_FRAMES{4u};
+        static constexpr u64 NEW_PER_FRAME{10u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+        u.setNumWorkers(2u);
+
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+            entities.back().add<Position>()->x = 0.0f;
+        }
+        u.refresh();
+
+        for (u64 frame = 1u; frame <= NUM_FRAMES; ++frame)
+        {
+            sys->parallelForeach([&] (Entity &e) {
+                if (e.get<Position>()->x >= 100.0f)
+                { // Created by the ChangeSet.
+                    return;
+                }
+
+                if (frame % 2u)
+                {
+                    e.addD<Velocity>()->x = static_cast<float>(frame);
+                }
+                else
+                {
+                    e.removeD<Velocity>();
+                }
+            }, 16u);
+
+            for (u64 iii = 0; iii < NEW_PER_FRAME; ++iii)
+            {
+                u.createEntityD().add<Position>()->x = 100.0f + frame;
+            }
+            u.commitChangeSet();
+            u.refresh();
+
+            u64 created{0u};
+            u64 moving{0u};
+            for (auto &e : sys->foreach())
+            {
+                if (e.get<Position>()->x >= 100.0f)
+                {
+                    TC_Require(e.get<Position>()->x <= 100.0f + frame);
+                    TC_Require(!e.has<Velocity>());
+                    created++;
+                }
+                else
+                {
+                    TC_RequireEqual(e.has<Velocity>(), frame % 2u == 1u);
+                    if (e.has<Velocity>())
+                    {
+                        TC_RequireEqual(e.get<Velocity>()->x, static_cast<float>(frame));
+                    }
+                    moving++;
+                }
+            }
+            TC_RequireEqual(created, frame * NEW_PER_FRAME);
+            TC_RequireEqual(moving, NUM_ENTITIES);
+        }
+    }
+
+    TU_Case(ConcurrentCommit0, "Testing ChangeSet commits from many short tasks")
+    {
+        static constexpr u64 NUM_ENTITIES{4000u};
+        static constexpr u64 PER_TASK{8u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+        u.setNumWorkers(3u);
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+        }
+        u.refresh();
+
+        for (u64 round = 1u; round <= 2u; ++round)
+        {
+            // Each task commits its own ChangeSet.
+            u.threadPool().parallelFor(0u, NUM_ENTITIES, PER_TASK, [&] (u64 begin, u64 end) {
+                for (u64 iii = begin; iii < end; ++iii)
+                {
+                    entities[iii].addD<Position>()->x = static_cast<float>(iii * round);
+                }
+                u.commitChangeSet();
+            });
+            u.refresh();
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                TC_RequireEqual(entities[iii].get<Position>()->x, static_cast<float>(iii * round));
+            }
+
+            // Remove the Components, so the next round adds them again.
+            for (Entity &e : entities)
+            {
+                e.removeD<Position>();
+            }
+            u.commitChangeSet();
+            u.refresh();
+        }
+    }
+
+    TU_Case(MoveApply0, "Testing move of deferred Components into the holders")
+    {
+        static constexpr u64 DATA_SIZE{1000u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<CopyCountedC>();
+
+        u.init();
+
+        Entity e1{u.createEntity()};
+        Entity e2{u.createEntity()};
+        u.refresh();
+
+        CopyCountedC::sCopies = 0u;
+
+        e1.addD<CopyCountedC>(std::vector<u64>(DATA_SIZE, 1u));
+        e2.addD<CopyCountedC>(std::vector<u64>(DATA_SIZE, 2u));
+        u.commitChangeSet();
+        u.refresh();
+
+        TC_RequireEqual(CopyCountedC::sCopies, 0u);
+        TC_RequireEqual(e1.get<CopyCountedC>()->data.size(), DATA_SIZE);
+        TC_RequireEqual(e2.get<CopyCountedC>()->data.back(), 2u);
+
+        // Existing Components are overwritten.
+        e1.addD<CopyCountedC>(std::vector<u64>(DATA_SIZE, 3u));
+        u.commitChangeSet();
+        u.refresh();
+
+        TC_RequireEqual(CopyCountedC::sCopies, 0u);
+        TC_RequireEqual(e1.get<CopyCountedC>()->data.front(), 3u);
+
+        u.replaceComponent(e2.id(), CopyCountedC(std::vector<u64>(DATA_SIZE, 4u)));
+        TC_RequireEqual(CopyCountedC::sCopies, 0u);
+        TC_RequireEqual(e2.get<CopyCountedC>()->data.front(), 4u);
+
+        const CopyCountedC copied(std::vector<u64>(DATA_SIZE, 5u));
+        u.replaceComponent(e2.id(), copied);
+        TC_RequireEqual(CopyCountedC::sCopies, 1u);
+        TC_RequireEqual(e2.get<CopyCountedC>()->data.front(), 5u);
+    }
+
+    TU_Case(ChangedEntities0, "Testing the ChangedEntities bitset")
+    {
+        ent::ChangedEntities changed;
+        TC_Require(changed.empty());
+
+        const std::vector<ent::EIdType> indices{700u, 3u, 64u, 3u, 65u, 5000u, 63u, 700u};
+        for (ent::EIdType index : indices)
+        {
+            changed.entityChanged(ent::EntityId(index, 0u));
+        }
+        changed.entityDestroyed(ent::EntityId(64u, 1u));
+
+        std::vector<ent::EIdType> result;
+        changed.forEach([&] (ent::EIdType index) {
+            result.push_back(index);
+        });
+
+        const std::vector<ent::EIdType> expected{3u, 63u, 64u, 65u, 700u, 5000u};
+        TC_RequireEqual(changed.size(), expected.size());
+        TC_Require(result == expected);
+        TC_RequireEqual(changed.destroyed().size(), 1u);
+        TC_RequireEqual(changed.destroyed()[0u], ent::EntityId(64u, 1u));
+
+        changed.clear();
+        TC_Require(changed.empty());
+        TC_RequireEqual(changed.destroyed().size(), 0u);
+
+        result.clear();
+        changed.entityChanged(ent::EntityId(128u, 0u));
+        changed.forEach([&] (ent::EIdType index) {
+            result.push_back(index);
+        });
+        TC_RequireEqual(result.size(), 1u);
+        TC_RequireEqual(result[0u], 128u);
+    }
+
+    TU_Case(ChangedMerge0, "Testing merging of the per-thread change lists")
+    {
+        static constexpr u64 NUM_ENTITIES{20000u};
+        ent::ThreadPool pool;
+        pool.start(3u);
+
+        ent::ChangedEntitiesHolder<RealUniverse4> changes;
+        ent::ChangedEntitiesHolder<RealUniverse4> otherChanges;
+
+        for (u64 round = 0u; round < 2u; ++round)
+        {
+            // Every Entity is changed by more than one task.
+            pool.parallelFor(0u, 2u * NUM_ENTITIES, 64u, [&] (u64 begin, u64 end) {
+                for (u64 iii = begin; iii < end; ++iii)
+                {
+                    changes.entityChanged(ent::EntityId(static_cast<ent::EIdType>(iii % NUM_ENTITIES + 1u), 0u));
+                }
+            });
+            otherChanges.entityChanged(ent::EntityId(NUM_ENTITIES + 1u, 0u));
+
+            ent::SortedList<ent::EntityId> &result(changes.createResultList(pool));
+            TC_RequireEqual(result.size(), NUM_ENTITIES);
+            bool sorted{true};
+            for (u64 iii = 0u; iii < result.size(); ++iii)
+            {
+                sorted = sorted && result[iii] == ent::EntityId(static_cast<ent::EIdType>(iii + 1u), 0u);
+            }
+            TC_Require(sorted);
+
+            ent::SortedList<ent::EntityId> &other(otherChanges.createResultList(pool));
+            TC_RequireEqual(other.size(), 1u);
+        }
+
+        TC_RequireEqual(changes.createResultList(pool).size(), 0u);
+    }
+
+    TU_Case(DeterministicMerge0, "Testing deterministic merge of ChangeSets")
+    {
+        static constexpr u64 NUM_ENTITIES{256u};
+        static constexpr u64 NUM_JOBS{8u};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<CopyCountedC>();
+        u.registerComponent<ForceC>();
+        u.registerComponent<OwnerC>();
+
+        u.init();
+        u.setNumWorkers(3u);
+        u.setDeterministicMerge(true);
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            entities.push_back(u.createEntity());
+        }
+        u.refresh();
+
+        for (u64 round = 0u; round < 2u; ++round)
+        {
+            // Every job writes all of the Entities, in any order.
+            u.threadPool().parallelFor(0u, NUM_JOBS, 1u, [&] (u64 begin, u64 end) {
+                for (u64 job = begin; job < end; ++job)
+                {
+                    u.setChangeSetKey(NUM_JOBS - job);
+                    for (Entity &e : entities)
+                    {
+                        e.addD<Position>()->x = static_cast<float>(job);
+                        e.addD<ForceC>()->x = 1.0f;
+                        e.addD<OwnerC>()->job = job;
+                    }
+                    u.commitChangeSet();
+                }
+            });
+            u.refresh();
+
+            // Jobs with higher index have lower key.
+            bool merged{true};
+            for (Entity &e : entities)
+            {
+                merged = merged && e.get<Position>()->x == 0.0f;
+                merged = merged && e.get<ForceC>()->x == static_cast<float>(NUM_JOBS);
+                merged = merged && e.get<OwnerC>()->job == NUM_JOBS - 1u;
+            }
+            TC_Require(merged);
+        }
+
+        // Writes of a single task are combined too.
+        for (bool deterministic : {false, true})
+        {
+            u.setDeterministicMerge(deterministic);
+            for (Entity &e : entities)
+            {
+                e.addD<ForceC>()->x = 1.0f;
+                e.addD<ForceC>()->x = 2.0f;
+            }
+            entities.back().removeD<ForceC>();
+            entities.back().addD<ForceC>()->x = 4.0f;
+            u.commitChangeSet();
+            u.refresh();
+
+            bool combined{true};
+            for (Entity &e : entities)
+            {
+                combined = combined && e.get<ForceC>()->x == (&e == &entities.back() ? 4.0f : 3.0f);
+            }
+            TC_Require(combined);
+        }
+
+        // Ranges of the parallel iteration write the same Entity.
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+        u.refresh();
+        Entity &target(entities.front());
+        const u64 firstIndex{sys->foreach().begin()->id().index()};
+        u64 lastIndex{0u};
+        for (auto &e : sys->foreach())
+        {
+            lastIndex = e.id().index();
+        }
+
+        for (u64 round = 0u; round < 4u; ++round)
+        {
+            sys->parallelForeach([&] (Entity &e) {
+                target.addD<Velocity>()->x = static_cast<float>(e.id().index());
+                target.addD<OwnerC>()->job = e.id().index();
+            }, 1u);
+            u.refresh();
+
+            TC_RequireEqual(target.get<Velocity>()->x, static_cast<float>(lastIndex));
+            TC_RequireEqual(target.get<OwnerC>()->job, firstIndex);
+        }
+    }
+
+    TU_Case(PartitionWriter0, "Testing direct writes to partitioned ranges of Entities")
+    {
+        static constexpr u64 NUM_ENTITIES{5000u};
+        static constexpr u64 NUM_THREADS{4u};
+        using Entity = RealUniverse4::EntityT;
+        using WriterT = RealUniverse4::PartitionWriterT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+        u.setNumWorkers(3u);
+
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e = u.createEntity();
+            e.add<Position>()->x = static_cast<float>(iii);
+        }
+
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+        u.refresh();
+
+        std::atomic<u64> processed{0u};
+        sys->partitionedForeach([&] (Entity &e, WriterT &writer) {
+            Position *pos{writer.write<Position>(e.id())};
+            pos->y = pos->x * 2.0f;
+            if (e.id().index() % 2u)
+            { // Structural changes are still deferred.
+                e.addD<Velocity>();
+            }
+            processed++;
+        }, 64u);
+        TC_RequireEqual(processed.load(), NUM_ENTITIES);
+
+        // Written without refresh.
+        bool written{true};
+        for (auto &e : sys->foreach())
+        {
+            written = written && e.get<Position>()->y == e.get<Position>()->x * 2.0f;
+            written = written && !e.has<Velocity>();
+        }
+        TC_Require(written);
+
+        u.commitChangeSet();
+        u.refresh();
+
+        u64 withVelocity{0u};
+        for (auto &e : sys->foreach())
+        {
+            withVelocity += e.has<Velocity>() ? 1u : 0u;
+        }
+        TC_RequireEqual(withVelocity, NUM_ENTITIES / 2u);
+
+        // Ranges of the threads are disjoint and cover all Entities.
+        auto parForeach = sys->foreachP(NUM_THREADS);
+        u64 owned{0u};
+        for (u64 threadId = 0; threadId < NUM_THREADS; ++threadId)
+        {
+            WriterT writer{parForeach.writerForThread(threadId)};
+            owned += writer.size();
+            for (auto &e : writer)
+            {
+                writer.write<Position>(e.id())->y = static_cast<float>(threadId);
+                for (u64 other = 0; other < NUM_THREADS; ++other)
+                {
+                    TC_Require(other == threadId || !parForeach.writerForThread(other).owns(e.id()));
+                }
+            }
+        }
+        TC_RequireEqual(owned, NUM_ENTITIES);
+        TC_RequireEqual(parForeach.writerForThread(NUM_THREADS).size(), 0u);
+    }
+
+    TU_Case(DestroyCascade0, "Testing batched removal of Components of destroyed Entities")
+    {
+        static constexpr u64 NUM_ENTITIES{300u};
+        static constexpr u64 NUM_DESTROYED{200u};
+        using Entity = RealUniverse4::EntityT;
+        using HolderT = BatchRemovalHolder<BatchC>;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.registerComponent<CopyCountedC>();
+        u.registerComponent<ForceC>();
+        u.registerComponent<OwnerC>();
+        u.registerComponent<BatchC>();
+
+        u.init();
+
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<BatchC>()->v = iii;
+            if (iii % 2u == 0u)
+            {
+                e.add<Position>();
+            }
+            entities.push_back(e);
+        }
+        u.refresh();
+        TC_RequireEqual(HolderT::sSize, NUM_ENTITIES);
+
+        HolderT::sBatches = 0u;
+        HolderT::sRemoved = 0u;
+
+        // Destroy in reverse order, half of them deferred.
+        for (u64 iii = NUM_DESTROYED; iii > 0u; --iii)
+        {
+            if (iii % 2u)
+            {
+                entities[iii - 1u].destroy();
+            }
+            else
+            {
+                entities[iii - 1u].destroyD();
+            }
+        }
+        u.commitChangeSet();
+        TC_RequireEqual(HolderT::sRemoved, 0u);
+        u.refresh();
+
+        TC_RequireEqual(HolderT::sBatches, 1u);
+        TC_RequireEqual(HolderT::sRemoved, NUM_DESTROYED);
+        TC_RequireEqual(HolderT::sSize, NUM_ENTITIES - NUM_DESTROYED);
+        TC_Require(HolderT::sSorted);
+        TC_RequireEqual(entities.back().get<BatchC>()->v, NUM_ENTITIES - 1u);
+
+        // Nothing left to remove.
+        u.refresh();
+        TC_RequireEqual(HolderT::sBatches, 1u);
+
+        // Reused indices start without any Components.
+        bool clean{true};
+        for (u64 iii = 0; iii < ent::ENT_MIN_FREE + NUM_DESTROYED; ++iii)
+        {
+            Entity e{u.createEntity()};
+            clean = clean && !e.has<BatchC>() && !e.has<Position>();
+        }
+        TC_Require(clean);
+    }
+
+    TU_Case(DestroyReuse0, "Testing reuse of indices of destroyed Entities")
+    {
+        static constexpr u64 NUM_ENTITIES{4u * ent::ENT_MIN_FREE};
+        using Entity = RealUniverse4::EntityT;
+        RealUniverse4 u;
+
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+
+        u.init();
+
+        ParallelSystem *sys{u.addSystem<ParallelSystem>()};
+        std::vector<Entity> entities;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<Position>()->x = static_cast<float>(iii);
+            entities.push_back(e);
+        }
+        u.refresh();
+
+        // Free indexes are used in the order of destruction.
+        std::deque<ent::EIdType> freeIndexes;
+        ent::EIdType nextIndex{NUM_ENTITIES + 1u};
+
+        for (u64 round = 0u; round < 4u; ++round)
+        {
+            const float base{1000.0f * (round + 1u)};
+
+            // Entities are destroyed in the order of their indexes.
+            for (Entity &e : entities)
+            {
+                freeIndexes.push_back(e.id().index());
+            }
+            std::vector<ent::EIdType> expected;
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                if (freeIndexes.size() >= ent::ENT_MIN_FREE)
+                {
+                    expected.push_back(freeIndexes.front());
+                    freeIndexes.pop_front();
+                }
+                else
+                {
+                    expected.push_back(nextIndex++);
+                }
+            }
+
+            // Entities destroyed and created within the same refresh.
+            if (round % 2u)
+            {
+                for (Entity &e : entities)
+                {
+                    e.destroyD();
+                }
+                for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+                {
+                    u.createEntityD().add<Position>()->x = base + iii;
+                }
+                u.commitChangeSet();
+            }
+            else
+            {
+                for (Entity &e : entities)
+                {
+                    e.destroy();
+                }
+
+                // Holders and Groups still contain the destroyed Entities.
+                std::vector<ent::EIdType> created;
+                for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+                {
+                    Entity e{u.createEntity()};
+                    e.add<Position>()->x = base + iii;
+                    created.push_back(e.id().index());
+                }
+                TC_Require(created == expected);
+            }
+            u.refresh();
+
+            bool kept{true};
+            std::vector<ent::EIdType> present;
+            entities.clear();
+            for (auto &e : sys->foreach())
+            {
+                kept = kept && e.valid() && e.get<Position>()->x >= base &&
+                       e.get<Position>()->x < base + NUM_ENTITIES;
+                present.push_back(e.id().index());
+                entities.push_back(e);
+            }
+            std::sort(expected.begin(), expected.end());
+            TC_Require(kept);
+            TC_Require(present == expected);
+        }
+    }
+
+    TU_Case(Snapshot0, "Testing binary snapshots of the Universe")
+    {
+        static constexpr u64 NUM_ENTITIES{600u};
+        using Entity = RealUniverse3::EntityT;
+        const std::string path{"Snapshot0.bin"};
+
+        std::vector<ent::EntityId> ids;
+        u64 numMembers{0u};
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId, velId}, {}))};
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{u.createEntity()};
+                e.add<Position>()->x = static_cast<float>(iii);
+                if (iii % 2u == 0u)
+                {
+                    e.add<Velocity>(static_cast<float>(iii), 1.0f);
+                }
+                ids.push_back(e.id());
+            }
+            u.refresh();
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; iii += 7u)
+            {
+                u.destroyEntity(ids[iii]);
+            }
+            u.refresh();
+
+            numMembers = grp->foreach(&u).size();
+            TC_Require(numMembers != 0u);
+            TC_Require(u.saveSnapshot(path));
+        }
+
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            TC_Require(!u.loadSnapshot(path + ".missing"));
+
+            // The same Group is active, members are loaded.
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId, velId}, {}))};
+            u.refresh();
+            TC_Require(u.loadSnapshot(path));
+            TC_RequireEqual(grp->foreach(&u).size(), numMembers);
+            TC_RequireEqual(grp->foreachAdded(&u).size(), 0u);
+
+            bool correct{true};
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{&u, ids[iii]};
+                if (iii % 7u == 0u)
+                {
+                    correct = correct && !e.valid();
+                    continue;
+                }
+
+                correct = correct && e.valid() &&
+                          e.get<Position>()->x == static_cast<float>(iii) &&
+                          e.has<Velocity>() == (iii % 2u == 0u);
+            }
+            TC_Require(correct);
+
+            // Destroyed indices are reused with a new generation.
+            Entity e{u.createEntity()};
+            TC_RequireEqual(e.id().index(), ids[0u].index());
+            TC_Require(e.id().generation() != ids[0u].generation());
+            TC_Require(!e.has<Position>());
+
+            u.refresh();
+            TC_RequireEqual(grp->foreach(&u).size(), numMembers);
+        }
+
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            // Different Group is active, members are recalculated.
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId}, {velId}))};
+            u.refresh();
+            TC_Require(u.loadSnapshot(path));
+            u64 numOdd{0u};
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                numOdd += (iii % 2u != 0u && iii % 7u != 0u) ? 1u : 0u;
+            }
+            TC_RequireEqual(grp->foreach(&u).size(), numOdd);
+            TC_RequireEqual(grp->foreachAdded(&u).size(), 0u);
+        }
+
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId, velId}, {}))};
+            Entity e{u.createEntity()};
+            e.add<Position>()->x = 42.0f;
+            e.add<Velocity>();
+            u.refresh();
+
+            // Components of the last holder are cut short.
+            const std::string damagedPath{path + ".damaged"};
+            std::vector<char> data;
+            std::FILE *file{std::fopen(path.c_str(), "rb")};
+            TC_Require(file);
+            std::fseek(file, 0, SEEK_END);
+            data.resize(static_cast<u64>(std::ftell(file)));
+            std::fseek(file, 0, SEEK_SET);
+            TC_RequireEqual(std::fread(data.data(), 1u, data.size(), file), data.size());
+            std::fclose(file);
+            file = std::fopen(damagedPath.c_str(), "wb");
+            TC_Require(file);
+            std::fwrite(data.data(), 1u, data.size() - sizeof(Velocity), file);
+            std::fclose(file);
+
+            // Failed load leaves the Universe untouched.
+            TC_Require(!u.loadSnapshot(damagedPath));
+            TC_Require(e.valid());
+            TC_RequireEqual(e.get<Position>()->x, 42.0f);
+            TC_Require(e.has<Velocity>());
+            TC_RequireEqual(grp->foreach(&u).size(), 1u);
+
+            std::remove(damagedPath.c_str());
+        }
+
+        std::remove(path.c_str());
+    }
+
+    TU_Case(DeltaSnapshot0, "Testing recording and replaying of delta snapshots")
+    {
+        static constexpr u64 NUM_ENTITIES{300u};
+        static constexpr u64 NUM_NEW{40u};
+        using Entity = RealUniverse3::EntityT;
+        const std::string snapshotPath{"DeltaSnapshot0.bin"};
+        const std::string deltaPath{"DeltaSnapshot0.delta"};
+
+        struct Expected
+        {
+            ent::EntityId id;
+            bool valid;
+            bool active;
+            Position pos;
+            bool hasVel;
+            Velocity vel;
+        };
+
+        std::vector<ent::EntityId> ids;
+        std::vector<Expected> expected;
+        ent::EntityId nextId;
+        u64 numMembers{0u};
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId, velId}, {}))};
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{u.createEntity()};
+                e.add<Position>()->x = static_cast<float>(iii);
+                if (iii % 2u == 0u)
+                {
+                    e.add<Velocity>(static_cast<float>(iii), 1.0f);
+                }
+                ids.push_back(e.id());
+            }
+            u.refresh();
+
+            TC_Require(u.saveSnapshot(snapshotPath));
+            TC_Require(u.startDeltaRecording(deltaPath));
+            TC_Require(u.recordingDeltas());
+
+            // Frame 1: in-place writes, replaced and added Components.
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{&u, ids[iii]};
+                if (iii % 5u == 0u)
+                {
+                    e.get<Position>()->y = 5.0f;
+                    u.markWritten(e.id());
+                }
+                else if (iii % 5u == 1u)
+                {
+                    u.replaceComponent<Position>(e.id(), Position{static_cast<float>(iii), 7.0f});
+                }
+                if (iii % 3u == 0u && !e.has<Velocity>())
+                {
+                    e.add<Velocity>(0.0f, 3.0f);
+                }
+            }
+            u.refresh();
+
+            // Frame 2: destroyed Entities, removed Components and ChangeSet writes.
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{&u, ids[iii]};
+                if (iii % 7u == 0u)
+                {
+                    e.destroy();
+                    continue;
+                }
+                if (iii % 4u == 0u)
+                {
+                    e.remove<Velocity>();
+                }
+                if (iii % 11u == 0u)
+                {
+                    e.addD<Velocity>(static_cast<float>(iii), 11.0f);
+                }
+            }
+            u.deactivateEntity(ids[1u]);
+            u.commitChangeSet();
+            u.refresh();
+
+            // Frame 3: destroyed indices are reused.
+            for (u64 iii = 0; iii < NUM_NEW; ++iii)
+            {
+                Entity e{u.createEntity()};
+                e.add<Position>(Position{1000.0f + iii, 0.0f});
+                e.add<Velocity>(1.0f, 1.0f);
+                ids.push_back(e.id());
+            }
+            u.refresh();
+
+            TC_Require(u.stopDeltaRecording());
+            TC_Require(!u.recordingDeltas());
+
+            for (ent::EntityId id : ids)
+            {
+                Entity e{&u, id};
+                Expected exp{id, e.valid(), u.entityActive(id), {}, false, {}};
+                if (exp.valid)
+                {
+                    exp.pos = *e.get<Position>();
+                    exp.hasVel = e.has<Velocity>();
+                    exp.vel = exp.hasVel ? *e.get<Velocity>() : Velocity{};
+                }
+                expected.push_back(exp);
+            }
+            numMembers = grp->foreach(&u).size();
+            nextId = u.createEntity().id();
+        }
+
+        {
+            RealUniverse3 u;
+            ent::CIdType posId{static_cast<ent::CIdType>(u.registerComponent<Position>())};
+            ent::CIdType velId{static_cast<ent::CIdType>(u.registerComponent<Velocity>())};
+            u.init();
+
+            ent::EntityGroup *grp{u.addGetGroup(u.buildFilter({posId, velId}, {}))};
+            u.refresh();
+            TC_Require(u.loadSnapshot(snapshotPath));
+            TC_RequireEqual(u.replayDeltas(deltaPath), 3u);
+            TC_RequireEqual(u.replayDeltas(deltaPath + ".missing"), 0u);
+
+            bool correct{true};
+            for (const Expected &exp : expected)
+            {
+                Entity e{&u, exp.id};
+                correct = correct && e.valid() == exp.valid;
+                if (!exp.valid)
+                {
+                    continue;
+                }
+
+                correct = correct && u.entityActive(exp.id) == exp.active &&
+                          e.get<Position>()->x == exp.pos.x &&
+                          e.get<Position>()->y == exp.pos.y &&
+                          e.has<Velocity>() == exp.hasVel &&
+                          (!exp.hasVel || (e.get<Velocity>()->x == exp.vel.x &&
+                                           e.get<Velocity>()->y == exp.vel.y));
+            }
+            TC_Require(correct);
+            TC_RequireEqual(grp->foreach(&u).size(), numMembers);
+
+            ent::EntityId id{u.createEntity().id()};
+            TC_RequireEqual(id.index(), nextId.index());
+            TC_RequireEqual(id.generation(), nextId.generation());
+        }
+
+        std::remove(snapshotPath.c_str());
+        std::remove(deltaPath.c_str());
+    }
+
+    TU_Case(ComponentView0, "Testing versioned read-only views of Components")
+    {
+        static constexpr u64 NUM_ENTITIES{1000u};
+        static constexpr u64 NUM_FRAMES{200u};
+        using Entity = RealUniverse3::EntityT;
+
+        RealUniverse3 u;
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.init();
+
+        std::vector<ent::EntityId> ids;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<Position>(Position{static_cast<float>(iii), 0.0f});
+            ids.push_back(e.id());
+        }
+        u.refresh();
+
+        ent::ComponentView<Position> &view(u.componentView<Position>());
+        TC_Require(&view == &u.componentView<Position>());
+        TC_Require(!view.acquire().valid());
+
+        // View is filled with all of the existing Entities.
+        u.refresh();
+        TC_RequireEqual(view.version(), 1u);
+        {
+            ent::ComponentView<Position>::Reader r{view.acquire()};
+            u64 numViewed{0u};
+            bool correct{true};
+            r.foreach([&] (ent::EntityId id, const Position &pos) {
+                correct = correct && pos.x == static_cast<float>(id.index() - ids[0u].index());
+                numViewed++;
+            });
+            TC_Require(correct);
+            TC_RequireEqual(numViewed, NUM_ENTITIES);
+        }
+
+        // Refresh without changes does not publish a new version.
+        u.refresh();
+        TC_RequireEqual(view.version(), 1u);
+
+        {
+            ent::ComponentView<Position>::Reader r1{view.acquire()};
+
+            Entity(&u, ids[1u]).get<Position>()->y = 1.0f;
+            u.markWritten(ids[1u]);
+            u.replaceComponent<Position>(ids[2u], Position{0.0f, 2.0f});
+            u.destroyEntity(ids[3u]);
+            u.refresh();
+            TC_RequireEqual(view.version(), 2u);
+
+            // Pinned version is not changed.
+            TC_RequireEqual(r1.version(), 1u);
+            TC_RequireEqual(r1.get(ids[1u])->y, 0.0f);
+            TC_RequireEqual(r1.get(ids[2u])->x, 2.0f);
+            TC_Require(r1.get(ids[3u]) != nullptr);
+
+            ent::ComponentView<Position>::Reader r2{view.acquire()};
+            TC_RequireEqual(r2.get(ids[1u])->y, 1.0f);
+            TC_RequireEqual(r2.get(ids[2u])->y, 2.0f);
+            TC_Require(r2.get(ids[3u]) == nullptr);
+            TC_RequireEqual(r2.get(ids[4u])->x, 4.0f);
+
+            // Third version is free, fourth has to wait for readers.
+            u.replaceComponent<Position>(ids[4u], Position{0.0f, 3.0f});
+            u.refresh();
+            TC_RequireEqual(view.version(), 3u);
+            u.replaceComponent<Position>(ids[4u], Position{0.0f, 4.0f});
+            u.refresh();
+            TC_RequireEqual(view.version(), 3u);
+        }
+        u.refresh();
+        TC_RequireEqual(view.version(), 4u);
+        TC_RequireEqual(view.acquire().get(ids[4u])->y, 4.0f);
+
+        // Concurrent reader always sees a consistent version.
+        const u64 lastVersion{view.version()};
+        std::atomic<bool> running{true};
+        std::atomic<bool> consistent{true};
+        std::thread reader([&] () {
+            while (running)
+            {
+                ent::ComponentView<Position>::Reader r{view.acquire()};
+                if (r.version() == lastVersion)
+                { // Version from before the frames is not uniform.
+                    continue;
+                }
+                const float expected{r.get(ids[0u])->y};
+                r.foreach([&] (ent::EntityId, const Position &pos) {
+                    if (pos.y != expected)
+                    {
+                        consistent = false;
+                    }
+                });
+            }
+        });
+
+        for (u64 frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            for (ent::EntityId id : ids)
+            {
+                Position *pos{Entity(&u, id).get<Position>()};
+                if (pos)
+                {
+                    pos->y = static_cast<float>(frame);
+                    u.markWritten(id);
+                }
+            }
+            u.refresh();
+        }
+
+        running = false;
+        reader.join();
+        TC_Require(consistent);
+        TC_RequireEqual(view.acquire().get(ids[0u])->y, static_cast<float>(NUM_FRAMES - 1u));
+
+        // Writes through the partitioned writers are published too.
+        {
+            using WriterT = RealUniverse4::PartitionWriterT;
+            RealUniverse4 pu;
+            pu.registerComponent<Position>();
+            pu.init();
+            pu.setNumWorkers(3u);
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                pu.createEntity().add<Position>(Position{static_cast<float>(iii), 0.0f});
+            }
+            ParallelSystem *sys{pu.addSystem<ParallelSystem>()};
+            pu.refresh();
+
+            ent::ComponentView<Position> &partView(pu.componentView<Position>());
+            pu.refresh();
+            TC_RequireEqual(partView.version(), 1u);
+
+            sys->partitionedForeach([&] (RealUniverse4::EntityT &e, WriterT &writer) {
+                writer.write<Position>(e.id())->y = 5.0f;
+            }, 64u);
+            pu.refresh();
+            TC_RequireEqual(partView.version(), 2u);
+
+            u64 numWritten{0u};
+            partView.acquire().foreach([&] (ent::EntityId, const Position &pos) {
+                numWritten += pos.y == 5.0f ? 1u : 0u;
+            });
+            TC_RequireEqual(numWritten, NUM_ENTITIES);
+        }
+    }
+
+    TU_Case(Clone0, "Testing cloning of the Universe")
+    {
+        static constexpr u64 NUM_ENTITIES{500u};
+        using Entity = RealUniverse4::EntityT;
+
+        // Instances of the same Universe type do not share Systems and Groups.
+        RealUniverse4 u;
+        RealUniverse4 clone;
+        ScheduledMoveSystem *sys{initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u)};
+        ScheduledMoveSystem *cloneSys{initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(clone)};
+        TC_Require(sys != cloneSys);
+        TC_RequireEqual(u.getSystem<ScheduledMoveSystem>(), sys);
+        TC_RequireEqual(clone.getSystem<ScheduledMoveSystem>(), cloneSys);
+
+        std::vector<ent::EntityId> ids;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<Position>()->x = 0.0f;
+            e.add<ListedC>()->v = iii;
+            if (iii % 2u == 0u)
+            {
+                e.add<Velocity>()->x = 1.0f;
+            }
+            ids.push_back(e.id());
+        }
+        u.refresh();
+        for (u64 iii = 0; iii < NUM_ENTITIES; iii += 5u)
+        {
+            u.destroyEntity(ids[iii]);
+        }
+        u.refresh();
+        clone.refresh();
+
+        const u64 numMoving{sys->foreach().size()};
+        TC_Require(numMoving != 0u);
+        TC_RequireEqual(cloneSys->foreach().size(), 0u);
+
+        TC_Require(clone.cloneFrom(u));
+        TC_RequireEqual(cloneSys->foreach().size(), numMoving);
+        TC_RequireEqual(cloneSys->foreachAdded().size(), 0u);
+
+        // Simulate the clone, the original stays the same.
+        clone.runSystems();
+        clone.runSystems();
+        clone.refresh();
+
+        bool correct{true};
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{&u, ids[iii]};
+            Entity c{&clone, ids[iii]};
+            if (iii % 5u == 0u)
+            {
+                correct = correct && !e.valid() && !c.valid();
+                continue;
+            }
+
+            const float moved{iii % 2u == 0u ? 2.0f : 0.0f};
+            correct = correct && e.valid() && c.valid() &&
+                      e.get<Position>()->x == 0.0f &&
+                      c.get<Position>()->x == moved &&
+                      c.get<ListedC>()->v == iii &&
+                      c.has<Velocity>() == (iii % 2u == 0u);
+        }
+        TC_Require(correct);
+
+        // Changes of the clone do not affect the original.
+        Entity created{clone.createEntity()};
+        TC_RequireEqual(created.id().index(), ids[0u].index());
+        created.add<Position>();
+        created.add<Velocity>();
+        clone.refresh();
+        TC_RequireEqual(cloneSys->foreach().size(), numMoving + 1u);
+        TC_RequireEqual(sys->foreach().size(), numMoving);
+        TC_Require(!Entity(&u, created.id()).valid());
+
+        // Rollback to the original state.
+        TC_Require(clone.cloneFrom(u));
+        clone.refresh();
+        TC_RequireEqual(cloneSys->foreach().size(), numMoving);
+        for (auto &e : cloneSys->foreach())
+        {
+            correct = correct && e.get<Position>()->x == 0.0f;
+        }
+        TC_Require(correct);
+
+        // Removed System does not affect the other instance.
+        TC_Require(clone.removeSystem<ScheduledMoveSystem>());
+        TC_Require(clone.getSystem<ScheduledMoveSystem>() == nullptr);
+        TC_RequireEqual(u.getSystem<ScheduledMoveSystem>(), sys);
+    }
+
+    TU_Case(ShardedUniverses0, "Testing multiple Universes of the same type on multiple threads")
+    {
+        static constexpr u64 NUM_SHARDS{4u};
+        static constexpr u64 NUM_ENTITIES{1000u};
+        static constexpr u64 NUM_FRAMES{20u};
+        using Entity = RealUniverse4::EntityT;
+
+        // Deferred actions of a single thread do not mix between instances.
+        {
+            RealUniverse4 u1;
+            RealUniverse4 u2;
+            initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u1);
+            initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u2);
+
+            Entity e1{u1.createEntity()};
+            Entity e2{u2.createEntity()};
+            e1.addD<Position>()->x = 1.0f;
+            e2.addD<Velocity>()->x = 2.0f;
+            u1.commitChangeSet();
+            u2.commitChangeSet();
+            u1.refresh();
+            u2.refresh();
+
+            TC_RequireEqual(u1.getSystem<ScheduledMoveSystem>()->foreach().size(), 0u);
+            TC_RequireEqual(u2.getSystem<ScheduledMoveSystem>()->foreach().size(), 0u);
+            Entity r1{&u1, e1.id()};
+            Entity r2{&u2, e2.id()};
+            TC_Require(r1.has<Position>() && !r1.has<Velocity>());
+            TC_Require(r2.has<Velocity>() && !r2.has<Position>());
+            TC_RequireEqual(r1.get<Position>()->x, 1.0f);
+            TC_RequireEqual(r2.get<Velocity>()->x, 2.0f);
+        }
+
+        // Each shard is simulated by its own thread.
+        bool results[NUM_SHARDS]{};
+        std::vector<std::thread> threads;
+        for (u64 shard = 0; shard < NUM_SHARDS; ++shard)
+        {
+            threads.emplace_back([&, shard] () {
+                RealUniverse4 u;
+                ScheduledMoveSystem *sys{initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u)};
+                const float speed{static_cast<float>(shard + 1u)};
+
+                for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+                {
+                    auto e(u.createEntityD());
+                    e.add<Position>()->x = 0.0f;
+                    e.add<ListedC>()->v = shard;
+                    if (iii % 2u == 0u)
+                    {
+                        e.add<Velocity>()->x = speed;
+                    }
+                }
+                u.commitChangeSet();
+                u.refresh();
+
+                for (u64 frame = 0; frame < NUM_FRAMES; ++frame)
+                {
+                    u.runSystems();
+                    u.refresh();
+                }
+
+                bool correct{sys->foreach().size() == NUM_ENTITIES / 2u};
+                for (auto &e : sys->foreach())
+                {
+                    correct = correct &&
+                              e.get<Position>()->x == speed * NUM_FRAMES &&
+                              e.get<ListedC>()->v == shard;
+                }
+                results[shard] = correct;
+            });
+        }
+
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+
+        for (u64 shard = 0; shard < NUM_SHARDS; ++shard)
+        {
+            TC_Require(results[shard]);
+        }
+    }
+
+    TU_Case(Allocators0, "Testing memory resources used by the Universe")
+    {
+        static constexpr u64 NUM_ENTITIES{4000u};
+        using Entity = RealUniverse4::EntityT;
+
+        // Nothing should be allocated from the resource of the creating thread.
+        ent::TrackingMemoryResource outside;
+        ent::MemoryScope outsideScope(&outside);
+
+        auto simulate = [] (RealUniverse4 &u) {
+            ScheduledMoveSystem *sys{initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u)};
+
+            for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+            {
+                Entity e{u.createEntity()};
+                e.add<Position>()->x = 0.0f;
+                e.add<ListedC>()->v = iii;
+                if (iii % 2u == 0u)
+                {
+                    e.addD<Velocity>()->x = 1.0f;
+                }
+            }
+            u.commitChangeSet();
+            u.refresh();
+            u.runSystems();
+            u.refresh();
+
+            return sys->foreach().size();
+        };
+
+        {
+            ent::PoolMemoryResource pool;
+            ent::TrackingMemoryResource tracking(&pool);
+            {
+                RealUniverse4 u(&tracking);
+                TC_RequireEqual(u.memoryResource(), &tracking);
+                TC_RequireEqual(simulate(u), NUM_ENTITIES / 2u);
+                TC_Require(tracking.allocations() != 0u);
+                TC_Require(tracking.bytesInUse() != 0u);
+                TC_Require(tracking.peakBytes() >= tracking.bytesInUse());
+                TC_Require(pool.reserved() != 0u);
+            }
+            // Everything has been returned to the same resource.
+            TC_RequireEqual(tracking.bytesInUse(), 0u);
+            TC_RequireEqual(tracking.allocations(), tracking.deallocations());
+        }
+
+        {
+            ent::ArenaMemoryResource arena;
+            {
+                RealUniverse4 u(&arena);
+                TC_RequireEqual(simulate(u), NUM_ENTITIES / 2u);
+                TC_Require(arena.used() != 0u);
+                TC_Require(arena.reserved() >= arena.used());
+            }
+            arena.release();
+            TC_RequireEqual(arena.reserved(), 0u);
+        }
+
+        {
+            ent::TrackingMemoryResource tracking;
+            ent::HugePageMemoryResource hugePages(16u * 1024u, &tracking);
+            {
+                RealUniverse4 u(&hugePages);
+                TC_RequireEqual(simulate(u), NUM_ENTITIES / 2u);
+                // Large holders are mapped directly.
+                TC_Require(hugePages.mapped() != 0u);
+                TC_Require(tracking.allocations() != 0u);
+            }
+            TC_RequireEqual(hugePages.mapped(), 0u);
+            TC_RequireEqual(tracking.bytesInUse(), 0u);
+        }
+
+        TC_RequireEqual(outside.allocations(), 0u);
+    }
+
+    TU_Case(FrameArena0, "Testing per-refresh frame arena")
+    {
+        static constexpr u64 NUM_ENTITIES{4000u};
+        static constexpr u64 NUM_FRAMES{16u};
+        using Entity = RealUniverse4::EntityT;
+
+        {
+            ent::FrameArena arena;
+            u64 *previous{nullptr};
+            for (u64 frame = 0; frame < NUM_FRAMES; ++frame)
+            {
+                arena.nextFrame();
+                // Data of the previous frame are still valid.
+                if (previous)
+                {
+                    TC_RequireEqual(*previous, frame - 1u);
+                }
+                previous = static_cast<u64*>(arena.resource()->allocate(sizeof(u64) * 1000u, alignof(u64)));
+                *previous = frame;
+                TC_RequireEqual(arena.used(), sizeof(u64) * 1000u);
+            }
+            TC_RequireEqual(arena.reserved(), 2u * ent::ENT_ARENA_BLOCK_SIZE);
+        }
+
+        ent::PoolMemoryResource pool;
+        ent::TrackingMemoryResource tracking(&pool);
+        RealUniverse4 u(&tracking);
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.init();
+        ScheduledMoveSystem *sys{u.addSystem<ScheduledMoveSystem>()};
+
+        std::vector<ent::EntityId> ids;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<Position>()->x = 0.0f;
+            e.add<Velocity>()->x = 1.0f;
+            ids.push_back(e.id());
+        }
+        u.refresh();
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES);
+        TC_RequireEqual(sys->foreachAdded().size(), NUM_ENTITIES);
+
+        u64 allocations{0u};
+        for (u64 frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            // Toggle activity of half of the Entities.
+            const bool activate{frame % 2u == 1u};
+            for (u64 iii = 0; iii < NUM_ENTITIES / 2u; ++iii)
+            {
+                u.setActivityEntity(ids[iii], activate);
+            }
+            u.refresh();
+            u.runSystems();
+
+            TC_RequireEqual(sys->foreach().size(), activate ? NUM_ENTITIES : NUM_ENTITIES / 2u);
+            TC_RequireEqual(sys->foreachAdded().size(), activate ? NUM_ENTITIES / 2u : 0u);
+            TC_RequireEqual(sys->foreachRemoved().size(), activate ? 0u : NUM_ENTITIES / 2u);
+
+            if (frame == NUM_FRAMES / 2u)
+            {
+                allocations = tracking.allocations();
+            }
+        }
+
+        // Transient lists are served by the frame arena after the warm-up.
+        TC_RequireEqual(tracking.allocations(), allocations);
+        TC_Require(u.frameArena().reserved() != 0u);
+        TC_Require(u.frameArena().used() != 0u);
+    }
+
+    TU_Case(MemoryReport0, "Testing Universe memory report")
+    {
+        static constexpr u64 NUM_ENTITIES{4000u};
+        using Entity = RealUniverse4::EntityT;
+
+        RealUniverse4 u;
+        ScheduledMoveSystem *sys{initUniverse<ScheduledMoveSystem, Position, Velocity, ListedC>(u)};
+        // Registering again only returns the ID.
+        const u64 posId{u.registerComponent<Position>()};
+        const u64 velId{u.registerComponent<Velocity>()};
+        const u64 listedId{u.registerComponent<ListedC>()};
+
+        std::vector<ent::EntityId> ids;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            Entity e{u.createEntity()};
+            e.add<Position>()->x = 0.0f;
+            e.add<ListedC>()->v = iii;
+            if (iii % 2u == 0u)
+            {
+                e.add<Velocity>()->x = 1.0f;
+            }
+            ids.push_back(e.id());
+        }
+        u.refresh();
+
+        // Destroy the first quarter, leaving holes in the index-addressed holder.
+        for (u64 iii = 0; iii < NUM_ENTITIES / 4u; ++iii)
+        {
+            u.destroyEntity(ids[iii]);
+        }
+        u.refresh();
+        TC_RequireEqual(sys->foreach().size(), NUM_ENTITIES * 3u / 8u);
+
+        // Changes committed since the last refresh are pending.
+        u.createEntityD().add<Position>();
+        u.commitChangeSet();
+
+        ent::MemoryReport report{u.memoryReport()};
+        TC_RequireEqual(report.components.size(), 3u);
+        TC_RequireEqual(report.components[posId].count, NUM_ENTITIES * 3u / 4u);
+        TC_RequireEqual(report.components[velId].count, NUM_ENTITIES * 3u / 8u);
+        TC_RequireEqual(report.components[listedId].count, NUM_ENTITIES * 3u / 4u);
+        for (const ent::ComponentMemoryUsage &comp : report.components)
+        {
+            TC_Require(comp.holder.live != 0u);
+            TC_Require(comp.holder.used >= comp.holder.live);
+            TC_Require(comp.holder.reserved >= comp.holder.used);
+        }
+        TC_Require(report.components[listedId].holder.fragmentation() >= 0.25);
+        TC_Require(report.components[posId].holder.fragmentation() == 0.0);
+
+        TC_Require(report.metadataColumns.live != 0u);
+        TC_Require(report.metadataColumns.reserved >= report.metadataColumns.used);
+        TC_Require(report.generations.live < report.generations.used);
+        TC_Require(report.freeList.used != 0u);
+        TC_Require(report.numGroups >= 1u);
+        TC_Require(report.groupLists.live >= sys->foreach().size() * sizeof(ent::EntityId));
+        TC_RequireEqual(report.pendingChangeSets, 1u);
+        TC_Require(report.changeSets.live != 0u);
+        TC_Require(report.frameArena.reserved != 0u);
+        TC_Require(report.total().reserved >= report.total().used);
+        TC_Require(report.total().fillRatio() <= 1.0);
+
+        u.refresh();
+        report = u.memoryReport();
+        TC_RequireEqual(report.pendingChangeSets, 0u);
+        TC_Require(report.pooledChangeSets >= 1u);
+        TC_RequireEqual(report.components[posId].count, NUM_ENTITIES * 3u / 4u + 1u);
+
+        std::stringstream ss;
+        report.print(ss);
+        TC_Require(ss.str().find("Component 2") != std::string::npos);
+    }
+
+    TU_Case(RefreshMetrics0, "Testing refresh phase metrics")
+    {
+        static constexpr u64 NUM_ENTITIES{1000u};
+
+        {
+            ent::RefreshMetrics metrics(4u);
+            TC_Require(metrics.slowest() == nullptr);
+            for (u64 iii = 0; iii < 6u; ++iii)
+            {
+                metrics.beginFrame().changedEntities = iii;
+                metrics.endPhase(ent::FrameMetrics::PHASE_ENTITIES);
+            }
+            TC_RequireEqual(metrics.size(), 4u);
+            TC_RequireEqual(metrics.capacity(), 4u);
+            TC_RequireEqual(metrics.frame(0u).frame, 6u);
+            TC_RequireEqual(metrics.frame(0u).changedEntities, 5u);
+            TC_RequireEqual(metrics.frame(3u).frame, 3u);
+            TC_Require(metrics.slowest() != nullptr);
+            metrics.clear();
+            TC_RequireEqual(metrics.size(), 0u);
+        }
+
+        RealUniverse4 u;
+        u.registerComponent<Position>();
+        u.registerComponent<Velocity>();
+        u.init();
+        ScheduledMoveSystem *sys{u.addSystem<ScheduledMoveSystem>()};
+        u.refresh();
+
+        std::vector<ent::EntityId> ids;
+        for (u64 iii = 0; iii < NUM_ENTITIES; ++iii)
+        {
+            auto e(u.createEntityD());
+            e.add<Position>();
+            e.add<Velocity>();
+            if (iii == NUM_ENTITIES / 2u)
+            {
+                u.commitChangeSet();
+            }
+        }
+        u.commitChangeSet();
+        u.refresh();
+
+        {
+            const ent::FrameMetrics &frame(u.refreshMetrics().frame(0u));
+            TC_RequireEqual(frame.changeSetsApplied, 2u);
+            TC_RequireEqual(frame.changedEntities, NUM_ENTITIES);
+            TC_RequireEqual(frame.groupAdded, NUM_ENTITIES);
+            TC_RequireEqual(frame.groupRemoved, 0u);
+            TC_Require(frame.totalTicks() != 0u);
+            TC_Require(frame.ticks[ent::FrameMetrics::PHASE_GROUP_CHECK] != 0u);
+        }
+
+        for (auto &e : sys->foreach())
+        {
+            ids.push_back(e.id());
+        }
+        for (u64 iii = 0; iii < NUM_ENTITIES / 4u; ++iii)
+        {
+            u.deactivateEntity(ids[iii]);
+        }
+        u.refresh();
+
+        {
+            const ent::FrameMetrics &frame(u.refreshMetrics().frame(0u));
+            TC_RequireEqual(frame.changeSetsApplied, 0u);
+            TC_RequireEqual(frame.changedEntities, NUM_ENTITIES / 4u);
+            TC_RequireEqual(frame.groupAdded, 0u);
+            TC_RequireEqual(frame.groupRemoved, NUM_ENTITIES / 4u);
+            TC_Require(frame.frame > u.refreshMetrics().frame(1u).frame);
         }
     }
 TU_End(EntropyEntity)
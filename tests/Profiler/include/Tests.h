@@ -7,10 +7,15 @@
 #ifndef Tests_H
 #define Tests_H
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <unordered_map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "testing/Testing.h"
-#include "util/Threading.h"
 
 #endif //Tests_H
@@ -6,79 +6,207 @@
 
 #include "Tests.h"
 
-#include <new>
-
-constexpr char *THREAD_NAMES[] = {
-    "Thread 1",
-    "Thread 2",
-    "Thread 3",
-    "Thread 4",
-    "Thread 5",
-    "Thread 6",
-    "Thread 7",
-    "Thread 8",
-    "Thread 9",
-    "Thread 10"
+/// Single event parsed from the trace.
+struct ParsedEvent
+{
+    std::string name;
+    std::string ph;
+    u64 tid{0};
+    f64 ts{0.0};
+    f64 dur{0.0};
 };
 
-namespace tst {
+/// Get value of the string field following given key, with escapes left in.
+static std::string parseString(const std::string &line, const char *key)
+{
+    std::string::size_type pos{line.find(key)};
+    if (pos == std::string::npos)
+    {
+        return "";
+    }
+
+    std::string result;
+    for (pos += std::strlen(key); pos < line.size() && line[pos] != '"'; ++pos)
+    {
+        if (line[pos] == '\\' && pos + 1 < line.size())
+        {
+            result += line[pos++];
+        }
+        result += line[pos];
+    }
+
+    return result;
+}
+
+/// Get value of the number field following given key.
+static f64 parseNumber(const std::string &line, const char *key)
+{
+    std::string::size_type pos{line.find(key)};
+    if (pos == std::string::npos)
+    {
+        return -1.0;
+    }
+
+    return std::strtod(line.c_str() + pos + std::strlen(key), nullptr);
+}
 
-    TEST_UNIT_BEG(TestingTheTest, 1)
+/// Parse events from trace written by the TraceCrawler, one event per line.
+static std::vector<ParsedEvent> parseTrace(const std::string &trace)
+{
+    std::vector<ParsedEvent> result;
+    std::istringstream in(trace);
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+        if (line.find("\"ph\":") == std::string::npos)
+        {
+            continue;
+        }
+
+        ParsedEvent event;
+        event.ph = parseString(line, "\"ph\":\"");
+        event.tid = static_cast<u64>(parseNumber(line, "\"tid\":"));
+        if (event.ph == "M")
+        {
+            event.name = parseString(line, "\"args\":{\"name\":\"");
+        }
+        else
+        {
+            event.name = parseString(line, "{\"name\":\"");
+            event.ts = parseNumber(line, "\"ts\":");
+            event.dur = parseNumber(line, "\"dur\":");
+        }
+        result.push_back(event);
+    }
+
+    return result;
+}
 
-        TEST_UNIT_SETUP_BEG
-        TEST_UNIT_SETUP_END
+TU_Begin(ProfilerTrace)
 
-        TEST_UNIT_TEARDOWN_BEG
-        TEST_UNIT_TEARDOWN_END
+    TU_Setup
+    {
 
-        TEST_UNIT_MAIN_BEG
-            PROF_BLOCK("First");
+    }
 
-            std::vector<std::thread> threads;
+    TU_Teardown
+    {
 
-            double sum{0.0};
-            thr::SpinLock lock;
+    }
 
-            for (uint64_t iii = 0; iii < 10; ++iii)
-            {
-                threads.emplace_back([&, iii] () {
-                    PROF_THREAD(THREAD_NAMES[iii]);
+    TU_Case(TraceCrawler0, "Testing the Chrome trace output")
+    {
+        static constexpr const char *THREAD_NAMES[] = {
+            "Trace thread 0",
+            "Trace thread 1"
+        };
+        static constexpr u64 NUM_THREADS{2u};
+        static constexpr u64 NUM_ROUNDS{10u};
+        // Rounding to a whole microsecond is noticeable only later in the recording.
+        static constexpr std::chrono::milliseconds DELAY{200};
+        // Start and duration are rounded separately.
+        static constexpr f64 EPSILON{0.0015};
 
-                    for (uint64_t jjj = 0; jjj < 1e5; ++jjj)
+        PROF_RECORD_START();
+        std::this_thread::sleep_for(DELAY);
+
+        std::vector<std::thread> threads;
+        for (u64 iii = 0; iii < NUM_THREADS; ++iii)
+        {
+            threads.emplace_back([iii] () {
+                PROF_THREAD(THREAD_NAMES[iii]);
+
+                for (u64 jjj = 0; jjj < NUM_ROUNDS; ++jjj)
+                {
+                    PROF_SCOPE("Outer \"quoted\"\\");
                     {
-                        PROF_BLOCK("Lock");
-                        lock.lock();
-                        {
-                            PROF_SCOPE("SecureSection");
-                            sum += 1e-6;
-                        }
-                        lock.unlock();
-                        PROF_BLOCK_END();
+                        PROF_SCOPE("Inner");
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
                     }
-                });
-            }
-
-            PROF_BLOCK("Wait_for_threads");
-            for (auto &thread : threads)
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        PROF_RECORD_STOP();
+
+        std::stringstream ss;
+        prof::TraceCrawler crawler(ss);
+        PROF_DUMP(crawler);
+        const std::string trace{ss.str()};
+
+        TC_Require(trace.find("{\"name\":\"Outer \\\"quoted\\\"\\\\\"") != std::string::npos);
+
+        std::vector<ParsedEvent> events{parseTrace(trace)};
+
+        // Track of each thread.
+        u64 tids[NUM_THREADS]{0u, 0u};
+        for (const ParsedEvent &event : events)
+        {
+            for (u64 iii = 0; iii < NUM_THREADS; ++iii)
             {
-                thread.join();
+                if (event.ph == "M" && event.name == THREAD_NAMES[iii])
+                {
+                    TC_RequireEqual(tids[iii], 0u);
+                    tids[iii] = event.tid;
+                }
             }
-            PROF_BLOCK_END();
+        }
+        TC_Require(tids[0] != 0u);
+        TC_Require(tids[1] != 0u);
+        TC_Require(tids[0] != tids[1]);
 
-            PROF_BLOCK_END();
+        for (u64 iii = 0; iii < NUM_THREADS; ++iii)
+        {
+            u64 outerCount{0u};
+            u64 innerCount{0u};
 
-            std::cout << sum << std::endl;
-        TEST_UNIT_MAIN_END
+            for (const ParsedEvent &inner : events)
+            {
+                if (inner.ph != "X" || inner.tid != tids[iii])
+                {
+                    continue;
+                }
+
+                TC_Require(inner.ts >= 0.0);
+                TC_Require(inner.dur >= 0.0);
+
+                if (inner.name != "Inner")
+                {
+                    TC_RequireEqual(inner.name, std::string("Outer \\\"quoted\\\"\\\\"));
+                    outerCount++;
+                    continue;
+                }
+
+                innerCount++;
+
+                u64 parents{0u};
+                for (const ParsedEvent &outer : events)
+                {
+                    if (outer.ph == "X" && outer.tid == tids[iii] && outer.name != "Inner" &&
+                        outer.ts <= inner.ts &&
+                        inner.ts + inner.dur <= outer.ts + outer.dur + EPSILON)
+                    {
+                        parents++;
+                    }
+                }
+                TC_RequireEqual(parents, 1u);
+            }
 
-    TEST_UNIT_END(TestingTheTest)
-}
+            TC_RequireEqual(outerCount, NUM_ROUNDS);
+            TC_RequireEqual(innerCount, NUM_ROUNDS);
+        }
+    }
+TU_End(ProfilerTrace)
 
 int main(int argc, char* argv[])
 {
-    TC_Run();
-    TC_Report();
+    TCC_Run();
+    TCC_Report();
 
-    prof::PrintCrawler pc;
-    PROF_DUMP(pc);
+    return TCC_ReturnCode;
 }
-